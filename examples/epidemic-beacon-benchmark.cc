@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <iostream>
+#include "ns3/epidemic-helper.h"
+
+using namespace ns3;
+
+/**
+ \file
+ \ingroup epidemic
+This example measures the cost of beaconing for large node counts.
+Every node gets its own SimpleNetDevice on a private channel, so the
+beacons are never received and the run time is dominated by beacon
+scheduling and transmission.  The scenario is run once with one beacon
+timer per node and once with the shared BeaconScheduler, and the number
+of simulator events and events per second of wall-clock time are printed
+for both runs.
+*/
+
+
+/// Results of one benchmark run
+struct BeaconRunResult
+{
+  uint64_t events;   ///< simulator events executed
+  int64_t wallMs;    ///< wall-clock time of Simulator::Run
+};
+
+static BeaconRunResult
+RunScenario (uint32_t nNodes, double simTime, Time beaconInterval,
+             bool shared)
+{
+  NodeContainer nodeContainer;
+  nodeContainer.Create (nNodes);
+
+  // One channel per node: beacons are sent but never received
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      devices.Add (simple.Install (nodeContainer.Get (i)));
+    }
+
+  EpidemicHelper epidemic;
+  epidemic.Set ("BeaconInterval", TimeValue (beaconInterval));
+  epidemic.Set ("SharedBeaconScheduler", BooleanValue (shared));
+
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (epidemic);
+  internet.Install (nodeContainer);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.0.0.0");
+  ipv4.Assign (devices);
+
+  Simulator::Stop (Seconds (simTime));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  BeaconRunResult result;
+  result.wallMs = clock.End ();
+  result.events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  Ipv4AddressGenerator::Reset ();
+  return result;
+}
+
+static void
+PrintResult (std::string name, BeaconRunResult result)
+{
+  double seconds = std::max<int64_t> (result.wallMs, 1) / 1000.0;
+  std::cout << name << ": " << result.events << " events in "
+            << result.wallMs << " ms, " << result.events / seconds
+            << " events/s" << std::endl;
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t nNodes = 10000;
+  double simTime = 30.0;
+  Time beaconInterval = Seconds (1);
+
+  CommandLine cmd;
+  cmd.Usage ("Beacon scheduling benchmark.  Runs N isolated nodes with "
+             "per-node beacon timers and with the shared beacon scheduler "
+             "and prints the simulator events per second of both runs.\n");
+  cmd.AddValue ("nNodes", "Number of nodes", nNodes);
+  cmd.AddValue ("simTime", "Simulated time in seconds", simTime);
+  cmd.AddValue ("beaconInterval", "Specify beaconInterval", beaconInterval);
+  cmd.Parse (argc, argv);
+
+  std::cout << "Number of nodes: " << nNodes << std::endl;
+  std::cout << "Simulated time: " << simTime << " s" << std::endl;
+  std::cout << "Beacon interval: " << beaconInterval.GetSeconds () << " s"
+            << std::endl;
+
+  PrintResult ("Per-node timers",
+               RunScenario (nNodes, simTime, beaconInterval, false));
+  PrintResult ("Shared scheduler",
+               RunScenario (nNodes, simTime, beaconInterval, true));
+  return 0;
+}
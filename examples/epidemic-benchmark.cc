@@ -52,9 +52,50 @@ is infinite in these scenarios. The ranges for the transmission are from
 10 m to 250 m while the default is set to 50 m. The expected results are shown
 in the paper Mohammed Alenazi, Yufei Cheng, Dongsheng Zhang, and James Sterbenz,
 "Epidemic Routing Protocol Implementation in ns-3", WNS32015.
+
+--forwardingMode selects how copies are handed to peers: Epidemic,
+SprayAndWait (every packet starts with a budget of sprayCopies copies that
+is halved on each handoff), Prophet (packets only go to peers with a
+higher delivery predictability) or MaxProp (packets go to every peer,
+cheapest estimated path first).  The number of forwarded packets and the
+overhead ratio, (forwarded - delivered) / delivered, are printed to compare
+the modes.  --hybrid forwards packets along a path when their destination
+is in the same connected cluster.  --compactHeader sends the epidemic
+header of every packet in the variable-length format, which matters most
+with a small --packetSize.
+
+With --networkCoding=true, each source codes its packets to the same
+destination into generations of random linear combinations instead of
+replicating them.  The number of packets sent and delivered is printed
+at the end, so that both modes can be compared on the same scenario.
 */
 
 
+/// Count a packet sent or received by an application
+static void
+CountPacket (uint64_t *packets, uint64_t *bytes, Ptr<const Packet> packet)
+{
+  (*packets)++;
+  *bytes += packet->GetSize ();
+}
+
+/// Count a packet forwarded by the IP layer
+static void
+CountForward (uint64_t *packets, const Ipv4Header &header,
+              Ptr<const Packet> packet, uint32_t interface)
+{
+  (*packets)++;
+}
+
+/// Count a packet received by a PacketSink
+static void
+CountRxPacket (uint64_t *packets, uint64_t *bytes, Ptr<const Packet> packet,
+               const Address &from)
+{
+  CountPacket (packets, bytes, packet);
+}
+
+
 int main (int argc, char *argv[])
 {
   // General parameters
@@ -76,6 +117,12 @@ int main (int argc, char *argv[])
   uint32_t queueLength = 200;
   Time queueEntryExpireTime = Seconds (1000);
   Time beaconInterval = Seconds (5);
+  bool networkCoding = false;
+  uint32_t generationSize = 8;
+  std::string forwardingMode = "Epidemic";
+  uint32_t sprayCopies = 8;
+  bool hybrid = false;
+  bool compactHeader = false;
 
 
   CommandLine cmd;
@@ -97,6 +144,18 @@ int main (int argc, char *argv[])
   cmd.AddValue ("queueEntryExpireTime", "Specify queue Entry Expire Time",
                 queueEntryExpireTime);
   cmd.AddValue ("beaconInterval", "Specify beaconInterval", beaconInterval);
+  cmd.AddValue ("networkCoding", "Send coded generations instead of "
+                "replicated packets", networkCoding);
+  cmd.AddValue ("generationSize", "Number of packets coded together",
+                generationSize);
+  cmd.AddValue ("forwardingMode", "Epidemic, SprayAndWait, Prophet or MaxProp",
+                forwardingMode);
+  cmd.AddValue ("sprayCopies", "Copy budget in Spray-and-Wait mode",
+                sprayCopies);
+  cmd.AddValue ("hybrid", "Forward along paths inside connected clusters",
+                hybrid);
+  cmd.AddValue ("compactHeader", "Send variable-length epidemic headers",
+                compactHeader);
 
   cmd.Parse (argc, argv);
 
@@ -111,6 +170,12 @@ int main (int argc, char *argv[])
     () << " s" << std::endl;
   std::cout << "Beacon interval: " << beaconInterval.GetSeconds () << " s" <<
   std::endl;
+  std::cout << "Network coding: " << (networkCoding ? "on" : "off")
+            << std::endl;
+  std::cout << "Forwarding mode: " << forwardingMode << std::endl;
+  std::cout << "Hybrid: " << (hybrid ? "on" : "off") << std::endl;
+  std::cout << "Compact header: " << (compactHeader ? "on" : "off")
+            << std::endl;
 
 
 
@@ -183,6 +248,15 @@ int main (int argc, char *argv[])
   epidemic.Set ("QueueLength", UintegerValue (queueLength));
   epidemic.Set ("QueueEntryExpireTime", TimeValue (queueEntryExpireTime));
   epidemic.Set ("BeaconInterval", TimeValue (beaconInterval));
+  epidemic.Set ("NetworkCoding", BooleanValue (networkCoding));
+  epidemic.Set ("GenerationSize", UintegerValue (generationSize));
+  epidemic.Set ("ForwardingMode", StringValue (forwardingMode));
+  epidemic.Set ("SprayCopies", UintegerValue (sprayCopies));
+  epidemic.Set ("Hybrid", BooleanValue (hybrid));
+  epidemic.Set ("CompactHeader", BooleanValue (compactHeader));
+  // Tolerate two lost beacons before a link is considered broken
+  epidemic.Set ("LinkStateTimeout",
+                TimeValue (Seconds (beaconInterval.GetSeconds () * 3)));
 
   /*
    *       Internet Stack Setup
@@ -236,9 +310,37 @@ int main (int argc, char *argv[])
 
 
 
+  uint64_t txPackets = 0;
+  uint64_t txBytes = 0;
+  uint64_t rxPackets = 0;
+  uint64_t rxBytes = 0;
+  uint64_t forwarded = 0;
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::OnOffApplication/Tx",
+                                 MakeBoundCallback (&CountPacket, &txPackets,
+                                                    &txBytes));
+  Config::ConnectWithoutContext ("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                                 MakeBoundCallback (&CountRxPacket, &rxPackets,
+                                                    &rxBytes));
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/UnicastForward",
+                                 MakeBoundCallback (&CountForward, &forwarded));
+
   Simulator::Stop (Seconds (TotalTime));
   Simulator::Run ();
   Simulator::Destroy ();
+
+  std::cout << "Sent packets: " << txPackets << std::endl;
+  std::cout << "Delivered packets: " << rxPackets << " ("
+            << (txPackets ? 100.0 * rxPackets / txPackets : 0) << " %)"
+            << std::endl;
+  std::cout << "Delivered throughput: " << rxBytes * 8 / TotalTime
+            << " bit/s" << std::endl;
+  std::cout << "Forwarded packets: " << forwarded << std::endl;
+  if (rxPackets > 0)
+    {
+      std::cout << "Overhead ratio: "
+                << (static_cast<double> (forwarded) - rxPackets) / rxPackets
+                << std::endl;
+    }
   return 0;
 }
 
@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+
+#include "ns3/core-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <iostream>
+#include <vector>
+#include "ns3/epidemic-gf256.h"
+#include "ns3/epidemic-network-coding.h"
+
+using namespace ns3;
+using namespace Epidemic;
+
+/**
+ \file
+ \ingroup epidemic
+This example measures the GF(2^8) kernels used by the network-coding mode.
+It times the multiply-add region operation with the scalar path and, if
+the processor supports it, the SIMD path, and the encoding and decoding of
+one generation of packets.  Throughputs are printed in MB/s.
+*/
+
+
+/// Print a throughput line
+static void
+PrintRate (std::string name, uint64_t bytes, int64_t wallMs)
+{
+  double seconds = std::max<int64_t> (wallMs, 1) / 1000.0;
+  std::cout << name << ": " << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+/// Time \p rounds multiply-add operations over regions of \p size bytes
+static int64_t
+TimeMulAdd (uint32_t size, uint32_t rounds)
+{
+  std::vector<uint8_t> src (size);
+  std::vector<uint8_t> dst (size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      src[i] = i * 31 + 7;
+    }
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      Gf256::MulAddRegion (&dst[0], &src[0], (r % 254) + 2, size);
+    }
+  return clock.End ();
+}
+
+/// Time the encoding and decoding of \p rounds generations
+static void
+TimeGeneration (uint32_t generationSize, uint32_t symbolSize, uint32_t rounds)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  RlncEncoder encoder (symbolSize);
+  std::vector<uint8_t> symbol (symbolSize);
+  for (uint32_t i = 0; i < generationSize; ++i)
+    {
+      for (uint32_t j = 0; j < symbolSize; ++j)
+        {
+          symbol[j] = random->GetInteger (0, 255);
+        }
+      encoder.AddSymbol (&symbol[0], symbolSize);
+    }
+  std::vector<uint8_t> coefficients (generationSize * generationSize);
+  std::vector<uint8_t> coded (generationSize * symbolSize);
+  int64_t encodeMs = 0;
+  int64_t decodeMs = 0;
+  uint64_t bytes = 0;
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      for (uint32_t i = 0; i < coefficients.size (); ++i)
+        {
+          coefficients[i] = random->GetInteger (1, 255);
+        }
+      SystemWallClockMs clock;
+      clock.Start ();
+      for (uint32_t i = 0; i < generationSize; ++i)
+        {
+          encoder.Encode (&coefficients[i * generationSize],
+                          &coded[i * symbolSize]);
+        }
+      encodeMs += clock.End ();
+      RlncDecoder decoder (generationSize, symbolSize);
+      clock.Start ();
+      for (uint32_t i = 0; i < generationSize; ++i)
+        {
+          decoder.AddSymbol (&coefficients[i * generationSize],
+                             &coded[i * symbolSize]);
+        }
+      decodeMs += clock.End ();
+      bytes += decoder.GetRank () * symbolSize;
+    }
+  PrintRate ("  encode", bytes, encodeMs);
+  PrintRate ("  decode", bytes, decodeMs);
+}
+
+
+int main (int argc, char *argv[])
+{
+  uint32_t size = 1024;
+  uint32_t rounds = 200000;
+  uint32_t generationSize = 8;
+  uint32_t generations = 2000;
+
+  CommandLine cmd;
+  cmd.Usage ("GF(2^8) kernel benchmark.  Times the region multiply-add of "
+             "the scalar and SIMD paths and the coding of generations.\n");
+  cmd.AddValue ("size", "Region and symbol size in bytes", size);
+  cmd.AddValue ("rounds", "Number of region operations", rounds);
+  cmd.AddValue ("generationSize", "Number of packets coded together",
+                generationSize);
+  cmd.AddValue ("generations", "Number of generations coded", generations);
+  cmd.Parse (argc, argv);
+
+  std::cout << "Region size: " << size << " bytes" << std::endl;
+  std::cout << "SIMD supported: "
+            << (Gf256::IsSimdSupported () ? "yes" : "no") << std::endl;
+
+  uint64_t bytes = static_cast<uint64_t> (size) * rounds;
+  uint32_t paths = Gf256::IsSimdSupported () ? 2 : 1;
+  for (uint32_t simd = 0; simd < paths; ++simd)
+    {
+      Gf256::EnableSimd (simd == 1);
+      std::string name = simd == 1 ? "SIMD" : "Scalar";
+      PrintRate (name + " multiply-add", bytes, TimeMulAdd (size, rounds));
+      std::cout << name << " generation of " << generationSize
+                << " packets:" << std::endl;
+      TimeGeneration (generationSize, size, generations);
+    }
+  return 0;
+}
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+#include "epidemic-beacon-scheduler.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::BeaconScheduler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicBeaconScheduler");
+
+namespace Epidemic {
+
+NS_OBJECT_ENSURE_REGISTERED (BeaconScheduler);
+
+Ptr<BeaconScheduler> BeaconScheduler::s_shared = 0;
+
+TypeId
+BeaconScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Epidemic::BeaconScheduler")
+    .SetParent<Object> ()
+    .AddConstructor<BeaconScheduler> ()
+    .AddAttribute ("SlotWidth","Beacons due within the same slot of this "
+                   "width are sent from a single simulator event.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&BeaconScheduler::m_slotWidth),
+                   MakeTimeChecker ());
+  return tid;
+}
+
+BeaconScheduler::BeaconScheduler ()
+  : m_slotWidth (MilliSeconds (10)),
+    m_nextHandle (1),
+    m_slotEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BeaconScheduler::~BeaconScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BeaconScheduler::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  m_entries.clear ();
+  m_slots.clear ();
+  Object::DoDispose ();
+}
+
+Ptr<BeaconScheduler>
+BeaconScheduler::Get (void)
+{
+  if (s_shared == 0)
+    {
+      s_shared = CreateObject<BeaconScheduler> ();
+      Simulator::ScheduleDestroy (&BeaconScheduler::DestroyShared);
+    }
+  return s_shared;
+}
+
+void
+BeaconScheduler::DestroyShared (void)
+{
+  if (s_shared != 0)
+    {
+      s_shared->Dispose ();
+      s_shared = 0;
+    }
+}
+
+uint32_t
+BeaconScheduler::Register (Callback<void> cb, uint32_t context)
+{
+  NS_LOG_FUNCTION (this << context);
+  Entry entry;
+  entry.cb = cb;
+  entry.context = context;
+  entry.due = Seconds (0);
+  entry.slot = 0;
+  entry.pending = false;
+  uint32_t handle = m_nextHandle++;
+  m_entries[handle] = entry;
+  return handle;
+}
+
+void
+BeaconScheduler::Unregister (uint32_t handle)
+{
+  NS_LOG_FUNCTION (this << handle);
+  m_entries.erase (handle);
+}
+
+void
+BeaconScheduler::Schedule (uint32_t handle, Time delay)
+{
+  NS_LOG_FUNCTION (this << handle << delay);
+  EntryMap::iterator entry = m_entries.find (handle);
+  NS_ASSERT_MSG (entry != m_entries.end (), "Unknown beacon handle " << handle);
+  int64_t width = std::max<int64_t> (m_slotWidth.GetTimeStep (), 1);
+  Time due = Simulator::Now () + delay;
+  // The slot starts no later than the due time of its entries
+  int64_t slot = due.GetTimeStep () / width;
+  entry->second.due = due;
+  entry->second.slot = slot;
+  entry->second.pending = true;
+
+  SlotMap::iterator bucket = m_slots.find (slot);
+  if (bucket == m_slots.end ())
+    {
+      bucket = m_slots.insert (std::make_pair (slot,
+                                               std::vector<uint32_t> ())).first;
+      // A slot that started before now fires at once
+      Time fireTime = Max (TimeStep (slot * width), Simulator::Now ());
+      Simulator::Schedule (fireTime - Simulator::Now (),
+                           &BeaconScheduler::FireSlot, this, slot);
+      m_slotEvents++;
+    }
+  bucket->second.push_back (handle);
+}
+
+void
+BeaconScheduler::Cancel (uint32_t handle)
+{
+  NS_LOG_FUNCTION (this << handle);
+  EntryMap::iterator entry = m_entries.find (handle);
+  if (entry != m_entries.end ())
+    {
+      entry->second.pending = false;
+    }
+}
+
+uint64_t
+BeaconScheduler::GetSlotEventCount () const
+{
+  return m_slotEvents;
+}
+
+void
+BeaconScheduler::FireSlot (int64_t slot)
+{
+  NS_LOG_FUNCTION (this << slot);
+  SlotMap::iterator bucket = m_slots.find (slot);
+  if (bucket == m_slots.end ())
+    {
+      return;
+    }
+  // Entries rescheduled into this slot from now on get a new bucket
+  std::vector<uint32_t> handles;
+  handles.swap (bucket->second);
+  m_slots.erase (bucket);
+  for (std::vector<uint32_t>::const_iterator i = handles.begin ();
+       i != handles.end (); ++i)
+    {
+      EntryMap::iterator entry = m_entries.find (*i);
+      if (entry == m_entries.end ()
+          || !entry->second.pending
+          || entry->second.slot != slot)
+        {
+          // Unregistered, cancelled or moved to another slot
+          continue;
+        }
+      Simulator::ScheduleWithContext (entry->second.context,
+                                      entry->second.due - Simulator::Now (),
+                                      &BeaconScheduler::Fire, this, *i,
+                                      entry->second.due);
+    }
+}
+
+void
+BeaconScheduler::Fire (uint32_t handle, Time due)
+{
+  NS_LOG_FUNCTION (this << handle << due);
+  EntryMap::iterator entry = m_entries.find (handle);
+  if (entry == m_entries.end ()
+      || !entry->second.pending
+      || entry->second.due != due)
+    {
+      // Unregistered, cancelled or rescheduled since the slot started
+      return;
+    }
+  entry->second.pending = false;
+  Callback<void> cb = entry->second.cb;
+  cb ();
+}
+
+} //end namespace epidemic
+} //end namespace ns3
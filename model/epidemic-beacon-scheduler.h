@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+#ifndef EPIDEMIC_BEACON_SCHEDULER_H
+#define EPIDEMIC_BEACON_SCHEDULER_H
+
+#include <map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::BeaconScheduler declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Shared scheduler that coalesces beacon timers of all nodes.
+ *
+ *  Every RoutingProtocol normally owns a Timer, so a network of N nodes
+ *  keeps N beacon events in the simulator queue.  When the shared
+ *  scheduler is enabled, each node registers its beacon callback here and
+ *  asks for it to be fired after its own jittered delay.  Due times are
+ *  grouped into slots of SlotWidth, and the simulator queue only holds one
+ *  event per slot until the slot starts.
+ *
+ *  When a slot starts, each of its callbacks is scheduled at its exact due
+ *  time in the context of its node, so the per-node jitter is preserved
+ *  and log prefixes show the node that sends the beacon.
+ */
+class BeaconScheduler : public Object
+{
+public:
+  /**
+   *  Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  /// c-tor
+  BeaconScheduler ();
+  /// d-tor
+  virtual ~BeaconScheduler ();
+  /**
+   * \brief Get the scheduler shared by all nodes of the simulation.
+   *  It is created on first use and released by Simulator::Destroy.
+   * \returns the shared scheduler
+   */
+  static Ptr<BeaconScheduler> Get (void);
+  /**
+   * \brief Register a beacon callback.
+   * \param cb the function invoked when the entry fires
+   * \param context the simulator context the callback runs in, usually
+   *  the ID of its node
+   * \returns the handle identifying the entry
+   */
+  uint32_t Register (Callback<void> cb, uint32_t context);
+  /**
+   * \brief Remove a registered entry, cancelling it if pending.
+   * \param handle the entry handle returned by Register
+   */
+  void Unregister (uint32_t handle);
+  /**
+   * \brief Fire an entry after \p delay.
+   *  A pending firing of the same entry is replaced.
+   * \param handle the entry handle returned by Register
+   * \param delay the delay from now
+   */
+  void Schedule (uint32_t handle, Time delay);
+  /**
+   * \brief Cancel a pending firing.
+   * \param handle the entry handle returned by Register
+   */
+  void Cancel (uint32_t handle);
+  /// \returns the number of slot events scheduled so far
+  uint64_t GetSlotEventCount () const;
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /// A registered beacon callback
+  struct Entry
+  {
+    Callback<void> cb; ///< callback to invoke
+    uint32_t context;  ///< simulator context of the callback
+    Time due;          ///< time the entry fires, valid if pending
+    int64_t slot;      ///< slot the entry is pending in, valid if pending
+    bool pending;      ///< true if the entry waits in a slot
+  };
+  /// Type to connect a handle to its entry
+  typedef std::map<uint32_t, Entry> EntryMap;
+  /// Type to connect a slot index to the handles due in it
+  typedef std::map<int64_t, std::vector<uint32_t> > SlotMap;
+  /**
+   * \brief Schedule all entries due in a slot at their due times.
+   * \param slot the slot index
+   */
+  void FireSlot (int64_t slot);
+  /**
+   * \brief Invoke an entry at its due time.
+   * \param handle the entry handle
+   * \param due the due time the entry was dispatched for
+   */
+  void Fire (uint32_t handle, Time due);
+  /// Release the shared instance, invoked by Simulator::Destroy
+  static void DestroyShared (void);
+
+  /// Width of a coalescing slot
+  Time m_slotWidth;
+  /// Registered entries
+  EntryMap m_entries;
+  /// Pending slots; handles of cancelled entries are skipped lazily
+  SlotMap m_slots;
+  /// Next handle to hand out
+  uint32_t m_nextHandle;
+  /// Number of slot events scheduled
+  uint64_t m_slotEvents;
+  /// The instance returned by Get
+  static Ptr<BeaconScheduler> s_shared;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
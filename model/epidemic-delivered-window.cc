@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+
+#include "epidemic-delivered-window.h"
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::DeliveredWindow implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicDeliveredWindow");
+
+namespace Epidemic {
+
+DeliveredWindow::DeliveredWindow (uint32_t size)
+  : m_words (0)
+{
+  SetSize (size);
+}
+
+void
+DeliveredWindow::SetSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_words = (size + 63) / 64;
+  Clear ();
+}
+
+uint32_t
+DeliveredWindow::GetSize () const
+{
+  return m_words * 64;
+}
+
+void
+DeliveredWindow::Shift (uint32_t first, uint32_t offset)
+{
+  uint32_t words = offset / 64;
+  uint32_t bits = offset % 64;
+  for (uint32_t w = m_words; w-- > 0; )
+    {
+      uint64_t value = 0;
+      if (w >= words)
+        {
+          value = m_bits[first + w - words] << bits;
+          if (bits != 0 && w > words)
+            {
+              value |= m_bits[first + w - words - 1] >> (64 - bits);
+            }
+        }
+      m_bits[first + w] = value;
+    }
+}
+
+bool
+DeliveredWindow::Record (uint32_t packetID)
+{
+  NS_LOG_FUNCTION (this << packetID);
+  if (m_words == 0)
+    {
+      return true;
+    }
+  uint16_t source = packetID >> 16;
+  uint16_t sequence = packetID & 0xFFFF;
+  std::map<uint16_t, uint32_t>::const_iterator i = m_index.find (source);
+  if (i == m_index.end ())
+    {
+      uint32_t index = m_highest.size ();
+      m_index[source] = index;
+      m_highest.push_back (sequence);
+      m_bits.resize (m_bits.size () + m_words, 0);
+      m_bits[index * m_words] = 1;
+      return true;
+    }
+  uint32_t first = i->second * m_words;
+  int16_t ahead = static_cast<int16_t> (sequence - m_highest[i->second]);
+  if (ahead > 0)
+    {
+      Shift (first, ahead);
+      m_highest[i->second] = sequence;
+      m_bits[first] |= 1;
+      return true;
+    }
+  uint32_t behind = -ahead;
+  if (behind >= GetSize ())
+    {
+      NS_LOG_LOGIC ("Packet " << packetID << " is older than the window");
+      return false;
+    }
+  uint64_t mask = uint64_t (1) << (behind % 64);
+  uint64_t &word = m_bits[first + behind / 64];
+  if (word & mask)
+    {
+      return false;
+    }
+  word |= mask;
+  return true;
+}
+
+bool
+DeliveredWindow::IsDelivered (uint32_t packetID) const
+{
+  std::map<uint16_t, uint32_t>::const_iterator i = m_index.find (packetID >> 16);
+  if (i == m_index.end ())
+    {
+      return false;
+    }
+  uint16_t sequence = packetID & 0xFFFF;
+  int16_t ahead = static_cast<int16_t> (sequence - m_highest[i->second]);
+  if (ahead > 0)
+    {
+      return false;
+    }
+  uint32_t behind = -ahead;
+  if (behind >= GetSize ())
+    {
+      return true;
+    }
+  return (m_bits[i->second * m_words + behind / 64] >> (behind % 64)) & 1;
+}
+
+uint32_t
+DeliveredWindow::GetSourceCount () const
+{
+  return m_index.size ();
+}
+
+DeliveredList
+DeliveredWindow::GetEntries (uint32_t maxSources) const
+{
+  NS_LOG_FUNCTION (this << maxSources);
+  DeliveredList entries;
+  for (std::map<uint16_t, uint32_t>::const_iterator i = m_index.begin ();
+       i != m_index.end () && entries.size () < maxSources; ++i)
+    {
+      DeliveredEntry entry;
+      entry.source = i->first;
+      entry.highest = m_highest[i->second];
+      entry.bits.assign (m_bits.begin () + i->second * m_words,
+                         m_bits.begin () + (i->second + 1) * m_words);
+      entries.push_back (entry);
+    }
+  return entries;
+}
+
+void
+DeliveredWindow::SetEntries (const DeliveredList &entries)
+{
+  NS_LOG_FUNCTION (this << entries.size ());
+  m_words = entries.empty () ? 0 : entries.front ().bits.size ();
+  Clear ();
+  for (DeliveredList::const_iterator i = entries.begin ();
+       i != entries.end (); ++i)
+    {
+      if (i->bits.size () != m_words || m_index.count (i->source))
+        {
+          continue;
+        }
+      m_index[i->source] = m_highest.size ();
+      m_highest.push_back (i->highest);
+      m_bits.insert (m_bits.end (), i->bits.begin (), i->bits.end ());
+    }
+}
+
+void
+DeliveredWindow::Clear ()
+{
+  m_index.clear ();
+  m_highest.clear ();
+  m_bits.clear ();
+}
+
+} //end namespace epidemic
+} //end namespace ns3
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+
+#ifndef EPIDEMIC_DELIVERED_WINDOW_H
+#define EPIDEMIC_DELIVERED_WINDOW_H
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include "epidemic-packet.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::DeliveredWindow declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Sliding windows of the packets delivered from each source
+ *
+ *  A packet ID is made of the 16 low bits of the source address and a
+ *  16-bit sequence number of the source.  For every source the window
+ *  keeps the highest sequence number delivered and one bit for each of
+ *  the sequence numbers below it, so a duplicate is detected without
+ *  keeping the delivered packet.  Sequence numbers are compared with
+ *  serial number arithmetic and may wrap.  A packet older than the
+ *  window is taken as a duplicate.
+ */
+class DeliveredWindow
+{
+public:
+  /**
+   * \brief Constructor for DeliveredWindow
+   * \param size the number of sequence numbers in a window
+   */
+  DeliveredWindow (uint32_t size = 0);
+  /**
+   * \brief Set the number of sequence numbers in a window.  Rounded up
+   *  to a multiple of 64, existing windows are cleared.
+   * \param size the number of sequence numbers, 0 disables the windows
+   */
+  void SetSize (uint32_t size);
+  /// \returns the number of sequence numbers in a window
+  uint32_t GetSize () const;
+  /**
+   * \brief Record the delivery of a packet.
+   * \param packetID the packet ID
+   * \returns false if the packet was already delivered or is older
+   *  than the window of its source
+   */
+  bool Record (uint32_t packetID);
+  /**
+   * \param packetID the packet ID
+   * \returns true if the packet was delivered or is older than the
+   *  window of its source
+   */
+  bool IsDelivered (uint32_t packetID) const;
+  /// \returns the number of sources with a window
+  uint32_t GetSourceCount () const;
+  /**
+   * \brief Get the windows, as advertised to the neighbors.
+   * \param maxSources the largest number of windows returned
+   * \returns the windows of the sources in ascending order
+   */
+  DeliveredList GetEntries (uint32_t maxSources) const;
+  /**
+   * \brief Replace the windows with those advertised by a neighbor.  The
+   *  size is taken from the first window, windows of another size are
+   *  ignored.
+   * \param entries the windows
+   */
+  void SetEntries (const DeliveredList &entries);
+  /// Remove all windows
+  void Clear ();
+
+private:
+  /**
+   * \brief Shift the window at \p first by \p offset sequence numbers.
+   * \param first the index of the first word of the window
+   * \param offset the number of sequence numbers
+   */
+  void Shift (uint32_t first, uint32_t offset);
+
+  /// Words of a window
+  uint32_t m_words;
+  /// Index of the window of each source
+  std::map<uint16_t, uint32_t> m_index;
+  /// Highest sequence number delivered by window index
+  std::vector<uint16_t> m_highest;
+  /// Bits of all windows, bit i is set if highest - i was delivered
+  std::vector<uint64_t> m_bits;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "epidemic-gf256.h"
+#include "ns3/assert.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EPIDEMIC_GF256_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::Gf256 implementation.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+namespace {
+
+/**
+ * \ingroup epidemic
+ * \brief Logarithm and exponential tables of GF(2^8), filled at load time
+ */
+struct Gf256Tables
+{
+  Gf256Tables ()
+  {
+    uint16_t x = 1;
+    for (uint32_t i = 0; i < 255; ++i)
+      {
+        exp[i] = x;
+        exp[i + 255] = x;
+        log[x] = i;
+        x <<= 1;
+        if (x & 0x100)
+          {
+            x ^= 0x11D;
+          }
+      }
+    log[0] = 0;
+  }
+  uint8_t exp[510];  ///< powers of the generator, doubled to skip a modulo
+  uint8_t log[256];  ///< discrete logarithms, log[0] is unused
+};
+
+/// The tables used by all operations
+const Gf256Tables g_tables;
+
+/// true if the region operations use the SSSE3 path
+bool g_simdEnabled = Gf256::IsSimdSupported ();
+
+void
+MulAddRegionScalar (uint8_t *dst, const uint8_t *src, uint8_t c,
+                    uint32_t size)
+{
+  uint8_t logC = g_tables.log[c];
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (src[i] != 0)
+        {
+          dst[i] ^= g_tables.exp[logC + g_tables.log[src[i]]];
+        }
+    }
+}
+
+void
+MulRegionScalar (uint8_t *dst, uint8_t c, uint32_t size)
+{
+  uint8_t logC = g_tables.log[c];
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (dst[i] != 0)
+        {
+          dst[i] = g_tables.exp[logC + g_tables.log[dst[i]]];
+        }
+    }
+}
+
+#ifdef EPIDEMIC_GF256_SSSE3
+/**
+ * Fill the nibble tables of \p c: low[i] = c * i and high[i] = c * (i << 4),
+ * so that c * x = low[x & 0xF] ^ high[x >> 4].
+ */
+void
+FillNibbleTables (uint8_t c, uint8_t *low, uint8_t *high)
+{
+  for (uint8_t i = 0; i < 16; ++i)
+    {
+      low[i] = Gf256::Mul (c, i);
+      high[i] = Gf256::Mul (c, i << 4);
+    }
+}
+
+__attribute__ ((target ("ssse3"))) void
+MulAddRegionSsse3 (uint8_t *dst, const uint8_t *src, uint8_t c,
+                   uint32_t size)
+{
+  uint8_t low[16], high[16];
+  FillNibbleTables (c, low, high);
+  __m128i lowTable = _mm_loadu_si128 ((const __m128i *) low);
+  __m128i highTable = _mm_loadu_si128 ((const __m128i *) high);
+  __m128i mask = _mm_set1_epi8 (0x0F);
+  uint32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((const __m128i *) (src + i));
+      __m128i lo = _mm_shuffle_epi8 (lowTable, _mm_and_si128 (x, mask));
+      __m128i hi = _mm_shuffle_epi8 (highTable,
+                                     _mm_and_si128 (_mm_srli_epi64 (x, 4),
+                                                    mask));
+      __m128i d = _mm_loadu_si128 ((const __m128i *) (dst + i));
+      d = _mm_xor_si128 (d, _mm_xor_si128 (lo, hi));
+      _mm_storeu_si128 ((__m128i *) (dst + i), d);
+    }
+  MulAddRegionScalar (dst + i, src + i, c, size - i);
+}
+
+__attribute__ ((target ("ssse3"))) void
+MulRegionSsse3 (uint8_t *dst, uint8_t c, uint32_t size)
+{
+  uint8_t low[16], high[16];
+  FillNibbleTables (c, low, high);
+  __m128i lowTable = _mm_loadu_si128 ((const __m128i *) low);
+  __m128i highTable = _mm_loadu_si128 ((const __m128i *) high);
+  __m128i mask = _mm_set1_epi8 (0x0F);
+  uint32_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m128i x = _mm_loadu_si128 ((const __m128i *) (dst + i));
+      __m128i lo = _mm_shuffle_epi8 (lowTable, _mm_and_si128 (x, mask));
+      __m128i hi = _mm_shuffle_epi8 (highTable,
+                                     _mm_and_si128 (_mm_srli_epi64 (x, 4),
+                                                    mask));
+      _mm_storeu_si128 ((__m128i *) (dst + i), _mm_xor_si128 (lo, hi));
+    }
+  MulRegionScalar (dst + i, c, size - i);
+}
+#endif
+
+} // anonymous namespace
+
+uint8_t
+Gf256::Mul (uint8_t a, uint8_t b)
+{
+  if (a == 0 || b == 0)
+    {
+      return 0;
+    }
+  return g_tables.exp[g_tables.log[a] + g_tables.log[b]];
+}
+
+uint8_t
+Gf256::Inv (uint8_t a)
+{
+  NS_ASSERT_MSG (a != 0, "Zero has no inverse");
+  return g_tables.exp[255 - g_tables.log[a]];
+}
+
+void
+Gf256::MulAddRegion (uint8_t *dst, const uint8_t *src, uint8_t c,
+                     uint32_t size)
+{
+  if (c == 0)
+    {
+      return;
+    }
+  if (c == 1)
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          dst[i] ^= src[i];
+        }
+      return;
+    }
+#ifdef EPIDEMIC_GF256_SSSE3
+  if (g_simdEnabled)
+    {
+      MulAddRegionSsse3 (dst, src, c, size);
+      return;
+    }
+#endif
+  MulAddRegionScalar (dst, src, c, size);
+}
+
+void
+Gf256::MulRegion (uint8_t *dst, uint8_t c, uint32_t size)
+{
+  if (c == 1)
+    {
+      return;
+    }
+  if (c == 0)
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          dst[i] = 0;
+        }
+      return;
+    }
+#ifdef EPIDEMIC_GF256_SSSE3
+  if (g_simdEnabled)
+    {
+      MulRegionSsse3 (dst, c, size);
+      return;
+    }
+#endif
+  MulRegionScalar (dst, c, size);
+}
+
+bool
+Gf256::IsSimdSupported ()
+{
+#ifdef EPIDEMIC_GF256_SSSE3
+  // May run before the constructors of libgcc
+  __builtin_cpu_init ();
+  return __builtin_cpu_supports ("ssse3");
+#else
+  return false;
+#endif
+}
+
+void
+Gf256::EnableSimd (bool enable)
+{
+  g_simdEnabled = enable && IsSimdSupported ();
+}
+
+bool
+Gf256::IsSimdEnabled ()
+{
+  return g_simdEnabled;
+}
+
+} //end namespace epidemic
+} //end namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#ifndef EPIDEMIC_GF256_H
+#define EPIDEMIC_GF256_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::Gf256 declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Arithmetic in GF(2^8) for random linear network coding
+ *
+ *  Elements are bytes, addition is XOR and multiplication is modulo the
+ *  polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D).  Single products use
+ *  logarithm tables.  The region operations, which dominate coding time,
+ *  have a scalar path and an SSSE3 path that multiplies 16 bytes at once
+ *  with two nibble lookup tables.  The SSSE3 path is selected at run time
+ *  if the processor supports it.
+ */
+class Gf256
+{
+public:
+  /**
+   * \brief Multiply two elements.
+   * \param a first factor
+   * \param b second factor
+   * \returns the product
+   */
+  static uint8_t Mul (uint8_t a, uint8_t b);
+  /**
+   * \brief Invert an element.
+   * \param a a non-zero element
+   * \returns the multiplicative inverse of \p a
+   */
+  static uint8_t Inv (uint8_t a);
+  /**
+   * \brief Add a multiple of a region to another, dst[i] += c * src[i].
+   * \param dst the region to update
+   * \param src the region to add
+   * \param c the factor
+   * \param size the region size in bytes
+   */
+  static void MulAddRegion (uint8_t *dst, const uint8_t *src, uint8_t c,
+                            uint32_t size);
+  /**
+   * \brief Multiply a region in place, dst[i] = c * dst[i].
+   * \param dst the region to update
+   * \param c the factor
+   * \param size the region size in bytes
+   */
+  static void MulRegion (uint8_t *dst, uint8_t c, uint32_t size);
+  /// \returns true if the processor supports the SIMD path
+  static bool IsSimdSupported ();
+  /**
+   * \brief Select the SIMD or the scalar path for the region operations.
+   *  The SIMD path is only used if it is supported.
+   * \param enable true to use the SIMD path
+   */
+  static void EnableSimd (bool enable);
+  /// \returns true if the region operations use the SIMD path
+  static bool IsSimdEnabled ();
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
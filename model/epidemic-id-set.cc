@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+
+#include "epidemic-id-set.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EPIDEMIC_ID_SET_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::IdSet implementation.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+namespace {
+
+/// the path used by the operations
+IdSet::Path g_path = IdSet::GetBestPath ();
+
+/**
+ * Merge \p a with \p b one ID at a time, writing the IDs of \p a found in
+ * \p b if \p keep is true and the others otherwise.
+ */
+template <bool keep>
+uint32_t
+MergeScalar (const uint32_t *a, uint32_t sizeA,
+             const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+  uint32_t n = 0;
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < sizeA; ++i)
+    {
+      while (j < sizeB && b[j] < a[i])
+        {
+          ++j;
+        }
+      bool found = j < sizeB && b[j] == a[i];
+      out[n] = a[i];
+      n += found == keep;
+    }
+  return n;
+}
+
+/**
+ * Write the IDs of a block of \p width IDs at \p a whose bit in \p found
+ * is \p keep.
+ */
+template <bool keep>
+inline uint32_t
+EmitBlock (const uint32_t *a, uint32_t width, uint32_t found, uint32_t *out)
+{
+  uint32_t n = 0;
+  for (uint32_t k = 0; k < width; ++k)
+    {
+      out[n] = a[k];
+      n += ((found >> k) & 1) == keep;
+    }
+  return n;
+}
+
+/**
+ * Finish a merge stopped at block \p i of \p a and \p j of \p b, where
+ * \p found has the IDs of the block in progress matched so far.
+ */
+template <bool keep>
+uint32_t
+MergeTail (const uint32_t *a, uint32_t sizeA, uint32_t i,
+           const uint32_t *b, uint32_t sizeB, uint32_t j,
+           uint32_t width, uint32_t found, uint32_t *out)
+{
+  uint32_t n = 0;
+  if (found != 0)
+    {
+      // The rest of b may still hold IDs of the block in progress
+      for (uint32_t k = 0; k < width; ++k, ++i)
+        {
+          if ((found >> k) & 1)
+            {
+              out[n] = a[i];
+              n += keep;
+            }
+          else
+            {
+              n += MergeScalar<keep> (a + i, 1, b + j, sizeB - j, out + n);
+            }
+        }
+    }
+  return n + MergeScalar<keep> (a + i, sizeA - i, b + j, sizeB - j, out + n);
+}
+
+#ifdef EPIDEMIC_ID_SET_X86
+template <bool keep>
+__attribute__ ((target ("sse4.1"))) uint32_t
+MergeSse41 (const uint32_t *a, uint32_t sizeA,
+            const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+  uint32_t n = 0;
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t found = 0;
+  while (i + 4 <= sizeA && j + 4 <= sizeB)
+    {
+      __m128i va = _mm_loadu_si128 ((const __m128i *) (a + i));
+      __m128i vb = _mm_loadu_si128 ((const __m128i *) (b + j));
+      __m128i eq = _mm_cmpeq_epi32 (va, vb);
+      eq = _mm_or_si128 (eq, _mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, 0x39)));
+      eq = _mm_or_si128 (eq, _mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, 0x4E)));
+      eq = _mm_or_si128 (eq, _mm_cmpeq_epi32 (va, _mm_shuffle_epi32 (vb, 0x93)));
+      if (!_mm_testz_si128 (eq, eq))
+        {
+          found |= _mm_movemask_ps (_mm_castsi128_ps (eq));
+        }
+      uint32_t lastA = a[i + 3];
+      uint32_t lastB = b[j + 3];
+      if (lastA <= lastB)
+        {
+          n += EmitBlock<keep> (a + i, 4, found, out + n);
+          found = 0;
+          i += 4;
+        }
+      if (lastB <= lastA)
+        {
+          j += 4;
+        }
+    }
+  return n + MergeTail<keep> (a, sizeA, i, b, sizeB, j, 4, found, out + n);
+}
+
+template <bool keep>
+__attribute__ ((target ("avx2"))) uint32_t
+MergeAvx2 (const uint32_t *a, uint32_t sizeA,
+           const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+  uint32_t n = 0;
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t found = 0;
+  const __m256i rotate = _mm256_setr_epi32 (1, 2, 3, 4, 5, 6, 7, 0);
+  while (i + 8 <= sizeA && j + 8 <= sizeB)
+    {
+      __m256i va = _mm256_loadu_si256 ((const __m256i *) (a + i));
+      __m256i vb = _mm256_loadu_si256 ((const __m256i *) (b + j));
+      __m256i eq = _mm256_cmpeq_epi32 (va, vb);
+      for (uint32_t r = 1; r < 8; ++r)
+        {
+          vb = _mm256_permutevar8x32_epi32 (vb, rotate);
+          eq = _mm256_or_si256 (eq, _mm256_cmpeq_epi32 (va, vb));
+        }
+      found |= _mm256_movemask_ps (_mm256_castsi256_ps (eq));
+      uint32_t lastA = a[i + 7];
+      uint32_t lastB = b[j + 7];
+      if (lastA <= lastB)
+        {
+          n += EmitBlock<keep> (a + i, 8, found, out + n);
+          found = 0;
+          i += 8;
+        }
+      if (lastB <= lastA)
+        {
+          j += 8;
+        }
+    }
+  return n + MergeTail<keep> (a, sizeA, i, b, sizeB, j, 8, found, out + n);
+}
+#endif
+
+/// Run the merge on the selected path
+template <bool keep>
+uint32_t
+Merge (const uint32_t *a, uint32_t sizeA,
+       const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+#ifdef EPIDEMIC_ID_SET_X86
+  if (g_path == IdSet::AVX2)
+    {
+      return MergeAvx2<keep> (a, sizeA, b, sizeB, out);
+    }
+  if (g_path == IdSet::SSE41)
+    {
+      return MergeSse41<keep> (a, sizeA, b, sizeB, out);
+    }
+#endif
+  return MergeScalar<keep> (a, sizeA, b, sizeB, out);
+}
+
+} // anonymous namespace
+
+uint32_t
+IdSet::Difference (const uint32_t *a, uint32_t sizeA,
+                   const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+  return Merge<false> (a, sizeA, b, sizeB, out);
+}
+
+uint32_t
+IdSet::Intersection (const uint32_t *a, uint32_t sizeA,
+                     const uint32_t *b, uint32_t sizeB, uint32_t *out)
+{
+  return Merge<true> (a, sizeA, b, sizeB, out);
+}
+
+IdSet::Path
+IdSet::GetBestPath ()
+{
+#ifdef EPIDEMIC_ID_SET_X86
+  // May run before the constructors of libgcc
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      return AVX2;
+    }
+  if (__builtin_cpu_supports ("sse4.1"))
+    {
+      return SSE41;
+    }
+#endif
+  return SCALAR;
+}
+
+void
+IdSet::SetPath (Path path)
+{
+  Path best = GetBestPath ();
+  g_path = path > best ? best : path;
+}
+
+IdSet::Path
+IdSet::GetPath ()
+{
+  return g_path;
+}
+
+} //end namespace epidemic
+} //end namespace ns3
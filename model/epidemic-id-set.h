@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+
+#ifndef EPIDEMIC_ID_SET_H
+#define EPIDEMIC_ID_SET_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::IdSet declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Set operations on sorted arrays of packet IDs
+ *
+ *  The difference of two summary vectors decides what an anti-entropy
+ *  session sends, and is the hottest loop with large buffers.  Both
+ *  operations merge the arrays block by block: a block of the first array
+ *  is compared with every rotation of a block of the second one, and the
+ *  block with the smaller last element moves on.  Blocks have 4 IDs on
+ *  the SSE4.1 path and 8 on the AVX2 path, the scalar path compares one
+ *  ID at a time.  The fastest path the processor supports is selected at
+ *  load time.
+ */
+class IdSet
+{
+public:
+  /// Implementations of the operations
+  enum Path
+  {
+    SCALAR, //!< one ID at a time
+    SSE41,  //!< blocks of 4 IDs
+    AVX2,   //!< blocks of 8 IDs
+  };
+  /**
+   * \brief Find the IDs of \p a that are not in \p b.
+   * \param a sorted IDs, without duplicates
+   * \param sizeA number of IDs in \p a
+   * \param b sorted IDs
+   * \param sizeB number of IDs in \p b
+   * \param out room for \p sizeA IDs, receives the difference in order
+   * \returns the number of IDs written to \p out
+   */
+  static uint32_t Difference (const uint32_t *a, uint32_t sizeA,
+                              const uint32_t *b, uint32_t sizeB,
+                              uint32_t *out);
+  /**
+   * \brief Find the IDs of \p a that are also in \p b.
+   * \param a sorted IDs, without duplicates
+   * \param sizeA number of IDs in \p a
+   * \param b sorted IDs
+   * \param sizeB number of IDs in \p b
+   * \param out room for \p sizeA IDs, receives the members in order
+   * \returns the number of IDs written to \p out
+   */
+  static uint32_t Intersection (const uint32_t *a, uint32_t sizeA,
+                                const uint32_t *b, uint32_t sizeB,
+                                uint32_t *out);
+  /// \returns the fastest path the processor supports
+  static Path GetBestPath ();
+  /**
+   * \brief Select the path of the operations.  A path the processor does
+   *  not support is replaced by the best one it does.
+   * \param path the path
+   */
+  static void SetPath (Path path);
+  /// \returns the path the operations use
+  static Path GetPath ();
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
@@ -0,0 +1,238 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "epidemic-link-state.h"
+#include <deque>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::LinkStateTable implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicLinkState");
+
+namespace Epidemic {
+
+LinkStateTable::LinkStateTable ()
+  : m_timeout (Seconds (3)),
+    m_sequence (0),
+    m_refreshed (Seconds (0))
+{
+}
+
+void
+LinkStateTable::SetAddress (Ipv4Address address)
+{
+  m_address = address;
+}
+
+void
+LinkStateTable::SetTimeout (Time timeout)
+{
+  m_timeout = timeout;
+}
+
+void
+LinkStateTable::AddNeighbor (Ipv4Address neighbor)
+{
+  NS_LOG_FUNCTION (this << neighbor);
+  m_neighbors[neighbor] = Simulator::Now ();
+}
+
+void
+LinkStateTable::Purge ()
+{
+  Time oldest = Simulator::Now () - m_timeout;
+  for (std::map<Ipv4Address, Time>::iterator i = m_neighbors.begin ();
+       i != m_neighbors.end (); )
+    {
+      if (i->second < oldest)
+        {
+          m_neighbors.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  for (std::map<Ipv4Address, Entry>::iterator i = m_entries.begin ();
+       i != m_entries.end (); )
+    {
+      if (i->second.updated < oldest)
+        {
+          m_entries.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+LinkStateList
+LinkStateTable::GetEntries (uint32_t maxSize)
+{
+  NS_LOG_FUNCTION (this << maxSize);
+  Purge ();
+  LinkStateList entries;
+  uint32_t size = sizeof(uint16_t);
+  std::vector<Ipv4Address> neighbors;
+  for (std::map<Ipv4Address, Time>::const_iterator i = m_neighbors.begin ();
+       i != m_neighbors.end () && neighbors.size () < 0xFF; ++i)
+    {
+      neighbors.push_back (i->first);
+    }
+  uint32_t ownSize = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t)
+    + neighbors.size () * sizeof(uint32_t);
+  // Refreshed before the other nodes drop it as stale
+  if ((neighbors != m_advertised
+       || Simulator::Now () >= m_refreshed
+       + TimeStep (m_timeout.GetTimeStep () / 2))
+      && size + ownSize <= maxSize)
+    {
+      LinkStateEntry entry;
+      entry.origin = m_address;
+      entry.sequence = ++m_sequence;
+      entry.neighbors = neighbors;
+      entries.push_back (entry);
+      size += ownSize;
+      m_advertised.swap (neighbors);
+      m_refreshed = Simulator::Now ();
+    }
+  // Round robin from the last origin flooded, so that the entries left
+  // out of a full beacon go first in the next one
+  std::map<Ipv4Address, Entry>::iterator i =
+    m_entries.upper_bound (m_lastFlooded);
+  for (uint32_t n = 0; n < m_entries.size (); ++n, ++i)
+    {
+      if (i == m_entries.end ())
+        {
+          i = m_entries.begin ();
+        }
+      uint32_t entrySize = sizeof(uint32_t) + sizeof(uint16_t)
+        + sizeof(uint8_t) + i->second.neighbors.size () * sizeof(uint32_t);
+      if (!i->second.changed || size + entrySize > maxSize)
+        {
+          continue;
+        }
+      LinkStateEntry entry;
+      entry.origin = i->first;
+      entry.sequence = i->second.sequence;
+      entry.neighbors = i->second.neighbors;
+      entries.push_back (entry);
+      size += entrySize;
+      i->second.changed = false;
+      m_lastFlooded = i->first;
+    }
+  return entries;
+}
+
+void
+LinkStateTable::Update (const LinkStateList &entries)
+{
+  NS_LOG_FUNCTION (this << entries.size ());
+  for (LinkStateList::const_iterator i = entries.begin ();
+       i != entries.end (); ++i)
+    {
+      if (i->origin == m_address)
+        {
+          continue;
+        }
+      std::map<Ipv4Address, Entry>::iterator stored = m_entries.find (i->origin);
+      // Serial number comparison, sequence numbers wrap around
+      if (stored != m_entries.end ()
+          && static_cast<int16_t> (i->sequence - stored->second.sequence) <= 0)
+        {
+          continue;
+        }
+      Entry &entry = m_entries[i->origin];
+      entry.sequence = i->sequence;
+      entry.neighbors = i->neighbors;
+      entry.updated = Simulator::Now ();
+      entry.changed = true;
+    }
+}
+
+bool
+LinkStateTable::GetNextHop (Ipv4Address destination, Ipv4Address &nextHop)
+{
+  NS_LOG_FUNCTION (this << destination);
+  Purge ();
+  // Breadth-first search, remembering the first hop of every node reached
+  std::map<Ipv4Address, Ipv4Address> firstHop;
+  std::deque<Ipv4Address> pending;
+  for (std::map<Ipv4Address, Time>::const_iterator i = m_neighbors.begin ();
+       i != m_neighbors.end (); ++i)
+    {
+      firstHop[i->first] = i->first;
+      pending.push_back (i->first);
+    }
+  firstHop[m_address] = m_address;
+  while (!pending.empty ())
+    {
+      Ipv4Address node = pending.front ();
+      pending.pop_front ();
+      if (node == destination)
+        {
+          nextHop = firstHop[node];
+          return true;
+        }
+      std::map<Ipv4Address, Entry>::const_iterator entry = m_entries.find (node);
+      if (entry == m_entries.end ())
+        {
+          continue;
+        }
+      for (std::vector<Ipv4Address>::const_iterator i =
+             entry->second.neighbors.begin ();
+           i != entry->second.neighbors.end (); ++i)
+        {
+          if (firstHop.insert (std::make_pair (*i, firstHop[node])).second)
+            {
+              pending.push_back (*i);
+            }
+        }
+    }
+  return false;
+}
+
+uint32_t
+LinkStateTable::GetSize ()
+{
+  Purge ();
+  return m_entries.size ();
+}
+
+} //end namespace epidemic
+} //end namespace ns3
@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#ifndef EPIDEMIC_LINK_STATE_H
+#define EPIDEMIC_LINK_STATE_H
+
+#include <map>
+#include <vector>
+#include "epidemic-packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::LinkStateTable declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Link-state view of the connected component of a node
+ *
+ *  Keeps the neighbors this node heard recently and the latest neighbor
+ *  list flooded by every other node.  Entries are dropped when their
+ *  origin has not been heard of for the timeout, so only the current
+ *  connected component remains.  Links are assumed to be symmetric.
+ *
+ *  Beacons only carry what changed: the entry of this node when its
+ *  neighbors change or half the timeout after it was last sent, and the
+ *  entries of other nodes received since the last beacon.
+ */
+class LinkStateTable
+{
+public:
+  LinkStateTable ();
+  /**
+   * \brief Set the address of this node.
+   * \param address the address advertised as origin of own entries
+   */
+  void SetAddress (Ipv4Address address);
+  /**
+   * \brief Set the time after which neighbors and entries are stale.
+   * \param timeout the timeout
+   */
+  void SetTimeout (Time timeout);
+  /**
+   * \brief Record that a neighbor was heard now.
+   * \param neighbor the neighbor
+   */
+  void AddNeighbor (Ipv4Address neighbor);
+  /**
+   * \brief Get the entries to flood in the next beacon.  Entries that do
+   *  not fit are sent in a later beacon.
+   * \param maxSize the largest serialized size of the LinkStateHeader
+   * \returns the entry of this node with a new sequence number if it is
+   *  due, followed by the entries of other nodes received since the last
+   *  call
+   */
+  LinkStateList GetEntries (uint32_t maxSize);
+  /**
+   * \brief Merge entries received from a neighbor.  Entries of this node
+   *  and entries not newer than the stored ones are ignored.
+   * \param entries the received entries
+   */
+  void Update (const LinkStateList &entries);
+  /**
+   * \brief Find the next hop on a shortest path to a node.
+   * \param destination the destination
+   * \param nextHop the neighbor to send to, set if a path is found
+   * \returns true if the destination is in the connected component
+   */
+  bool GetNextHop (Ipv4Address destination, Ipv4Address &nextHop);
+  /// \returns the number of fresh entries of other nodes
+  uint32_t GetSize ();
+
+private:
+  /// Stored entry of another node
+  struct Entry
+  {
+    uint16_t sequence;                   ///< sequence number of the origin
+    std::vector<Ipv4Address> neighbors;  ///< neighbors heard by the origin
+    Time updated;                        ///< time the entry was received
+    bool changed;                        ///< true until the entry is flooded
+  };
+  /// Remove stale neighbors and entries
+  void Purge ();
+
+  /// Address of this node
+  Ipv4Address m_address;
+  /// Time after which neighbors and entries are stale
+  Time m_timeout;
+  /// Sequence number of the entry of this node
+  uint16_t m_sequence;
+  /// Neighbors in the last entry of this node that was flooded
+  std::vector<Ipv4Address> m_advertised;
+  /// Time the entry of this node was last flooded
+  Time m_refreshed;
+  /// Origin of the last entry flooded, the next beacon starts after it
+  Ipv4Address m_lastFlooded;
+  /// Neighbors of this node and the time they were last heard
+  std::map<Ipv4Address, Time> m_neighbors;
+  /// Entries of other nodes by origin
+  std::map<Ipv4Address, Entry> m_entries;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "epidemic-maxprop.h"
+#include "ns3/log.h"
+#include <limits>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::EncounterTable implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicMaxProp");
+
+namespace Epidemic {
+
+EncounterTable::EncounterTable ()
+  : m_nodes (1),
+    m_probabilities (1),
+    m_dirty (true),
+    m_computations (0)
+{
+}
+
+uint32_t
+EncounterTable::GetIndex (Ipv4Address node)
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (node);
+  if (i != m_index.end ())
+    {
+      return i->second;
+    }
+  uint32_t index = m_nodes.size ();
+  m_index[node] = index;
+  m_nodes.push_back (node);
+  m_probabilities.resize (index + 1);
+  return index;
+}
+
+void
+EncounterTable::Update (Ipv4Address peer, const PredictabilityList &peerTable)
+{
+  NS_LOG_FUNCTION (this << peer << peerTable.size ());
+  uint32_t b = GetIndex (peer);
+  // Incremental averaging: add one meeting and normalize to one again
+  std::vector<double> &own = m_probabilities[0];
+  if (own.size () <= b)
+    {
+      own.resize (b + 1, 0);
+    }
+  own[b] += 1;
+  double sum = 0;
+  for (uint32_t i = 0; i < own.size (); ++i)
+    {
+      sum += own[i];
+    }
+  for (uint32_t i = 0; i < own.size (); ++i)
+    {
+      own[i] /= sum;
+    }
+  std::vector<double> row;
+  for (PredictabilityList::const_iterator i = peerTable.begin ();
+       i != peerTable.end (); ++i)
+    {
+      uint32_t c = GetIndex (i->first);
+      if (row.size () <= c)
+        {
+          row.resize (c + 1, 0);
+        }
+      row[c] = i->second;
+    }
+  m_probabilities[b].swap (row);
+  m_dirty = true;
+}
+
+double
+EncounterTable::GetProbability (Ipv4Address node) const
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (node);
+  if (i == m_index.end () || m_probabilities[0].size () <= i->second)
+    {
+      return 0;
+    }
+  return m_probabilities[0][i->second];
+}
+
+void
+EncounterTable::ComputeCosts ()
+{
+  NS_LOG_FUNCTION (this << m_nodes.size ());
+  uint32_t n = m_nodes.size ();
+  m_costs.assign (n, std::numeric_limits<double>::infinity ());
+  std::vector<bool> done (n, false);
+  m_costs[0] = 0;
+  for (uint32_t round = 0; round < n; ++round)
+    {
+      uint32_t u = n;
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          if (!done[v] && (u == n || m_costs[v] < m_costs[u]))
+            {
+              u = v;
+            }
+        }
+      if (u == n || m_costs[u] == std::numeric_limits<double>::infinity ())
+        {
+          break;
+        }
+      done[u] = true;
+      const std::vector<double> &edges = m_probabilities[u];
+      for (uint32_t v = 0; v < edges.size (); ++v)
+        {
+          if (edges[v] > 0 && m_costs[u] + 1 - edges[v] < m_costs[v])
+            {
+              m_costs[v] = m_costs[u] + 1 - edges[v];
+            }
+        }
+    }
+  m_dirty = false;
+  m_computations++;
+}
+
+double
+EncounterTable::GetCost (Ipv4Address node)
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (node);
+  if (i == m_index.end ())
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (m_dirty)
+    {
+      ComputeCosts ();
+    }
+  return m_costs[i->second];
+}
+
+PredictabilityList
+EncounterTable::GetEntries () const
+{
+  PredictabilityList entries;
+  const std::vector<double> &own = m_probabilities[0];
+  for (uint32_t i = 1; i < own.size (); ++i)
+    {
+      if (own[i] > 0)
+        {
+          entries.push_back (std::make_pair (m_nodes[i], own[i]));
+        }
+    }
+  return entries;
+}
+
+uint32_t
+EncounterTable::GetComputationCount () const
+{
+  return m_computations;
+}
+
+} //end namespace epidemic
+} //end namespace ns3
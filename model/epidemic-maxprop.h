@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#ifndef EPIDEMIC_MAXPROP_H
+#define EPIDEMIC_MAXPROP_H
+
+#include <map>
+#include <vector>
+#include "epidemic-packet.h"
+#include "ns3/ipv4-address.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::EncounterTable declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief MaxProp encounter probabilities and path costs of a node
+ *
+ *  Keeps this node's probabilities of meeting each other node, and the
+ *  last probabilities reported by each peer.  On every encounter the
+ *  peer's probability is incremented by one and the vector is normalized
+ *  again.  Together the vectors form a meeting graph in which the edge
+ *  from u to v costs 1 - f_u(v).  The cost of delivering to a node is the
+ *  cost of the shortest path to it.
+ *
+ *  Costs are computed with Dijkstra over the whole graph, which is small
+ *  (one node per host met directly or through a peer).  They are only
+ *  recomputed on the first query after the graph changed, so transfer
+ *  ordering and eviction between two encounters reuse the same result.
+ */
+class EncounterTable
+{
+public:
+  EncounterTable ();
+  /**
+   * \brief Update the table with an encounter of a peer.
+   * \param peer the address of the peer
+   * \param peerTable the probabilities reported by the peer, without
+   *  entries for this node
+   */
+  void Update (Ipv4Address peer, const PredictabilityList &peerTable);
+  /**
+   * \brief Get the probability of meeting a node.
+   * \param node the node
+   * \returns f(node), 0 if unknown
+   */
+  double GetProbability (Ipv4Address node) const;
+  /**
+   * \brief Get the estimated cost of delivering to a node.
+   * \param node the destination
+   * \returns the shortest path cost, infinity if no path is known
+   */
+  double GetCost (Ipv4Address node);
+  /// \returns the encounter probabilities of this node
+  PredictabilityList GetEntries () const;
+  /// \returns the number of times the path costs were computed
+  uint32_t GetComputationCount () const;
+
+private:
+  /// \returns the dense index of \p node, created on first use
+  uint32_t GetIndex (Ipv4Address node);
+  /// Recompute the path costs from this node
+  void ComputeCosts ();
+
+  /// Dense index of every known node, this node has index 0
+  std::map<Ipv4Address, uint32_t> m_index;
+  /// Node of every index, index 0 is unused
+  std::vector<Ipv4Address> m_nodes;
+  /// Encounter probabilities by node index, then node index
+  std::vector<std::vector<double> > m_probabilities;
+  /// Path costs by node index
+  std::vector<double> m_costs;
+  /// true if the graph changed since the costs were computed
+  bool m_dirty;
+  /// Number of times the path costs were computed
+  uint32_t m_computations;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
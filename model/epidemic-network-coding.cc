@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "epidemic-network-coding.h"
+#include "epidemic-gf256.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::RlncEncoder and ns3::Epidemic::RlncDecoder implementations.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicNetworkCoding");
+
+namespace Epidemic {
+
+RlncEncoder::RlncEncoder (uint32_t symbolSize)
+  : m_symbolSize (symbolSize)
+{
+  NS_LOG_FUNCTION (this << symbolSize);
+}
+
+void
+RlncEncoder::AddSymbol (const uint8_t *data, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT_MSG (size <= m_symbolSize, "Symbol larger than the symbol size");
+  std::vector<uint8_t> symbol (m_symbolSize, 0);
+  std::copy (data, data + size, symbol.begin ());
+  m_symbols.push_back (symbol);
+}
+
+uint32_t
+RlncEncoder::GetGenerationSize () const
+{
+  return m_symbols.size ();
+}
+
+uint32_t
+RlncEncoder::GetSymbolSize () const
+{
+  return m_symbolSize;
+}
+
+void
+RlncEncoder::Encode (const uint8_t *coefficients, uint8_t *coded) const
+{
+  NS_LOG_FUNCTION (this);
+  std::fill (coded, coded + m_symbolSize, 0);
+  for (uint32_t i = 0; i < m_symbols.size (); ++i)
+    {
+      Gf256::MulAddRegion (coded, &m_symbols[i][0], coefficients[i],
+                           m_symbolSize);
+    }
+}
+
+
+RlncDecoder::RlncDecoder (uint32_t generationSize, uint32_t symbolSize)
+  : m_generationSize (generationSize),
+    m_symbolSize (symbolSize),
+    m_rank (0),
+    m_coefficients (generationSize),
+    m_symbols (generationSize)
+{
+  NS_LOG_FUNCTION (this << generationSize << symbolSize);
+}
+
+bool
+RlncDecoder::AddSymbol (const uint8_t *coefficients, const uint8_t *symbol)
+{
+  NS_LOG_FUNCTION (this);
+  if (IsComplete ())
+    {
+      return false;
+    }
+  std::vector<uint8_t> row (coefficients, coefficients + m_generationSize);
+  std::vector<uint8_t> data (symbol, symbol + m_symbolSize);
+  // Eliminate the pivots already known
+  for (uint32_t j = 0; j < m_generationSize; ++j)
+    {
+      if (row[j] != 0 && !m_coefficients[j].empty ())
+        {
+          uint8_t factor = row[j];
+          Gf256::MulAddRegion (&row[0], &m_coefficients[j][0], factor,
+                               m_generationSize);
+          Gf256::MulAddRegion (&data[0], &m_symbols[j][0], factor,
+                               m_symbolSize);
+        }
+    }
+  uint32_t pivot = 0;
+  while (pivot < m_generationSize && row[pivot] == 0)
+    {
+      pivot++;
+    }
+  if (pivot == m_generationSize)
+    {
+      NS_LOG_LOGIC ("Symbol is not innovative");
+      return false;
+    }
+  uint8_t inverse = Gf256::Inv (row[pivot]);
+  Gf256::MulRegion (&row[0], inverse, m_generationSize);
+  Gf256::MulRegion (&data[0], inverse, m_symbolSize);
+  // Remove the new pivot from the other rows to keep them reduced
+  for (uint32_t j = 0; j < m_generationSize; ++j)
+    {
+      if (!m_coefficients[j].empty () && m_coefficients[j][pivot] != 0)
+        {
+          uint8_t factor = m_coefficients[j][pivot];
+          Gf256::MulAddRegion (&m_coefficients[j][0], &row[0], factor,
+                               m_generationSize);
+          Gf256::MulAddRegion (&m_symbols[j][0], &data[0], factor,
+                               m_symbolSize);
+        }
+    }
+  m_coefficients[pivot].swap (row);
+  m_symbols[pivot].swap (data);
+  m_rank++;
+  NS_LOG_LOGIC ("Rank " << m_rank << " of " << m_generationSize);
+  return true;
+}
+
+uint32_t
+RlncDecoder::GetRank () const
+{
+  return m_rank;
+}
+
+uint32_t
+RlncDecoder::GetGenerationSize () const
+{
+  return m_generationSize;
+}
+
+uint32_t
+RlncDecoder::GetSymbolSize () const
+{
+  return m_symbolSize;
+}
+
+bool
+RlncDecoder::IsComplete () const
+{
+  return m_rank == m_generationSize;
+}
+
+const uint8_t *
+RlncDecoder::GetSymbol (uint32_t index) const
+{
+  NS_ASSERT_MSG (IsComplete (), "Generation is not decoded");
+  return &m_symbols[index][0];
+}
+
+} //end namespace epidemic
+} //end namespace ns3
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#ifndef EPIDEMIC_NETWORK_CODING_H
+#define EPIDEMIC_NETWORK_CODING_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::RlncEncoder and ns3::Epidemic::RlncDecoder declarations.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief Random linear network coding encoder for one generation
+ *
+ *  Holds the source symbols of a generation, all padded to the same
+ *  size, and produces linear combinations of them over GF(2^8).
+ */
+class RlncEncoder
+{
+public:
+  /**
+   * \brief Constructor for RlncEncoder
+   * \param symbolSize size of every symbol in bytes
+   */
+  RlncEncoder (uint32_t symbolSize);
+  /**
+   * \brief Append a source symbol, padded with zeros to the symbol size.
+   * \param data the symbol bytes
+   * \param size number of bytes in \p data, at most the symbol size
+   */
+  void AddSymbol (const uint8_t *data, uint32_t size);
+  /// \returns the number of source symbols
+  uint32_t GetGenerationSize () const;
+  /// \returns the symbol size in bytes
+  uint32_t GetSymbolSize () const;
+  /**
+   * \brief Compute a coded symbol.
+   * \param coefficients one coefficient per source symbol
+   * \param coded buffer of the symbol size, set to the combination
+   */
+  void Encode (const uint8_t *coefficients, uint8_t *coded) const;
+
+private:
+  /// Size of every symbol in bytes
+  uint32_t m_symbolSize;
+  /// Source symbols
+  std::vector<std::vector<uint8_t> > m_symbols;
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Random linear network coding decoder for one generation
+ *
+ *  Runs Gauss-Jordan elimination as coded symbols arrive.  The rows are
+ *  kept in reduced echelon form and indexed by their pivot, so a symbol
+ *  that does not raise the rank is detected at once and every innovative
+ *  symbol, whichever node coded it, brings the decoder one step closer.
+ *  Once the rank equals the generation size the rows hold the source
+ *  symbols.
+ */
+class RlncDecoder
+{
+public:
+  /**
+   * \brief Constructor for RlncDecoder
+   * \param generationSize number of source symbols
+   * \param symbolSize size of every symbol in bytes
+   */
+  RlncDecoder (uint32_t generationSize, uint32_t symbolSize);
+  /**
+   * \brief Add a coded symbol.
+   * \param coefficients one coefficient per source symbol
+   * \param symbol the coded symbol
+   * \returns true if the symbol was innovative
+   */
+  bool AddSymbol (const uint8_t *coefficients, const uint8_t *symbol);
+  /// \returns the number of innovative symbols received
+  uint32_t GetRank () const;
+  /// \returns the number of source symbols
+  uint32_t GetGenerationSize () const;
+  /// \returns the symbol size in bytes
+  uint32_t GetSymbolSize () const;
+  /// \returns true once all source symbols are decoded
+  bool IsComplete () const;
+  /**
+   * \brief Get a decoded source symbol.
+   * \param index the index of the source symbol, the decoder must be
+   *  complete
+   * \returns the symbol bytes
+   */
+  const uint8_t * GetSymbol (uint32_t index) const;
+
+private:
+  /// Number of source symbols
+  uint32_t m_generationSize;
+  /// Size of every symbol in bytes
+  uint32_t m_symbolSize;
+  /// Number of innovative symbols received
+  uint32_t m_rank;
+  /// Coefficient rows indexed by pivot, empty if no row has that pivot
+  std::vector<std::vector<uint8_t> > m_coefficients;
+  /// Symbol rows matching m_coefficients
+  std::vector<std::vector<uint8_t> > m_symbols;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
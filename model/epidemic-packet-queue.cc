@@ -35,6 +35,7 @@
 #include "ns3/socket.h"
 #include "ns3/log.h"
 #include "epidemic-packet.h"
+#include "epidemic-id-set.h"
 
 using namespace std;
 
@@ -169,6 +170,9 @@ PacketQueue::PacketQueue (uint32_t maxLen)
 {
   NS_LOG_FUNCTION (this << maxLen);
   m_maxLen = maxLen;
+  m_enqueueTrace = 0;
+  m_duplicateTrace = 0;
+  m_dropTrace = 0;
 }
 
 uint32_t
@@ -182,7 +186,36 @@ PacketQueue::Enqueue (QueueEntry & entry)
 {
   NS_LOG_FUNCTION (this << entry.GetPacketID ());
   // Add or update the entry
-  m_map[entry.GetPacketID ()] = entry;
+  std::pair<PacketIdMap::iterator, bool> added =
+    m_map.insert (PacketIdMapPair (entry.GetPacketID (), entry));
+  if (!added.second)
+    {
+      added.first->second = entry;
+    }
+  else if (m_enqueueTrace)
+    {
+      (*m_enqueueTrace) (entry.GetPacket (), entry.GetPacketID ());
+    }
+  Purge (true);
+  return true;
+}
+
+bool
+PacketQueue::Insert (const QueueEntry & entry)
+{
+  NS_LOG_FUNCTION (this << entry.GetPacketID ());
+  if (!m_map.insert (PacketIdMapPair (entry.GetPacketID (), entry)).second)
+    {
+      if (m_duplicateTrace)
+        {
+          (*m_duplicateTrace) (entry.GetPacket (), entry.GetPacketID ());
+        }
+      return false;
+    }
+  if (m_enqueueTrace)
+    {
+      (*m_enqueueTrace) (entry.GetPacket (), entry.GetPacketID ());
+    }
   Purge (true);
   return true;
 }
@@ -227,6 +260,12 @@ PacketQueue::Find (uint32_t packetID)
   return QueueEntry ();
 }
 
+bool
+PacketQueue::Contains (uint32_t packetID) const
+{
+  return m_map.find (packetID) != m_map.end ();
+}
+
 
 // static
 bool
@@ -241,60 +280,143 @@ void
 PacketQueue::Purge (bool outdated /* = false */)
 {
   NS_LOG_FUNCTION (this << outdated);
-  if (outdated && m_map.size () > m_maxLen)
+  if (outdated && m_map.size () > m_maxLen && !m_cost.IsNull ())
+    {
+      // Drop the most expensive packet, the oldest one among equals
+      PacketIdMap::iterator victim = m_map.begin ();
+      double victimCost = m_cost (victim->second);
+      for (PacketIdMap::iterator i = ++m_map.begin (); i != m_map.end (); ++i)
+        {
+          double cost = m_cost (i->second);
+          if (cost > victimCost
+              || (cost == victimCost && IsEarlier (*i, *victim)))
+            {
+              victim = i;
+              victimCost = cost;
+            }
+        }
+      Drop (victim, MOST_EXPENSIVE);
+    }
+  else if (outdated && m_map.size () > m_maxLen)
     {
       Drop (std::min_element (m_map.begin (), m_map.end (), IsEarlier),
-            "Drop the oldest packet");
+            OLDEST);
     }
   else
     {
-      for (PacketIdMap::iterator i = m_map.begin ();
-           i != m_map.end (); ++i)
+      for (PacketIdMap::iterator i = m_map.begin (); i != m_map.end (); )
         {
+          // Advance before the entry is erased
           if (i->second.GetExpireTime () < Now ())
             {
-              Drop (i, "Drop outdated packet ");
+              Drop (i++, EXPIRED);
+            }
+          else
+            {
+              ++i;
             }
         }
     }
 }
 
 void
-PacketQueue::Drop (PacketIdMap::iterator en, std::string reason)
+PacketQueue::Drop (PacketIdMap::iterator en, DropReason reason)
 {
-  NS_LOG_FUNCTION (this << en->second.GetPacketID () << reason);
-  m_map.erase (en->second.GetPacketID ());
+  NS_LOG_FUNCTION (this << en->first << reason);
+  if (m_dropTrace)
+    {
+      (*m_dropTrace) (en->second.GetPacket (), en->first, reason);
+    }
+  m_map.erase (en);
 }
 
+/// Transfer priority of a queued packet
+struct TransferPriority
+{
+  bool toPeer;       ///< the packet is addressed to the receiving peer
+  double cost;       ///< cost of the packet, lower goes first
+  uint32_t packetID; ///< global packet ID
+};
+
+/// \returns true if \p a should be sent before \p b
+static bool
+IsMoreValuable (const TransferPriority &a, const TransferPriority &b)
+{
+  if (a.toPeer != b.toPeer)
+    {
+      return a.toPeer;
+    }
+  return a.cost < b.cost;
+}
 
+void
+PacketQueue::SetCostCallback (CostCallback cost)
+{
+  NS_LOG_FUNCTION (this);
+  m_cost = cost;
+}
 
-SummaryVectorHeader
-PacketQueue::GetSummaryVector ()
+void
+PacketQueue::OrderTransferList (std::vector<uint32_t> &packets,
+                                Ipv4Address peer)
 {
-  NS_LOG_FUNCTION (this );
-  Purge (true);
-  SummaryVectorHeader sm (m_map.size ());
-  for (PacketIdMap::iterator i = m_map.begin (); i != m_map.end (); ++i)
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  std::vector<TransferPriority> priorities;
+  priorities.reserve (packets.size ());
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      TransferPriority priority;
+      priority.packetID = *i;
+      priority.toPeer = false;
+      priority.cost = 0;
+      PacketIdMap::const_iterator entry = m_map.find (*i);
+      if (entry != m_map.end ())
+        {
+          priority.toPeer = entry->second.GetIpv4Header ().GetDestination ()
+            == peer;
+          if (m_cost.IsNull ())
+            {
+              // More hops left goes first
+              EpidemicHeader header;
+              entry->second.GetPacket ()->PeekHeader (header);
+              priority.cost = -static_cast<double> (header.GetHopCount ());
+            }
+          else
+            {
+              priority.cost = m_cost (entry->second);
+            }
+        }
+      priorities.push_back (priority);
+    }
+  std::stable_sort (priorities.begin (), priorities.end (), IsMoreValuable);
+  for (uint32_t i = 0; i < priorities.size (); ++i)
     {
-      sm.Add (i->first);
+      packets[i] = priorities[i].packetID;
     }
-  return sm;
 }
 
-
-SummaryVectorHeader
-PacketQueue::FindDisjointPackets (SummaryVectorHeader list)
+Ptr<Packet>
+PacketQueue::ReassembleBundle (const EpidemicHeader &chunk)
 {
-  NS_LOG_FUNCTION (this << list);
-  SummaryVectorHeader sm (std::min (m_map.size (), list.Size ()));
-  for (PacketIdMap::iterator i = m_map.begin (); i != m_map.end (); ++i)
+  NS_LOG_FUNCTION (this << chunk.GetBundleID () << chunk.GetChunkCount ());
+  Ptr<Packet> bundle = Create<Packet> ();
+  for (uint16_t index = 0; index < chunk.GetChunkCount (); ++index)
     {
-      if (!list.Contains (i->first))
+      PacketIdMap::const_iterator entry =
+        m_map.find (chunk.GetChunkPacketID (index));
+      if (entry == m_map.end ())
         {
-          sm.Add (i->first);
+          NS_LOG_LOGIC ("Chunk " << index << " of bundle "
+                                 << chunk.GetBundleID () << " is missing");
+          return 0;
         }
+      Ptr<Packet> piece = entry->second.GetPacket ()->Copy ();
+      EpidemicHeader header;
+      piece->RemoveHeader (header);
+      bundle->AddAtEnd (piece);
     }
-  return sm;
+  return bundle;
 }
 
 
@@ -305,5 +427,230 @@ PacketQueue::DropExpiredPackets ()
   Purge (true);
 }
 
+void
+PacketQueue::SetTraces (const PacketTrace *enqueue,
+                        const PacketTrace *duplicate, const DropTrace *drop)
+{
+  m_enqueueTrace = enqueue;
+  m_duplicateTrace = duplicate;
+  m_dropTrace = drop;
+}
+
+
+SummaryVectorView::SummaryVectorView (const PacketQueue &queue)
+  : m_queue (&queue)
+{
+}
+
+TypeId
+SummaryVectorView::GetInstanceTypeId () const
+{
+  // Same bytes as a SummaryVectorHeader, printed as one
+  return SummaryVectorHeader::GetTypeId ();
+}
+
+uint32_t
+SummaryVectorView::GetSerializedSize () const
+{
+  return sizeof (uint32_t) + Size () * sizeof (uint32_t);
+}
+
+void
+SummaryVectorView::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU32 (Size ());
+  for (PacketQueue::PacketIdMap::const_iterator j = m_queue->m_map.begin ();
+       j != m_queue->m_map.end (); ++j)
+    {
+      i.WriteHtonU32 (j->first);
+    }
+}
+
+uint32_t
+SummaryVectorView::Deserialize (Buffer::Iterator start)
+{
+  NS_FATAL_ERROR ("SummaryVectorView cannot be deserialized, "
+                  "use a SummaryVectorHeader");
+  return 0;
+}
+
+void
+SummaryVectorView::Print (std::ostream &os) const
+{
+  os << " Summary_vector view with size: " << Size ();
+}
+
+uint32_t
+SummaryVectorView::Size () const
+{
+  return m_queue->m_map.size ();
+}
+
+
+/// Number of peer IDs read from the buffer at once
+static const uint32_t SUMMARY_VECTOR_BLOCK = 256;
+
+SummaryVectorDifference::SummaryVectorDifference (const PacketQueue &queue,
+                                                  uint32_t maxSize)
+  : m_queue (&queue),
+    m_maxSize (maxSize),
+    m_size (0),
+    m_valid (false)
+{
+}
+
+TypeId
+SummaryVectorDifference::GetInstanceTypeId () const
+{
+  return SummaryVectorHeader::GetTypeId ();
+}
+
+uint32_t
+SummaryVectorDifference::GetSerializedSize () const
+{
+  return sizeof (uint32_t) + m_size * sizeof (uint32_t);
+}
+
+void
+SummaryVectorDifference::Serialize (Buffer::Iterator start) const
+{
+  NS_FATAL_ERROR ("SummaryVectorDifference cannot be serialized, "
+                  "use a SummaryVectorHeader");
+}
+
+uint32_t
+SummaryVectorDifference::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  m_missing.clear ();
+  m_unknown.clear ();
+  m_size = 0;
+  m_valid = false;
+  if (i.GetRemainingSize () < sizeof (uint32_t))
+    {
+      NS_LOG_LOGIC ("Truncated summary vector length");
+      return 0;
+    }
+  uint32_t length = i.ReadNtohU32 ();
+  if (length > i.GetRemainingSize () / sizeof (uint32_t)
+      || (m_maxSize != 0 && length > m_maxSize))
+    {
+      NS_LOG_LOGIC ("Summary vector of " << length << " IDs rejected, "
+                                         << i.GetRemainingSize ()
+                                         << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
+  m_size = length;
+  m_valid = true;
+
+  const PacketQueue::PacketIdMap &index = m_queue->m_map;
+  PacketQueue::PacketIdMap::const_iterator own = index.begin ();
+  Buffer::Iterator ids = i;
+  uint32_t peer[SUMMARY_VECTOR_BLOCK];
+  uint32_t last = 0;
+  std::vector<uint32_t> ownBlock;
+  for (uint32_t read = 0; read < length; )
+    {
+      uint32_t count = std::min (length - read, SUMMARY_VECTOR_BLOCK);
+      for (uint32_t k = 0; k < count; ++k)
+        {
+          peer[k] = i.ReadNtohU32 ();
+          // The merge needs ascending IDs across blocks too
+          if ((read > 0 || k > 0) && peer[k] <= last)
+            {
+              DeserializeUnsorted (ids);
+              return GetSerializedSize ();
+            }
+          last = peer[k];
+        }
+      // Own IDs up to the last peer ID of the block, the rest is compared
+      // with the next blocks
+      ownBlock.clear ();
+      for (; own != index.end () && own->first <= peer[count - 1]; ++own)
+        {
+          ownBlock.push_back (own->first);
+        }
+      size_t missing = m_missing.size ();
+      m_missing.resize (missing + ownBlock.size ());
+      m_missing.resize (missing + IdSet::Difference (ownBlock.data (),
+                                                     ownBlock.size (),
+                                                     peer, count,
+                                                     m_missing.data () + missing));
+      size_t unknown = m_unknown.size ();
+      m_unknown.resize (unknown + count);
+      m_unknown.resize (unknown + IdSet::Difference (peer, count,
+                                                     ownBlock.data (),
+                                                     ownBlock.size (),
+                                                     m_unknown.data () + unknown));
+      read += count;
+    }
+  for (; own != index.end (); ++own)
+    {
+      m_missing.push_back (own->first);
+    }
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+SummaryVectorDifference::DeserializeUnsorted (Buffer::Iterator i)
+{
+  NS_LOG_FUNCTION (this << m_size);
+  std::vector<uint32_t> peer (m_size);
+  for (uint32_t k = 0; k < m_size; ++k)
+    {
+      peer[k] = i.ReadNtohU32 ();
+    }
+  std::sort (peer.begin (), peer.end ());
+  peer.erase (std::unique (peer.begin (), peer.end ()), peer.end ());
+  std::vector<uint32_t> own;
+  own.reserve (m_queue->m_map.size ());
+  for (PacketQueue::PacketIdMap::const_iterator j = m_queue->m_map.begin ();
+       j != m_queue->m_map.end (); ++j)
+    {
+      own.push_back (j->first);
+    }
+  m_missing.resize (own.size ());
+  m_missing.resize (IdSet::Difference (own.data (), own.size (), peer.data (),
+                                       peer.size (), m_missing.data ()));
+  m_unknown.resize (peer.size ());
+  m_unknown.resize (IdSet::Difference (peer.data (), peer.size (), own.data (),
+                                       own.size (), m_unknown.data ()));
+}
+
+void
+SummaryVectorDifference::Print (std::ostream &os) const
+{
+  os << " Summary_vector difference with size: " << m_size
+     << " missing: " << m_missing.size ()
+     << " unknown: " << m_unknown.size ();
+}
+
+uint32_t
+SummaryVectorDifference::Size () const
+{
+  return m_size;
+}
+
+bool
+SummaryVectorDifference::IsValid () const
+{
+  return m_valid;
+}
+
+const std::vector<uint32_t> &
+SummaryVectorDifference::GetMissing () const
+{
+  return m_missing;
+}
+
+const std::vector<uint32_t> &
+SummaryVectorDifference::GetUnknown () const
+{
+  return m_unknown;
+}
+
 } //end namespace epidemic
 } //end namespace ns3
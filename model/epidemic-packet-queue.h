@@ -34,6 +34,8 @@
 #include <vector>
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
+#include "ns3/header.h"
+#include "ns3/traced-callback.h"
 #include <string.h>
 #include <sstream>
 
@@ -121,7 +123,7 @@ private:
 
 
 // Forward declaration
-class SummaryVectorHeader;
+class EpidemicHeader;
 
 /**
  * \ingroup epidemic
@@ -131,6 +133,39 @@ class SummaryVectorHeader;
 class PacketQueue
 {
 public:
+  /**
+   * Callback returning the cost of a queued packet.  Packets with a
+   * lower cost are sent first and dropped last.
+   */
+  typedef Callback<double, const QueueEntry &> CostCallback;
+
+  /// Why a packet was dropped from the queue
+  enum DropReason
+  {
+    EXPIRED = 0,     //!< the packet outlived the queue entry timeout
+    OLDEST,          //!< the queue was full and the packet was the oldest
+    MOST_EXPENSIVE,  //!< the queue was full and the packet cost the most
+  };
+
+  /// Trace source of a queued packet and its packet ID
+  typedef TracedCallback<Ptr<const Packet>, uint32_t> PacketTrace;
+  /// Trace source of a dropped packet, its packet ID and the reason
+  typedef TracedCallback<Ptr<const Packet>, uint32_t, DropReason> DropTrace;
+  /**
+   * TracedCallback signature of PacketTrace.
+   * \param [in] packet the packet, with its epidemic header.
+   * \param [in] packetID the global packet ID.
+   */
+  typedef void (* PacketTracedCallback)
+    (Ptr<const Packet> packet, uint32_t packetID);
+  /**
+   * TracedCallback signature of DropTrace.
+   * \param [in] packet the packet, with its epidemic header.
+   * \param [in] packetID the global packet ID.
+   * \param [in] reason why the packet was dropped.
+   */
+  typedef void (* DropTracedCallback)
+    (Ptr<const Packet> packet, uint32_t packetID, DropReason reason);
   /**
    * \brief Constructor for PacketQueue
    * \param maxLen maximum length of the queue
@@ -143,6 +178,14 @@ public:
    * \returns true if the entry  is successfully added.
    */
   bool Enqueue (QueueEntry & entry);
+  /**
+   * \brief Add an entry unless a packet with the same ID is queued.
+   *  Unlike Enqueue, a queued entry is kept as it is.  Needs a single
+   *  lookup in the queue.
+   * \param entry contains a packet ID
+   * \returns true if the entry was added, false if the packet was queued
+   */
+  bool Insert (const QueueEntry & entry);
   /**
    * \brief remove entry in queue mapped with the its packet ID.
    * \param entry contains a packet ID
@@ -173,17 +216,49 @@ public:
    * \returns the found QueueEntry
    */
   QueueEntry  Find (uint32_t packetID);
-  /// \returns the summary vector of a current node's buffer
-  SummaryVectorHeader GetSummaryVector ();
   /**
-   * \brief Returns a summary vector that contains
-   *  the disjoint packets between the given list and current buffer
-   * \param list a list of compared packet IDs
-   * \returns the summary vector of the disjoint packets
+   * \brief Check if a packet is in the Epidemic queue, without copying
+   *  its entry.
+   * \param packetID packet ID for the target packet
+   * \returns true if the packet is queued
    */
-  SummaryVectorHeader FindDisjointPackets (SummaryVectorHeader list);
+  bool Contains (uint32_t packetID) const;
+  /**
+   * \brief Set the cost used to order transfers and to pick the packet
+   *  dropped when the queue is full.
+   * \param cost the cost callback, a null callback restores the default:
+   *  order by hop count and drop the oldest packet
+   */
+  void SetCostCallback (CostCallback cost);
+  /**
+   * \brief Order a transfer list so that the most valuable packets go
+   *  first: packets addressed to the receiving peer, then packets with
+   *  more hops left, or with a lower cost if a CostCallback is set.  The
+   *  order is otherwise kept.
+   * \param packets IDs of queued packets, reordered in place
+   * \param peer the node the packets are sent to
+   */
+  void OrderTransferList (std::vector<uint32_t> &packets, Ipv4Address peer);
+  /**
+   * \brief Rebuild a bundle from its chunks in the queue.
+   * \param chunk the epidemic header of any chunk of the bundle
+   * \returns the bundle without epidemic headers, or 0 if a chunk is
+   *  missing
+   */
+  Ptr<Packet> ReassembleBundle (const EpidemicHeader &chunk);
   /// Drop expired packet in the current node's buffer
   void DropExpiredPackets ();
+  /**
+   * \brief Set the trace sources fired by the queue.  The queue is not
+   *  an Object, the trace sources belong to the routing protocol, which
+   *  registers them in its TypeId.
+   * \param enqueue fired when a packet is added, 0 for none
+   * \param duplicate fired when a packet already queued is inserted,
+   *  0 for none
+   * \param drop fired when a packet is dropped, 0 for none
+   */
+  void SetTraces (const PacketTrace *enqueue, const PacketTrace *duplicate,
+                  const DropTrace *drop);
 
 private:
   ///  Type to connect a global Packet id to a QueueEntry
@@ -202,15 +277,112 @@ private:
   void Purge (bool outdated /* = false */);
 
   /**
-   * \brief Drop a packet and log the reason.
+   * \brief Drop a packet and trace the reason.
    * \param en the packet to be dropped.
    * \param reason the reason for dropping the packet.
    */
-  void Drop (PacketIdMap::iterator en, std::string reason);
+  void Drop (PacketIdMap::iterator en, DropReason reason);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
+  /// Cost of queued packets, null to use hop count and age
+  CostCallback m_cost;
+  /// Trace of added packets, owned by the routing protocol
+  const PacketTrace *m_enqueueTrace;
+  /// Trace of packets inserted while queued, owned by the routing protocol
+  const PacketTrace *m_duplicateTrace;
+  /// Trace of dropped packets, owned by the routing protocol
+  const DropTrace *m_dropTrace;
+
+  // The summary vector headers read the packet IDs straight from m_map
+  friend class SummaryVectorView;
+  friend class SummaryVectorDifference;
+
+};
 
+/**
+ * \ingroup epidemic
+ * \brief Summary vector serialized straight from the index of a queue.
+ *
+ * Writes the same bytes as a SummaryVectorHeader holding the IDs of the
+ * queue, without copying them into a vector first.  The queue must not
+ * change before the header is serialized, and expired packets should be
+ * dropped before.  The header is write only.
+ */
+class SummaryVectorView : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param queue the queue whose packet IDs are sent
+   */
+  SummaryVectorView (const PacketQueue &queue);
+  // Inherited from Header
+  virtual TypeId GetInstanceTypeId () const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /// \returns the number of packet IDs in the summary vector
+  uint32_t Size () const;
+
+private:
+  /// The queue whose packet IDs are sent
+  const PacketQueue *m_queue;
+};
 
+/**
+ * \ingroup epidemic
+ * \brief Summary vector of a peer compared with a queue while it is read.
+ *
+ * Deserializes a SummaryVectorHeader without storing it: the peer IDs are
+ * read from the buffer in small blocks and merged with the index of the
+ * queue.  Only the difference in both directions is kept.  Peer IDs are
+ * expected in ascending order, as sent by SummaryVectorView; any other
+ * order is handled by sorting them, which costs a copy.  The header is
+ * read only.
+ */
+class SummaryVectorDifference : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param queue the queue the peer IDs are compared with
+   * \param maxSize largest number of IDs accepted, 0 for no limit
+   */
+  SummaryVectorDifference (const PacketQueue &queue, uint32_t maxSize = 0);
+  // Inherited from Header
+  virtual TypeId GetInstanceTypeId () const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /// \returns the number of packet IDs in the peer summary vector
+  uint32_t Size () const;
+  /// \returns false if the summary vector was truncated or too long
+  bool IsValid () const;
+  /// \returns the IDs queued but missing in the peer, in ascending order
+  const std::vector<uint32_t> & GetMissing () const;
+  /// \returns the peer IDs missing in the queue, in ascending order
+  const std::vector<uint32_t> & GetUnknown () const;
+
+private:
+  /**
+   * \brief Compute the difference from peer IDs in any order.
+   * \param start iterator at the first peer ID
+   */
+  void DeserializeUnsorted (Buffer::Iterator start);
+  /// The queue the peer IDs are compared with
+  const PacketQueue *m_queue;
+  /// Largest number of IDs accepted by Deserialize, 0 for no limit
+  uint32_t m_maxSize;
+  /// Number of IDs in the peer summary vector
+  uint32_t m_size;
+  /// true if the header deserialized correctly
+  bool m_valid;
+  /// IDs queued but missing in the peer
+  std::vector<uint32_t> m_missing;
+  /// Peer IDs missing in the queue
+  std::vector<uint32_t> m_unknown;
 };
 } //end namespace epidemic
 } //end namespace ns3
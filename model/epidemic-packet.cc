@@ -31,6 +31,9 @@
 #include "ns3/address-utils.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include <cmath>
+#include <algorithm>
 
 /**
  * \file
@@ -53,6 +56,7 @@ NS_OBJECT_ENSURE_REGISTERED (TypeHeader);
 
 TypeHeader::TypeHeader (MessageType t)
   : m_type (t),
+    m_compact (false),
     m_valid (true)
 {
 }
@@ -91,20 +95,28 @@ TypeHeader::GetSerializedSize () const
 void
 TypeHeader::Serialize (Buffer::Iterator i) const
 {
-  i.WriteU8 ((uint8_t) m_type);
+  i.WriteU8 ((m_compact ? 0x10 : 0) | (uint8_t) m_type);
 }
 
 uint32_t
 TypeHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
-  uint8_t type = i.ReadU8 ();
-  m_valid = true;
+  if (i.IsEnd ())
+    {
+      m_valid = false;
+      return 0;
+    }
+  uint8_t version = i.ReadU8 ();
+  uint8_t type = version & 0x0F;
+  m_valid = (version >> 4) <= 1;
+  m_compact = (version >> 4) == 1;
   switch (type)
     {
     case BEACON:
     case REPLY:
     case REPLY_BACK:
+    case AGGREGATE:
       {
         m_type = (MessageType) type;
         break;
@@ -138,6 +150,11 @@ TypeHeader::Print (std::ostream &os) const
         os << "REPLY_BACK";
         break;
       }
+    case AGGREGATE:
+      {
+        os << "AGGREGATE";
+        break;
+      }
     default:
       os << "UNKNOWN_TYPE";
       break;
@@ -163,6 +180,25 @@ TypeHeader::IsMessageType (const MessageType type) const
   return m_type == type;
 }
 
+bool
+TypeHeader::IsValid () const
+{
+  return m_valid;
+}
+
+void
+TypeHeader::SetCompact (bool compact)
+{
+  NS_LOG_FUNCTION (this << compact);
+  m_compact = compact;
+}
+
+bool
+TypeHeader::IsCompact () const
+{
+  return m_compact;
+}
+
 std::ostream &
 operator<< (std::ostream & os, TypeHeader const & h)
 {
@@ -173,6 +209,8 @@ operator<< (std::ostream & os, TypeHeader const & h)
 NS_OBJECT_ENSURE_REGISTERED (SummaryVectorHeader);
 
 SummaryVectorHeader::SummaryVectorHeader (size_t size)
+  : m_maxSize (0),
+    m_valid (true)
 {
   NS_LOG_FUNCTION (this << size);
   m_packets.reserve (size);
@@ -222,13 +260,30 @@ uint32_t
 SummaryVectorHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
+  m_packets.clear ();
+  m_valid = false;
+  if (i.GetRemainingSize () < sizeof (uint32_t))
+    {
+      NS_LOG_LOGIC ("Truncated summary vector length");
+      return 0;
+    }
   uint32_t sm_length = i.ReadNtohU32 ();
+  // The length is only trusted once the IDs are known to be there
+  if (sm_length > i.GetRemainingSize () / sizeof (uint32_t)
+      || (m_maxSize != 0 && sm_length > m_maxSize))
+    {
+      NS_LOG_LOGIC ("Summary vector of " << sm_length << " IDs rejected, "
+                                         << i.GetRemainingSize ()
+                                         << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
   m_packets.reserve (sm_length);
   for (uint32_t j = 0; j < sm_length; ++j)
     {
       uint32_t tmp = i.ReadNtohU32 ();
       m_packets.push_back (tmp);
     }
+  m_valid = true;
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
 
@@ -275,6 +330,19 @@ SummaryVectorHeader::Size (void) const
 }
 
 
+void
+SummaryVectorHeader::SetMaxSize (uint32_t maxSize)
+{
+  NS_LOG_FUNCTION (this << maxSize);
+  m_maxSize = maxSize;
+}
+
+bool
+SummaryVectorHeader::IsValid () const
+{
+  return m_valid;
+}
+
 bool
 SummaryVectorHeader::Contains (const uint32_t pkt_ID) const
 {
@@ -286,6 +354,20 @@ SummaryVectorHeader::Contains (const uint32_t pkt_ID) const
 
 NS_OBJECT_ENSURE_REGISTERED (EpidemicHeader);
 
+EpidemicHeader::EpidemicHeader ()
+  : m_valid (true),
+    m_version (LEGACY),
+    m_packetID (0),
+    m_hopCount (0),
+    m_timeStamp (Seconds (0)),
+    m_flags (0),
+    m_bundleID (0),
+    m_chunkIndex (0),
+    m_chunkCount (0),
+    m_copies (0)
+{
+}
+
 EpidemicHeader::~EpidemicHeader ()
 {
 }
@@ -333,6 +415,166 @@ Time EpidemicHeader::GetTimeStamp () const
   return m_timeStamp;
 }
 
+void
+EpidemicHeader::SetChunk (uint32_t bundleID, uint16_t index, uint16_t count)
+{
+  NS_LOG_FUNCTION (this << bundleID << index << count);
+  m_flags |= CHUNK;
+  m_bundleID = bundleID;
+  m_chunkIndex = index;
+  m_chunkCount = count;
+}
+
+bool
+EpidemicHeader::IsChunk () const
+{
+  return (m_flags & CHUNK) != 0;
+}
+
+uint32_t
+EpidemicHeader::GetBundleID () const
+{
+  return m_bundleID;
+}
+
+uint16_t
+EpidemicHeader::GetChunkIndex () const
+{
+  return m_chunkIndex;
+}
+
+uint16_t
+EpidemicHeader::GetChunkCount () const
+{
+  return m_chunkCount;
+}
+
+uint32_t
+EpidemicHeader::GetChunkPacketID (uint16_t index) const
+{
+  // The counter part wraps around without touching the host part
+  return (m_bundleID & 0xFFFF0000) | ((m_bundleID + index) & 0xFFFF);
+}
+
+void
+EpidemicHeader::SetCoded ()
+{
+  NS_LOG_FUNCTION (this);
+  m_flags |= CODED;
+}
+
+bool
+EpidemicHeader::IsCoded () const
+{
+  return (m_flags & CODED) != 0;
+}
+
+void
+EpidemicHeader::SetCopies (uint32_t copies)
+{
+  NS_LOG_FUNCTION (this << copies);
+  m_flags |= COPIES;
+  m_copies = copies;
+}
+
+bool
+EpidemicHeader::HasCopies () const
+{
+  return (m_flags & COPIES) != 0;
+}
+
+uint32_t
+EpidemicHeader::GetCopies () const
+{
+  return m_copies;
+}
+
+void
+EpidemicHeader::SetVersion (Version version)
+{
+  NS_LOG_FUNCTION (this << version);
+  m_version = version;
+}
+
+EpidemicHeader::Version
+EpidemicHeader::GetVersion () const
+{
+  return m_version;
+}
+
+bool
+EpidemicHeader::IsValid () const
+{
+  return m_valid;
+}
+
+bool
+EpidemicHeader::IsCompact () const
+{
+  return m_version == COMPACT && m_hopCount <= 0xFF;
+}
+
+uint64_t
+EpidemicHeader::GetAge () const
+{
+  Time age = Simulator::Now () - m_timeStamp;
+  return age.IsStrictlyPositive () ? age.GetMilliSeconds () : 0;
+}
+
+/**
+ * \param value the value
+ * \returns the size of \p value as a LEB128 integer
+ */
+static uint32_t
+GetVarintSize (uint64_t value)
+{
+  uint32_t size = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      size++;
+    }
+  return size;
+}
+
+/**
+ * \brief Write a LEB128 integer.
+ * \param i the buffer iterator
+ * \param value the value
+ */
+static void
+WriteVarint (Buffer::Iterator &i, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      i.WriteU8 ((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+  i.WriteU8 (value);
+}
+
+/**
+ * \brief Read a LEB128 integer.
+ * \param i the buffer iterator
+ * \param value the value read
+ * \returns false if the buffer ends before the integer
+ */
+static bool
+ReadVarint (Buffer::Iterator &i, uint64_t &value)
+{
+  value = 0;
+  for (uint32_t shift = 0; shift < 64 && !i.IsEnd (); shift += 7)
+    {
+      uint8_t byte = i.ReadU8 ();
+      value |= uint64_t (byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
 
 TypeId
 EpidemicHeader::GetTypeId (void)
@@ -353,29 +595,187 @@ EpidemicHeader::GetInstanceTypeId () const
 uint32_t
 EpidemicHeader::GetSerializedSize () const
 {
-
-  return sizeof(m_packetID) + sizeof(m_hopCount) + sizeof(m_timeStamp);
+  if (IsCompact ())
+    {
+      uint32_t size = sizeof(m_packetID) + 2 * sizeof(uint8_t)
+        + GetVarintSize (GetAge ());
+      if (m_flags & CHUNK)
+        {
+          size += GetVarintSize (m_bundleID) + GetVarintSize (m_chunkIndex)
+            + GetVarintSize (m_chunkCount);
+        }
+      if (m_flags & COPIES)
+        {
+          size += GetVarintSize (m_copies);
+        }
+      return size;
+    }
+  uint32_t size = sizeof(m_packetID) + sizeof(m_hopCount) + sizeof(m_timeStamp);
+  if (m_flags & CHUNK)
+    {
+      size += sizeof(m_bundleID) + sizeof(m_chunkIndex) + sizeof(m_chunkCount);
+    }
+  if (m_flags & COPIES)
+    {
+      size += sizeof(m_copies);
+    }
+  return size;
 
 }
 
 void
 EpidemicHeader::Serialize (Buffer::Iterator i) const
 {
+  if (IsCompact ())
+    {
+      i.WriteHtonU32 (m_packetID);
+      i.WriteU8 ((COMPACT << 4) | (m_flags & 0x0F));
+      i.WriteU8 (m_hopCount);
+      WriteVarint (i, GetAge ());
+      if (m_flags & CHUNK)
+        {
+          WriteVarint (i, m_bundleID);
+          WriteVarint (i, m_chunkIndex);
+          WriteVarint (i, m_chunkCount);
+        }
+      if (m_flags & COPIES)
+        {
+          WriteVarint (i, m_copies);
+        }
+      return;
+    }
   i.WriteHtonU32 (m_packetID);
-  i.WriteHtonU32 (m_hopCount);
+  i.WriteHtonU32 ((uint32_t (m_flags) << 24) | (m_hopCount & 0xFFFFFF));
   i.WriteHtonU64 (m_timeStamp.GetNanoSeconds ());
+  if (m_flags & CHUNK)
+    {
+      i.WriteHtonU32 (m_bundleID);
+      i.WriteHtonU16 (m_chunkIndex);
+      i.WriteHtonU16 (m_chunkCount);
+    }
+  if (m_flags & COPIES)
+    {
+      i.WriteHtonU32 (m_copies);
+    }
+
+}
+
+bool
+EpidemicHeader::DeserializeLegacy (Buffer::Iterator &i)
+{
+  if (i.GetRemainingSize () < 16)
+    {
+      return false;
+    }
+  m_packetID = i.ReadNtohU32 ();
+  uint32_t hopCount = i.ReadNtohU32 ();
+  m_flags = hopCount >> 24;
+  m_hopCount = hopCount & 0xFFFFFF;
+  if (m_flags >> 4 != LEGACY)
+    {
+      return false;
+    }
+  m_timeStamp = Time (i.ReadNtohU64 ());
+  uint32_t optional = (m_flags & CHUNK ? 8 : 0) + (m_flags & COPIES ? 4 : 0);
+  if (i.GetRemainingSize () < optional)
+    {
+      return false;
+    }
+  if (m_flags & CHUNK)
+    {
+      m_bundleID = i.ReadNtohU32 ();
+      m_chunkIndex = i.ReadNtohU16 ();
+      m_chunkCount = i.ReadNtohU16 ();
+    }
+  if (m_flags & COPIES)
+    {
+      m_copies = i.ReadNtohU32 ();
+    }
+  return true;
+}
 
+bool
+EpidemicHeader::DeserializeCompact (Buffer::Iterator &i)
+{
+  if (i.GetRemainingSize () < sizeof(m_packetID) + 2 * sizeof(uint8_t))
+    {
+      return false;
+    }
+  m_packetID = i.ReadNtohU32 ();
+  m_flags = i.ReadU8 () & 0x0F;
+  m_hopCount = i.ReadU8 ();
+  uint64_t age;
+  // Ages past 2^42 ms would overflow the nanoseconds of Time
+  if (!ReadVarint (i, age) || age >= (uint64_t (1) << 42))
+    {
+      return false;
+    }
+  m_timeStamp = Simulator::Now () - MilliSeconds (age);
+  if (m_flags & CHUNK)
+    {
+      uint64_t bundleID;
+      uint64_t index;
+      uint64_t count;
+      if (!ReadVarint (i, bundleID) || !ReadVarint (i, index)
+          || !ReadVarint (i, count) || bundleID > 0xFFFFFFFF
+          || index > 0xFFFF || count > 0xFFFF)
+        {
+          return false;
+        }
+      m_bundleID = bundleID;
+      m_chunkIndex = index;
+      m_chunkCount = count;
+    }
+  if (m_flags & COPIES)
+    {
+      uint64_t copies;
+      if (!ReadVarint (i, copies) || copies > 0xFFFFFFFF)
+        {
+          return false;
+        }
+      m_copies = copies;
+    }
+  return true;
 }
 
 uint32_t
 EpidemicHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
-  m_packetID = i.ReadNtohU32 ();
-  m_hopCount = i.ReadNtohU32 ();
-  m_timeStamp = Time (i.ReadNtohU64 ());
+  // Both formats keep the version in the byte after the packet ID
+  Buffer::Iterator flags = start;
+  uint8_t version = LEGACY;
+  if (flags.GetRemainingSize () > sizeof(m_packetID))
+    {
+      flags.Next (sizeof(m_packetID));
+      version = flags.ReadU8 () >> 4;
+    }
+  if (version == COMPACT)
+    {
+      m_version = COMPACT;
+      m_valid = DeserializeCompact (i);
+    }
+  else
+    {
+      m_version = LEGACY;
+      m_valid = DeserializeLegacy (i);
+    }
   uint32_t dist = i.GetDistanceFrom (start);
-  NS_ASSERT (dist == GetSerializedSize ());
+  // Overlong integers would not serialize back to the same bytes
+  if (m_valid && dist != GetSerializedSize ())
+    {
+      m_valid = false;
+    }
+  if (m_valid && (m_flags & CHUNK) && m_chunkIndex >= m_chunkCount)
+    {
+      NS_LOG_LOGIC ("Chunk " << m_chunkIndex << " of " << m_chunkCount
+                             << " rejected");
+      m_valid = false;
+    }
+  if (!m_valid)
+    {
+      NS_LOG_LOGIC ("Invalid epidemic header of " << dist << " bytes");
+    }
   return dist;
 }
 
@@ -391,7 +791,888 @@ EpidemicHeader::Print (std::ostream &os) const
 {
   os << " Packet ID: " << m_packetID << " Hop count: " << m_hopCount
   << " TimeStamp: " << m_timeStamp;
+  if (m_flags & CHUNK)
+    {
+      os << " Chunk " << m_chunkIndex << "/" << m_chunkCount
+         << " of bundle " << m_bundleID;
+    }
+  if (m_flags & COPIES)
+    {
+      os << " Copies: " << m_copies;
+    }
+  if (IsCompact ())
+    {
+      os << " Compact";
+    }
+
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (BeaconHeader);
+
+BeaconHeader::BeaconHeader (Ipv4Address sender)
+  : m_sender (sender),
+    m_valid (true)
+{
+}
+
+BeaconHeader::~BeaconHeader ()
+{
+}
+
+void
+BeaconHeader::SetSender (Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << sender);
+  m_sender = sender;
+}
+
+Ipv4Address
+BeaconHeader::GetSender () const
+{
+  return m_sender;
+}
+
+bool
+BeaconHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+BeaconHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::BeaconHeader")
+    .SetParent<Header> ()
+    .AddConstructor<BeaconHeader> ();
+  return tid;
+}
+
+TypeId
+BeaconHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BeaconHeader::GetSerializedSize () const
+{
+  return sizeof(uint32_t);
+}
+
+void
+BeaconHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_sender);
+}
+
+uint32_t
+BeaconHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_valid = false;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      NS_LOG_LOGIC ("Truncated beacon header");
+      return 0;
+    }
+  ReadFrom (i, m_sender);
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+BeaconHeader::Print (std::ostream &os) const
+{
+  os << " Beacon sender: " << m_sender;
+}
 
+NS_OBJECT_ENSURE_REGISTERED (BundleHeader);
+
+BundleHeader::BundleHeader ()
+  : m_protocol (0),
+    m_ttl (0),
+    m_length (0),
+    m_valid (true)
+{
+}
+
+BundleHeader::BundleHeader (const Ipv4Header &header, uint16_t length)
+  : m_source (header.GetSource ()),
+    m_destination (header.GetDestination ()),
+    m_protocol (header.GetProtocol ()),
+    m_ttl (header.GetTtl ()),
+    m_length (length),
+    m_valid (true)
+{
+}
+
+BundleHeader::~BundleHeader ()
+{
+}
+
+Ipv4Header
+BundleHeader::GetIpv4Header () const
+{
+  Ipv4Header header;
+  header.SetSource (m_source);
+  header.SetDestination (m_destination);
+  header.SetProtocol (m_protocol);
+  header.SetTtl (m_ttl);
+  header.SetPayloadSize (m_length);
+  return header;
+}
+
+uint16_t
+BundleHeader::GetLength () const
+{
+  return m_length;
+}
+
+bool
+BundleHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+BundleHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::BundleHeader")
+    .SetParent<Header> ()
+    .AddConstructor<BundleHeader> ();
+  return tid;
+}
+
+TypeId
+BundleHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+BundleHeader::GetSerializedSize () const
+{
+  return 3 * sizeof(uint32_t);
+}
+
+void
+BundleHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_source);
+  WriteTo (i, m_destination);
+  i.WriteU8 (m_protocol);
+  i.WriteU8 (m_ttl);
+  i.WriteHtonU16 (m_length);
+}
+
+uint32_t
+BundleHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_valid = false;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      NS_LOG_LOGIC ("Truncated bundle header");
+      return 0;
+    }
+  ReadFrom (i, m_source);
+  ReadFrom (i, m_destination);
+  m_protocol = i.ReadU8 ();
+  m_ttl = i.ReadU8 ();
+  m_length = i.ReadNtohU16 ();
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+BundleHeader::Print (std::ostream &os) const
+{
+  os << " Bundle " << m_source << " > " << m_destination
+     << " protocol: " << (uint32_t) m_protocol
+     << " ttl: " << (uint32_t) m_ttl << " length: " << m_length;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (OptionHeader);
+
+OptionHeader::OptionHeader (uint8_t type, uint16_t length)
+  : m_type (type),
+    m_length (length),
+    m_valid (true)
+{
+}
+
+OptionHeader::~OptionHeader ()
+{
+}
+
+uint8_t
+OptionHeader::GetOptionType () const
+{
+  return m_type;
+}
+
+uint16_t
+OptionHeader::GetLength () const
+{
+  return m_length;
+}
+
+bool
+OptionHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+OptionHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::OptionHeader")
+    .SetParent<Header> ()
+    .AddConstructor<OptionHeader> ();
+  return tid;
+}
+
+TypeId
+OptionHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+OptionHeader::GetSerializedSize () const
+{
+  return sizeof(uint8_t) + sizeof(uint16_t);
+}
+
+void
+OptionHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_type);
+  i.WriteHtonU16 (m_length);
+}
+
+uint32_t
+OptionHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_valid = false;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      NS_LOG_LOGIC ("Truncated option header");
+      return 0;
+    }
+  m_type = i.ReadU8 ();
+  m_length = i.ReadNtohU16 ();
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+OptionHeader::Print (std::ostream &os) const
+{
+  os << " Option type: " << (uint32_t) m_type << " length: " << m_length;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (ContactHeader);
+
+/// Write a value in meters as signed centimeters
+static void
+WriteCentimeters (Buffer::Iterator &i, double value)
+{
+  i.WriteHtonU32 (static_cast<uint32_t> (
+                    static_cast<int32_t> (std::floor (value * 100 + 0.5))));
+}
+
+/// Read a value in meters written by WriteCentimeters
+static double
+ReadCentimeters (Buffer::Iterator &i)
+{
+  return static_cast<int32_t> (i.ReadNtohU32 ()) / 100.0;
+}
+
+ContactHeader::ContactHeader (Vector position, Vector velocity)
+  : m_position (position),
+    m_velocity (velocity),
+    m_valid (true)
+{
+}
+
+ContactHeader::~ContactHeader ()
+{
+}
+
+Vector
+ContactHeader::GetPosition () const
+{
+  return m_position;
+}
+
+Vector
+ContactHeader::GetVelocity () const
+{
+  return m_velocity;
+}
+
+bool
+ContactHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+ContactHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::ContactHeader")
+    .SetParent<Header> ()
+    .AddConstructor<ContactHeader> ();
+  return tid;
+}
+
+TypeId
+ContactHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ContactHeader::GetSerializedSize () const
+{
+  return 6 * sizeof(uint32_t);
+}
+
+void
+ContactHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteCentimeters (i, m_position.x);
+  WriteCentimeters (i, m_position.y);
+  WriteCentimeters (i, m_position.z);
+  WriteCentimeters (i, m_velocity.x);
+  WriteCentimeters (i, m_velocity.y);
+  WriteCentimeters (i, m_velocity.z);
+}
+
+uint32_t
+ContactHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_valid = false;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      NS_LOG_LOGIC ("Truncated contact option");
+      return 0;
+    }
+  m_position.x = ReadCentimeters (i);
+  m_position.y = ReadCentimeters (i);
+  m_position.z = ReadCentimeters (i);
+  m_velocity.x = ReadCentimeters (i);
+  m_velocity.y = ReadCentimeters (i);
+  m_velocity.z = ReadCentimeters (i);
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ContactHeader::Print (std::ostream &os) const
+{
+  os << " Position: " << m_position << " velocity: " << m_velocity;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (PredictabilityHeader);
+
+PredictabilityHeader::PredictabilityHeader (const PredictabilityList &entries)
+  : m_entries (entries),
+    m_valid (true)
+{
+  NS_ASSERT_MSG (entries.size () <= 0xFFFF, "Too many predictabilities");
+}
+
+PredictabilityHeader::~PredictabilityHeader ()
+{
+}
+
+const PredictabilityList &
+PredictabilityHeader::GetEntries () const
+{
+  return m_entries;
+}
+
+bool
+PredictabilityHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+PredictabilityHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::PredictabilityHeader")
+    .SetParent<Header> ()
+    .AddConstructor<PredictabilityHeader> ();
+  return tid;
+}
+
+TypeId
+PredictabilityHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PredictabilityHeader::GetSerializedSize () const
+{
+  return sizeof(uint16_t)
+         + m_entries.size () * (sizeof(uint32_t) + sizeof(uint8_t));
+}
+
+void
+PredictabilityHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_entries.size ());
+  for (PredictabilityList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      WriteTo (i, j->first);
+      double p = std::min (std::max (j->second, 0.0), 1.0);
+      i.WriteU8 (static_cast<uint8_t> (std::floor (p * 255 + 0.5)));
+    }
+}
+
+uint32_t
+PredictabilityHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_entries.clear ();
+  m_valid = false;
+  if (i.GetRemainingSize () < sizeof(uint16_t))
+    {
+      NS_LOG_LOGIC ("Truncated predictability count");
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  // The count is only trusted once the entries are known to be there
+  if (count > i.GetRemainingSize () / (sizeof(uint32_t) + sizeof(uint8_t)))
+    {
+      NS_LOG_LOGIC (count << " predictabilities rejected, "
+                          << i.GetRemainingSize () << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
+  m_entries.reserve (count);
+  for (uint16_t j = 0; j < count; ++j)
+    {
+      Ipv4Address node;
+      ReadFrom (i, node);
+      double p = i.ReadU8 () / 255.0;
+      m_entries.push_back (std::make_pair (node, p));
+    }
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+PredictabilityHeader::Print (std::ostream &os) const
+{
+  os << " Predictabilities:";
+  for (PredictabilityList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      os << " " << j->first << "=" << j->second;
+    }
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (CodingHeader);
+
+CodingHeader::CodingHeader (uint32_t generationID, uint16_t symbolSize,
+                            const std::vector<uint8_t> &coefficients)
+  : m_generationID (generationID),
+    m_symbolSize (symbolSize),
+    m_coefficients (coefficients),
+    m_valid (true)
+{
+  NS_ASSERT_MSG (coefficients.size () <= 0xFF, "Generation too large");
+}
+
+CodingHeader::~CodingHeader ()
+{
+}
+
+uint32_t
+CodingHeader::GetGenerationID () const
+{
+  return m_generationID;
+}
+
+uint16_t
+CodingHeader::GetSymbolSize () const
+{
+  return m_symbolSize;
+}
+
+const std::vector<uint8_t> &
+CodingHeader::GetCoefficients () const
+{
+  return m_coefficients;
+}
+
+bool
+CodingHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+CodingHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::CodingHeader")
+    .SetParent<Header> ()
+    .AddConstructor<CodingHeader> ();
+  return tid;
+}
+
+TypeId
+CodingHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+CodingHeader::GetSerializedSize () const
+{
+  return sizeof(m_generationID) + sizeof(uint8_t) + sizeof(m_symbolSize)
+         + m_coefficients.size ();
+}
+
+void
+CodingHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU32 (m_generationID);
+  i.WriteU8 (m_coefficients.size ());
+  i.WriteHtonU16 (m_symbolSize);
+  for (std::vector<uint8_t>::const_iterator j = m_coefficients.begin ();
+       j != m_coefficients.end (); ++j)
+    {
+      i.WriteU8 (*j);
+    }
+}
+
+uint32_t
+CodingHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_coefficients.clear ();
+  m_valid = false;
+  if (i.GetRemainingSize () < GetSerializedSize ())
+    {
+      NS_LOG_LOGIC ("Truncated coding header");
+      return 0;
+    }
+  m_generationID = i.ReadNtohU32 ();
+  uint8_t generationSize = i.ReadU8 ();
+  m_symbolSize = i.ReadNtohU16 ();
+  if (generationSize > i.GetRemainingSize ())
+    {
+      NS_LOG_LOGIC (static_cast<uint32_t> (generationSize)
+                    << " coefficients rejected, "
+                    << i.GetRemainingSize () << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
+  m_coefficients.resize (generationSize);
+  for (uint8_t j = 0; j < generationSize; ++j)
+    {
+      m_coefficients[j] = i.ReadU8 ();
+    }
+  m_valid = true;
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+CodingHeader::Print (std::ostream &os) const
+{
+  os << " Generation: " << m_generationID
+     << " size: " << m_coefficients.size ()
+     << " symbol size: " << m_symbolSize;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LinkStateHeader);
+
+LinkStateHeader::LinkStateHeader (const LinkStateList &entries)
+  : m_entries (entries),
+    m_valid (true)
+{
+  NS_ASSERT_MSG (entries.size () <= 0xFFFF, "Too many link-state entries");
+}
+
+LinkStateHeader::~LinkStateHeader ()
+{
+}
+
+const LinkStateList &
+LinkStateHeader::GetEntries () const
+{
+  return m_entries;
+}
+
+bool
+LinkStateHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+LinkStateHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::LinkStateHeader")
+    .SetParent<Header> ()
+    .AddConstructor<LinkStateHeader> ();
+  return tid;
+}
+
+TypeId
+LinkStateHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LinkStateHeader::GetSerializedSize () const
+{
+  uint32_t size = sizeof(uint16_t);
+  for (LinkStateList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      size += sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t)
+        + j->neighbors.size () * sizeof(uint32_t);
+    }
+  return size;
+}
+
+void
+LinkStateHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_entries.size ());
+  for (LinkStateList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      NS_ASSERT_MSG (j->neighbors.size () <= 0xFF, "Too many neighbors");
+      WriteTo (i, j->origin);
+      i.WriteHtonU16 (j->sequence);
+      i.WriteU8 (j->neighbors.size ());
+      for (std::vector<Ipv4Address>::const_iterator k = j->neighbors.begin ();
+           k != j->neighbors.end (); ++k)
+        {
+          WriteTo (i, *k);
+        }
+    }
+}
+
+uint32_t
+LinkStateHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_entries.clear ();
+  m_valid = false;
+  if (i.GetRemainingSize () < sizeof(uint16_t))
+    {
+      NS_LOG_LOGIC ("Truncated link-state entry count");
+      return 0;
+    }
+  uint16_t count = i.ReadNtohU16 ();
+  uint32_t entrySize = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t);
+  // The count is only trusted once the entries are known to be there
+  if (count > i.GetRemainingSize () / entrySize)
+    {
+      NS_LOG_LOGIC (count << " link-state entries rejected, "
+                          << i.GetRemainingSize () << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
+  m_entries.reserve (count);
+  for (uint16_t j = 0; j < count; ++j)
+    {
+      if (i.GetRemainingSize () < entrySize)
+        {
+          NS_LOG_LOGIC ("Truncated link-state entry");
+          m_entries.clear ();
+          return i.GetDistanceFrom (start);
+        }
+      LinkStateEntry entry;
+      ReadFrom (i, entry.origin);
+      entry.sequence = i.ReadNtohU16 ();
+      uint8_t neighbors = i.ReadU8 ();
+      if (neighbors > i.GetRemainingSize () / sizeof(uint32_t))
+        {
+          NS_LOG_LOGIC ("Truncated neighbor list");
+          m_entries.clear ();
+          return i.GetDistanceFrom (start);
+        }
+      entry.neighbors.resize (neighbors);
+      for (uint8_t k = 0; k < neighbors; ++k)
+        {
+          ReadFrom (i, entry.neighbors[k]);
+        }
+      m_entries.push_back (entry);
+    }
+  m_valid = true;
+  return i.GetDistanceFrom (start);
+}
+
+void
+LinkStateHeader::Print (std::ostream &os) const
+{
+  os << " Link state:";
+  for (LinkStateList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      os << " " << j->origin << "#" << j->sequence << " ("
+         << j->neighbors.size () << " neighbors)";
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (DeliveredHeader);
+
+DeliveredHeader::DeliveredHeader (const DeliveredList &entries)
+  : m_words (0),
+    m_entries (entries),
+    m_valid (true)
+{
+  NS_ASSERT_MSG (entries.size () <= 0xFFFF, "Too many delivered windows");
+  if (!entries.empty ())
+    {
+      NS_ASSERT_MSG (entries.front ().bits.size () <= 0xFFFF,
+                     "Delivered window too large");
+      m_words = entries.front ().bits.size ();
+    }
+}
+
+DeliveredHeader::~DeliveredHeader ()
+{
+}
+
+const DeliveredList &
+DeliveredHeader::GetEntries () const
+{
+  return m_entries;
+}
+
+bool
+DeliveredHeader::IsValid () const
+{
+  return m_valid;
+}
+
+TypeId
+DeliveredHeader::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::Epidemic::DeliveredHeader")
+    .SetParent<Header> ()
+    .AddConstructor<DeliveredHeader> ();
+  return tid;
+}
+
+TypeId
+DeliveredHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+DeliveredHeader::GetSerializedSize () const
+{
+  return 2 * sizeof(uint16_t) + m_entries.size ()
+         * (2 * sizeof(uint16_t) + m_words * sizeof(uint64_t));
+}
+
+void
+DeliveredHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU16 (m_words);
+  i.WriteHtonU16 (m_entries.size ());
+  for (DeliveredList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      NS_ASSERT_MSG (j->bits.size () == m_words, "Windows of different sizes");
+      i.WriteHtonU16 (j->source);
+      i.WriteHtonU16 (j->highest);
+      for (std::vector<uint64_t>::const_iterator k = j->bits.begin ();
+           k != j->bits.end (); ++k)
+        {
+          i.WriteHtonU64 (*k);
+        }
+    }
+}
+
+uint32_t
+DeliveredHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_words = 0;
+  m_entries.clear ();
+  m_valid = false;
+  if (i.GetRemainingSize () < 2 * sizeof(uint16_t))
+    {
+      NS_LOG_LOGIC ("Truncated delivered windows");
+      return 0;
+    }
+  uint16_t words = i.ReadNtohU16 ();
+  uint16_t count = i.ReadNtohU16 ();
+  uint32_t entrySize = 2 * sizeof(uint16_t) + words * sizeof(uint64_t);
+  // The count is only trusted once the entries are known to be there
+  if (count > i.GetRemainingSize () / entrySize)
+    {
+      NS_LOG_LOGIC (count << " delivered windows rejected, "
+                          << i.GetRemainingSize () << " bytes left");
+      return i.GetDistanceFrom (start);
+    }
+  m_words = words;
+  m_entries.resize (count);
+  for (uint16_t j = 0; j < count; ++j)
+    {
+      DeliveredEntry &entry = m_entries[j];
+      entry.source = i.ReadNtohU16 ();
+      entry.highest = i.ReadNtohU16 ();
+      entry.bits.resize (words);
+      for (uint16_t k = 0; k < words; ++k)
+        {
+          entry.bits[k] = i.ReadNtohU64 ();
+        }
+    }
+  m_valid = true;
+  return i.GetDistanceFrom (start);
+}
+
+void
+DeliveredHeader::Print (std::ostream &os) const
+{
+  os << " Delivered windows of " << m_words * 64 << ":";
+  for (DeliveredList::const_iterator j = m_entries.begin ();
+       j != m_entries.end (); ++j)
+    {
+      os << " " << j->source << "#" << j->highest;
+    }
 }
 } //end namespace epidemic
 } //end namespace ns3
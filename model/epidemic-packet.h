@@ -33,8 +33,11 @@
 
 
 #include <iostream>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/vector.h"
+#include "ns3/ipv4-header.h"
 #include "ns3/nstime.h"
 #include "algorithm"
 
@@ -73,9 +76,12 @@ namespace Epidemic {
    0
    0 1 2 3 4 5 6 7
    +-+-+-+-+-+-+-+-+
-   |     Type      |
+   |Version| Type  |
    +-+-+-+-+-+-+-+-+
   \endverbatim
+ *
+ * The version is 0, or 1 for a node sending compact headers.  A compact
+ * beacon is this byte alone, without the EpidemicHeader of a legacy one.
 */
 class TypeHeader : public Header
 {
@@ -86,6 +92,7 @@ public:
     BEACON,     //!< Advertise the presence of a node
     REPLY,      //!< Reply to a beacon, with the packet Id summary vector
     REPLY_BACK, //!< Response to a Reply packet, as list of disjoint packets.
+    AGGREGATE,  //!< Several data packets, each behind a BundleHeader
 
   };
 
@@ -117,6 +124,13 @@ public:
 
   /// \returns The message type.
   MessageType GetMessageType () const;
+  /**
+   * \brief Set the version of the message
+   * \param compact true for a node sending compact headers
+   */
+  void SetCompact (bool compact);
+  /// \returns true if the message is in the compact format
+  bool IsCompact () const;
   /**
    *  Check that this is a message of the expected type.
    *
@@ -135,6 +149,8 @@ public:
 private:
   /// message type
   MessageType m_type;
+  /// true if the version is the compact one
+  bool m_compact;
   /**
   Valid flag: \c true if the message deserialized correctly.
   otherwise \c false.
@@ -224,16 +240,29 @@ public:
    * \return The number of global packet IDs in this header.
    */
   size_t Size (void) const;
+  /**
+   * Set the largest number of IDs accepted by Deserialize.
+   *
+   * \param maxSize The number of IDs, 0 only limits them to the buffer.
+   */
+  void SetMaxSize (uint32_t maxSize);
+  /**
+   * Check the last deserialization.
+   *
+   * \return False if the length did not fit the buffer or the limit, in
+   *  which case the header holds no IDs.
+   */
+  bool IsValid () const;
 
 private:
   /**
    * A vector to store packet IDs.
    */
   std::vector<uint32_t> m_packets;
-
-  // RoutingProtocol::SendDisjointPackets
-  // needs to iterate through the vector
-  friend class RoutingProtocol;
+  /// Largest number of IDs accepted by Deserialize, 0 for no limit
+  uint32_t m_maxSize;
+  /// true if the header deserialized correctly
+  bool m_valid;
 
 };
 
@@ -271,10 +300,27 @@ std::ostream &operator<< (std::ostream& os,
  *     It is flood control parameter used to set the number of hops
  *     the packet can travel before it is discarded. It is similar to TTL
  *     field but with higher size limit.
+ *     The most significant byte of the hop count field holds flags, so
+ *     the hop count itself is limited to 24 bits.
  *  3. Timestamp:
  *
  *     It show when the packet is generated.  This field is used
  *     to discard old packets with a time threshold limit set by the user.
+ *  4. Chunk descriptor:
+ *
+ *     Present if the CHUNK flag is set.  Large packets are split into
+ *     chunks at the source, and each chunk gets its own consecutive packet
+ *     ID.  The descriptor holds the packet ID of the first chunk, which
+ *     identifies the bundle, the index of the chunk and the number of
+ *     chunks.
+ *  5. Copies:
+ *
+ *     Present if the COPIES flag is set.  Number of copies of the packet
+ *     the holder may still hand out in Spray-and-Wait mode.  It is split
+ *     with the peer each time the holder sends the packet.
+ *
+ *  If the CODED flag is set, the packet carries a CodingHeader and a
+ *  coded symbol instead of the original payload.
  *
  *  The complete header is formatted as follows:
   \verbatim
@@ -283,16 +329,56 @@ std::ostream &operator<< (std::ostream& os,
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                         Packet ID                             |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  |                         Hop Count                             |
+  |     Flags     |                 Hop Count                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                     64 Bit Timestamp                          |
   |                                                               |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                 Bundle ID (if CHUNK is set)                   |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |          Chunk Index          |          Chunk Count          |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                  Copies (if COPIES is set)                    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
+ *
+ *  The high nibble of the flags byte holds the format version, 0 for the
+ *  format above.  The compact format (version 1) keeps the packet ID and
+ *  the flags byte in place, followed by a one-byte hop count, the age of
+ *  the packet in milliseconds and the optional fields as LEB128
+ *  variable-length integers:
+  \verbatim
+  +-----------+---------+-----------+-----------+------------------------+
+  | Packet ID | Version | Hop Count | Age (ms)  | Bundle ID, Index,      |
+  | (32 bits) | | Flags | (8 bits)  | (varint)  | Count, Copies (varint) |
+  +-----------+---------+-----------+-----------+------------------------+
+  \endverbatim
+ *  The age is the time since the timestamp when the header is written,
+ *  and the timestamp is the time of reading minus the age.  A header with
+ *  a hop count above 255 is written in the legacy format.  A header is
+ *  always deserialized in the format it was sent in, and a relay sends it
+ *  on in the same format.
  */
 class EpidemicHeader : public Header
 {
 public:
+  /// Wire format versions
+  enum Version
+  {
+    LEGACY = 0,  //!< fixed 16-byte format
+    COMPACT = 1, //!< variable-length format with the age of the packet
+  };
+  /// Flags carried in the top byte of the hop count field
+  enum Flags
+  {
+    CHUNK = 0x01,  //!< the packet is a chunk of a larger bundle
+    CODED = 0x02,  //!< a CodingHeader and a coded symbol follow
+    COPIES = 0x04, //!< the packet carries a copy budget
+  };
+  /**
+   * \brief Constructor.
+   */
+  EpidemicHeader ();
   /**
    * \brief Destructor.
    */
@@ -339,12 +425,110 @@ public:
    */
   Time GetTimeStamp () const;
 
-
+  /**
+   * \brief Mark the packet as a chunk of a bundle
+   * \param bundleID the packet ID of the first chunk
+   * \param index the index of this chunk
+   * \param count the number of chunks of the bundle
+   */
+  void SetChunk (uint32_t bundleID, uint16_t index, uint16_t count);
+  /**
+   * \brief Check for the chunk descriptor
+   * \return true if the packet is a chunk of a bundle
+   */
+  bool IsChunk () const;
+  /**
+   * \brief Get the bundle ID, valid if IsChunk ()
+   * \return the packet ID of the first chunk
+   */
+  uint32_t GetBundleID () const;
+  /**
+   * \brief Get the chunk index, valid if IsChunk ()
+   * \return index of this chunk
+   */
+  uint16_t GetChunkIndex () const;
+  /**
+   * \brief Get the chunk count, valid if IsChunk ()
+   * \return number of chunks of the bundle
+   */
+  uint16_t GetChunkCount () const;
+  /**
+   * \brief Get the packet ID of a chunk of the same bundle.
+   *  Chunks use consecutive values of the 16-bit packet counter.
+   * \param index the index of the chunk
+   * \return the packet ID of the chunk
+   */
+  uint32_t GetChunkPacketID (uint16_t index) const;
+  /**
+   * \brief Mark the packet as a coded symbol followed by a CodingHeader
+   */
+  void SetCoded ();
+  /**
+   * \brief Check for the CODED flag
+   * \return true if the packet is a coded symbol
+   */
+  bool IsCoded () const;
+  /**
+   * \brief Set the copy budget of the packet and the COPIES flag
+   * \param copies number of copies the holder may hand out
+   */
+  void SetCopies (uint32_t copies);
+  /**
+   * \brief Check for the copy budget
+   * \return true if the packet carries a copy budget
+   */
+  bool HasCopies () const;
+  /**
+   * \brief Get the copy budget, valid if HasCopies ()
+   * \return number of copies the holder may hand out
+   */
+  uint32_t GetCopies () const;
+  /**
+   * \brief Set the wire format of the header
+   * \param version LEGACY or COMPACT, which applies only to hop counts
+   *  up to 255
+   */
+  void SetVersion (Version version);
+  /**
+   * \brief Get the wire format of the header
+   * \return the format the header is serialized in
+   */
+  Version GetVersion () const;
+  /**
+   * \brief Check the last deserialization
+   * \return false if the buffer ended inside the header or a field was
+   *  out of range
+   */
+  bool IsValid () const;
 
 private:
+  /**
+   * \brief Read the fields of a legacy header.
+   * \param i the buffer iterator, left after the bytes read
+   * \return false if the buffer is too short
+   */
+  bool DeserializeLegacy (Buffer::Iterator &i);
+  /**
+   * \brief Read the fields of a compact header.
+   * \param i the buffer iterator, left after the bytes read
+   * \return false if the buffer is too short or a field is out of range
+   */
+  bool DeserializeCompact (Buffer::Iterator &i);
+  /// \return true if the header is written in the compact format
+  bool IsCompact () const;
+  /// \return the age of the packet in milliseconds, as written now
+  uint64_t GetAge () const;
+
+  bool m_valid;             ///< true if the header deserialized correctly
+  Version m_version;        ///< wire format
   uint32_t m_packetID;      ///< global packet ID
   uint32_t m_hopCount;      ///< Count to keep track of number of traveled hops
   Time m_timeStamp;         ///< Time at which packet was originated
+  uint8_t m_flags;          ///< Flags
+  uint32_t m_bundleID;      ///< packet ID of the first chunk
+  uint16_t m_chunkIndex;    ///< index of this chunk
+  uint16_t m_chunkCount;    ///< number of chunks of the bundle
+  uint32_t m_copies;        ///< copy budget
 
 
 };
@@ -360,6 +544,554 @@ private:
 std::ostream &operator<< (std::ostream& os,
                           const EpidemicHeader & header);
 
+/**
+ * \ingroup epidemic
+ * \brief Epidemic link-layer beacon header
+ *
+ *  When beacons are sent as raw link-layer frames, they bypass UDP and IP
+ *  and the receiver can no longer learn the sender from the socket
+ *  address.  This header follows the TypeHeader of such a beacon and
+ *  carries the IP address the sender uses for the anti-entropy session.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                     Sender IPv4 Address                       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class BeaconHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param sender the IP address of the beacon sender.
+   */
+  BeaconHeader (Ipv4Address sender = Ipv4Address ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~BeaconHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Set the IP address of the beacon sender
+   */
+  void SetSender (Ipv4Address sender);
+  /**
+   * \brief Get the IP address of the beacon sender
+   * \return sender address
+   */
+  Ipv4Address GetSender () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the buffer ended inside the header
+   */
+  bool IsValid () const;
+
+private:
+  Ipv4Address m_sender;     ///< IP address of the beacon sender
+  bool m_valid;             ///< true if the header deserialized correctly
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Header of a data packet inside an AGGREGATE message
+ *
+ *  Each packet in an AGGREGATE message is preceded by this header,
+ *  which carries the IPv4 header fields needed to store and forward it.
+ *  The length counts the packet from its EpidemicHeader on.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                     Source IPv4 Address                       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                   Destination IPv4 Address                    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   Protocol    |      TTL      |            Length             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class BundleHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   */
+  BundleHeader ();
+  /**
+   * \brief Constructor from the IPv4 header of a queued packet.
+   * \param header the IPv4 header of the packet.
+   * \param length the length of the packet in bytes.
+   */
+  BundleHeader (const Ipv4Header &header, uint16_t length);
+  /**
+   * \brief Destructor.
+   */
+  virtual ~BundleHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get an IPv4 header with the carried fields
+   * \return IPv4 header
+   */
+  Ipv4Header GetIpv4Header () const;
+  /**
+   * \brief Get the length of the packet following this header
+   * \return length in bytes
+   */
+  uint16_t GetLength () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the buffer ended inside the header
+   */
+  bool IsValid () const;
+
+private:
+  Ipv4Address m_source;       ///< IP source of the packet
+  Ipv4Address m_destination;  ///< IP destination of the packet
+  uint8_t m_protocol;         ///< IP protocol of the packet
+  uint8_t m_ttl;              ///< IP TTL of the packet
+  uint16_t m_length;          ///< length of the packet
+  bool m_valid;               ///< true if the header deserialized correctly
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Header of an option following a summary vector
+ *
+ *  REPLY and REPLY_BACK messages may carry options after their
+ *  SummaryVectorHeader.  Each option starts with this header, followed by
+ *  \c length bytes of value.  Options of unknown type are skipped.
+  \verbatim
+  0                   1                   2
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |     Type      |            Length             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class OptionHeader : public Header
+{
+public:
+  /// Option types
+  enum OptionType
+  {
+    CONTACT = 1,  //!< ContactHeader with position and velocity
+    PREDICTABILITY = 2,  //!< PredictabilityHeader of the sender
+    ENCOUNTER = 3,  //!< PredictabilityHeader with encounter probabilities
+    DELIVERED = 4,  //!< DeliveredHeader with the packets delivered to the sender
+    RETRANSMISSION = 5,  //!< No value, the REPLY is a retransmission
+  };
+  /**
+   * \brief Constructor.
+   * \param type the option type.
+   * \param length the length of the option value in bytes.
+   */
+  OptionHeader (uint8_t type = 0, uint16_t length = 0);
+  /**
+   * \brief Destructor.
+   */
+  virtual ~OptionHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the option type
+   * \return option type
+   */
+  uint8_t GetOptionType () const;
+  /**
+   * \brief Get the length of the option value
+   * \return length in bytes
+   */
+  uint16_t GetLength () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the buffer ended inside the header
+   */
+  bool IsValid () const;
+
+private:
+  uint8_t m_type;           ///< option type
+  uint16_t m_length;        ///< length of the option value
+  bool m_valid;             ///< true if the header deserialized correctly
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Position and velocity of the sender of a summary vector
+ *
+ *  Carried as OptionHeader::CONTACT.  Coordinates are in centimeters and
+ *  velocities in centimeters per second, as signed 32-bit integers.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                          Position X                           |
+  |                          Position Y                           |
+  |                          Position Z                           |
+  |                          Velocity X                           |
+  |                          Velocity Y                           |
+  |                          Velocity Z                           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class ContactHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param position the position of the sender in meters.
+   * \param velocity the velocity of the sender in meters per second.
+   */
+  ContactHeader (Vector position = Vector (), Vector velocity = Vector ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~ContactHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the position of the sender
+   * \return position in meters
+   */
+  Vector GetPosition () const;
+  /**
+   * \brief Get the velocity of the sender
+   * \return velocity in meters per second
+   */
+  Vector GetVelocity () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the buffer ended inside the header
+   */
+  bool IsValid () const;
+
+private:
+  Vector m_position;        ///< position of the sender
+  Vector m_velocity;        ///< velocity of the sender
+  bool m_valid;             ///< true if the header deserialized correctly
+};
+
+/// List of destinations and delivery predictabilities
+typedef std::vector<std::pair<Ipv4Address, double> > PredictabilityList;
+
+/**
+ * \ingroup epidemic
+ * \brief Delivery predictabilities of the sender of a summary vector
+ *
+ *  Carried as OptionHeader::PREDICTABILITY in PRoPHET mode, and as
+ *  OptionHeader::ENCOUNTER with encounter probabilities in MaxProp mode.
+ *  Each entry is a destination address followed by its predictability
+ *  quantized to 1/255.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |        Entry Count            |    Destination 1 ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       ... Destination 1          | Predictability|      ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class PredictabilityHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param entries the destinations and their predictabilities.
+   */
+  PredictabilityHeader (const PredictabilityList &entries =
+                          PredictabilityList ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~PredictabilityHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the entries
+   * \return the destinations and their predictabilities
+   */
+  const PredictabilityList & GetEntries () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the entries did not fit in the buffer
+   */
+  bool IsValid () const;
+
+private:
+  PredictabilityList m_entries;   ///< destinations and predictabilities
+  bool m_valid;                   ///< true if the header deserialized correctly
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Coding vector of a network-coded packet
+ *
+ *  Follows an EpidemicHeader with the CODED flag.  The payload after this
+ *  header is a linear combination over GF(2^8) of the source symbols of
+ *  one generation, with one coefficient per source symbol.  Each source
+ *  symbol is a packet prefixed with its 16-bit length and padded with
+ *  zeros to the symbol size.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                        Generation ID                          |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |Generation Size|          Symbol Size          | Coefficients  |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                              ...                              |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class CodingHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param generationID the ID of the generation.
+   * \param symbolSize the size of the coded symbol in bytes.
+   * \param coefficients one coefficient per source symbol.
+   */
+  CodingHeader (uint32_t generationID = 0, uint16_t symbolSize = 0,
+                const std::vector<uint8_t> &coefficients =
+                  std::vector<uint8_t> ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~CodingHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the generation ID
+   * \return the packet ID of the first packet of the generation
+   */
+  uint32_t GetGenerationID () const;
+  /**
+   * \brief Get the symbol size
+   * \return size of the coded symbol in bytes
+   */
+  uint16_t GetSymbolSize () const;
+  /**
+   * \brief Get the coding coefficients
+   * \return one coefficient per source symbol
+   */
+  const std::vector<uint8_t> & GetCoefficients () const;
+
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the coefficients did not fit in the buffer
+   */
+  bool IsValid () const;
+
+private:
+  uint32_t m_generationID;               ///< ID of the generation
+  uint16_t m_symbolSize;                 ///< size of the coded symbol
+  std::vector<uint8_t> m_coefficients;   ///< coding coefficients
+  bool m_valid;                          ///< true if the header deserialized correctly
+};
+
+/// Neighbors heard by one node, as flooded in hybrid mode
+struct LinkStateEntry
+{
+  Ipv4Address origin;                  ///< node that heard the neighbors
+  uint16_t sequence;                   ///< sequence number of the origin
+  std::vector<Ipv4Address> neighbors;  ///< neighbors heard by the origin
+};
+
+/// List of link-state entries
+typedef std::vector<LinkStateEntry> LinkStateList;
+
+/**
+ * \ingroup epidemic
+ * \brief Link-state entries carried by beacons in hybrid mode
+ *
+ *  Follows the EpidemicHeader of a UDP beacon or the BeaconHeader of a
+ *  link-layer beacon.  Each entry lists the neighbors heard by its origin,
+ *  with a sequence number that the origin increments on each beacon.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |        Entry Count            |         Origin 1 ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+       ... Origin 1               |        Sequence 1             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |Neighbor Count |               Neighbor 1 ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class LinkStateHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param entries the link-state entries.
+   */
+  LinkStateHeader (const LinkStateList &entries = LinkStateList ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~LinkStateHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the entries
+   * \return the link-state entries
+   */
+  const LinkStateList & GetEntries () const;
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the entries did not fit in the buffer
+   */
+  bool IsValid () const;
+
+private:
+  LinkStateList m_entries;   ///< link-state entries
+  bool m_valid;              ///< true if the header deserialized correctly
+};
+
+/// Window of the packets delivered from one source
+struct DeliveredEntry
+{
+  uint16_t source;              ///< low 16 bits of the source address
+  uint16_t highest;             ///< highest sequence number delivered
+  std::vector<uint64_t> bits;   ///< bit i is set if highest - i was delivered
+};
+
+/// List of delivered windows
+typedef std::vector<DeliveredEntry> DeliveredList;
+
+/**
+ * \ingroup epidemic
+ * \brief Windows of the packets delivered to the sender of a summary vector
+ *
+ *  Carried as OptionHeader::DELIVERED by nodes with a DeliveredWindow,
+ *  whose delivered packets are not listed in their summary vector.  All
+ *  windows have the same number of 64-bit words.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |         Word Count            |         Entry Count           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |           Source 1            |          Highest 1            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Words 1 ...                           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class DeliveredHeader : public Header
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param entries the delivered windows, all of the same size.
+   */
+  DeliveredHeader (const DeliveredList &entries = DeliveredList ());
+  /**
+   * \brief Destructor.
+   */
+  virtual ~DeliveredHeader ();
+  /**
+   *  \brief Get the registered TypeId for this class.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+  // Inherited
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize () const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Get the entries
+   * \return the delivered windows
+   */
+  const DeliveredList & GetEntries () const;
+  /**
+   * \brief Check that the last Deserialize read a whole header.
+   * \return false if the entries did not fit in the buffer
+   */
+  bool IsValid () const;
+
+private:
+  uint16_t m_words;          ///< words of each window
+  DeliveredList m_entries;   ///< delivered windows
+  bool m_valid;              ///< true if the header deserialized correctly
+};
+
 } //end namespace epidemic
 } //end namespace ns3
 #endif
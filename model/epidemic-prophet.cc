@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#include "epidemic-prophet.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::PredictabilityTable implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicProphet");
+
+namespace Epidemic {
+
+PredictabilityTable::PredictabilityTable ()
+  : m_init (0.75),
+    m_beta (0.25),
+    m_gamma (0.98),
+    m_timeUnit (Seconds (30)),
+    m_lastAged (Seconds (0))
+{
+}
+
+void
+PredictabilityTable::SetParameters (double init, double beta, double gamma,
+                                    Time timeUnit)
+{
+  NS_LOG_FUNCTION (this << init << beta << gamma << timeUnit);
+  m_init = init;
+  m_beta = beta;
+  m_gamma = gamma;
+  m_timeUnit = timeUnit;
+}
+
+uint32_t
+PredictabilityTable::GetIndex (Ipv4Address node)
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (node);
+  if (i != m_index.end ())
+    {
+      return i->second;
+    }
+  uint32_t index = m_nodes.size ();
+  m_index[node] = index;
+  m_nodes.push_back (node);
+  m_predictability.push_back (0);
+  return index;
+}
+
+int32_t
+PredictabilityTable::FindIndex (Ipv4Address node) const
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (node);
+  if (i == m_index.end ())
+    {
+      return -1;
+    }
+  return i->second;
+}
+
+void
+PredictabilityTable::Age ()
+{
+  Time now = Simulator::Now ();
+  if (now <= m_lastAged || !m_timeUnit.IsStrictlyPositive ())
+    {
+      return;
+    }
+  double factor = std::pow (m_gamma, (now - m_lastAged).GetSeconds ()
+                            / m_timeUnit.GetSeconds ());
+  for (std::vector<double>::iterator i = m_predictability.begin ();
+       i != m_predictability.end (); ++i)
+    {
+      *i *= factor;
+    }
+  m_lastAged = now;
+}
+
+void
+PredictabilityTable::Update (Ipv4Address peer,
+                             const PredictabilityList &peerTable)
+{
+  NS_LOG_FUNCTION (this << peer << peerTable.size ());
+  Age ();
+  uint32_t b = GetIndex (peer);
+  m_predictability[b] += (1 - m_predictability[b]) * m_init;
+  if (m_peerPredictability.size () <= b)
+    {
+      m_peerPredictability.resize (b + 1);
+    }
+  std::vector<double> row;
+  for (PredictabilityList::const_iterator i = peerTable.begin ();
+       i != peerTable.end (); ++i)
+    {
+      if (i->first == peer)
+        {
+          continue;
+        }
+      uint32_t c = GetIndex (i->first);
+      m_predictability[c] = std::max (m_predictability[c],
+                                      m_predictability[b] * i->second * m_beta);
+      if (row.size () <= c)
+        {
+          row.resize (c + 1, 0);
+        }
+      row[c] = i->second;
+    }
+  m_peerPredictability[b].swap (row);
+}
+
+double
+PredictabilityTable::Get (Ipv4Address node)
+{
+  Age ();
+  int32_t index = FindIndex (node);
+  return index < 0 ? 0 : m_predictability[index];
+}
+
+double
+PredictabilityTable::GetPeer (Ipv4Address peer, Ipv4Address node) const
+{
+  int32_t b = FindIndex (peer);
+  int32_t c = FindIndex (node);
+  if (b < 0 || c < 0 || m_peerPredictability.size () <= (uint32_t) b
+      || m_peerPredictability[b].size () <= (uint32_t) c)
+    {
+      return 0;
+    }
+  return m_peerPredictability[b][c];
+}
+
+PredictabilityList
+PredictabilityTable::GetEntries (double threshold)
+{
+  Age ();
+  PredictabilityList entries;
+  for (uint32_t i = 0; i < m_nodes.size (); ++i)
+    {
+      if (m_predictability[i] >= threshold)
+        {
+          entries.push_back (std::make_pair (m_nodes[i], m_predictability[i]));
+        }
+    }
+  return entries;
+}
+
+uint32_t
+PredictabilityTable::GetSize () const
+{
+  return m_nodes.size ();
+}
+
+} //end namespace epidemic
+} //end namespace ns3
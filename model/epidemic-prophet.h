@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+
+#ifndef EPIDEMIC_PROPHET_H
+#define EPIDEMIC_PROPHET_H
+
+#include <map>
+#include <vector>
+#include "epidemic-packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::PredictabilityTable declaration.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief PRoPHET delivery predictabilities of a node
+ *
+ *  Keeps the predictability P(a,b) that this node a delivers a packet to
+ *  node b, and the last table received from each peer.  Encounters raise
+ *  P(a,b) by (1 - P(a,b)) * Pinit, every value decays by gamma per time
+ *  unit, and P(a,c) is raised to at least P(a,b) * P(b,c) * beta when
+ *  peer b reports P(b,c) (transitivity).
+ *
+ *  Nodes get a dense index on first use and all values are kept in flat
+ *  vectors indexed by it, so lookups during a transfer and aging of the
+ *  whole table walk contiguous memory.
+ */
+class PredictabilityTable
+{
+public:
+  PredictabilityTable ();
+  /**
+   * \brief Set the PRoPHET parameters.
+   * \param init Pinit, the predictability gained per encounter
+   * \param beta the scaling of transitive predictabilities
+   * \param gamma the decay per time unit
+   * \param timeUnit the aging time unit
+   */
+  void SetParameters (double init, double beta, double gamma, Time timeUnit);
+  /**
+   * \brief Update the table with an encounter of a peer.
+   *  Ages the table, applies the encounter and the transitivity of the
+   *  peer's table, and keeps the peer's table for GetPeer.
+   * \param peer the address of the peer
+   * \param peerTable the predictabilities reported by the peer, without
+   *  entries for this node
+   */
+  void Update (Ipv4Address peer, const PredictabilityList &peerTable);
+  /**
+   * \brief Get the predictability of delivering to a node.
+   * \param node the destination
+   * \returns P(this node, node), 0 if unknown
+   */
+  double Get (Ipv4Address node);
+  /**
+   * \brief Get the predictability last reported by a peer.
+   * \param peer the address of the peer
+   * \param node the destination
+   * \returns P(peer, node) from the peer's last table, 0 if unknown
+   */
+  double GetPeer (Ipv4Address peer, Ipv4Address node) const;
+  /**
+   * \brief Get the aged table for a peer.
+   * \param threshold entries below this value are left out
+   * \returns the destinations and their predictabilities
+   */
+  PredictabilityList GetEntries (double threshold);
+  /// \returns the number of nodes in the table
+  uint32_t GetSize () const;
+
+private:
+  /// \returns the dense index of \p node, created on first use
+  uint32_t GetIndex (Ipv4Address node);
+  /// \returns the dense index of \p node, or -1 if it has none
+  int32_t FindIndex (Ipv4Address node) const;
+  /// Decay all predictabilities to the current time
+  void Age ();
+
+  /// Pinit
+  double m_init;
+  /// Transitivity scaling
+  double m_beta;
+  /// Decay per time unit
+  double m_gamma;
+  /// Aging time unit
+  Time m_timeUnit;
+  /// Last time the table was aged
+  Time m_lastAged;
+  /// Dense index of every known node
+  std::map<Ipv4Address, uint32_t> m_index;
+  /// Node of every index
+  std::vector<Ipv4Address> m_nodes;
+  /// P(this node, node) by index
+  std::vector<double> m_predictability;
+  /// Last table of each peer by peer index, then node index
+  std::vector<std::vector<double> > m_peerPredictability;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
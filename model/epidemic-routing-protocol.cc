@@ -39,7 +39,10 @@
 #include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include "ns3/udp-header.h"
+#include "ns3/mobility-model.h"
+#include <cmath>
 #include <iostream>
 #include <algorithm>
 #include <functional>
@@ -75,7 +78,7 @@ TypeId RoutingProtocol::GetTypeId (void)
                    "a packet will be flooded.",
                    UintegerValue (64),
                    MakeUintegerAccessor (&RoutingProtocol::m_hopCount),
-                   MakeUintegerChecker<uint32_t> ())
+                   MakeUintegerChecker<uint32_t> (0, 0xFFFFFF))
     .AddAttribute ("QueueLength","Maximum number of "
                    "packets that a queue can hold.",
                    UintegerValue (64),
@@ -100,7 +103,209 @@ TypeId RoutingProtocol::GetTypeId (void)
                    " random time added to avoid collisions. Measured in milliseconds",
                    UintegerValue (100),
                    MakeUintegerAccessor (&RoutingProtocol::m_beaconMaxJitterMs),
-                   MakeUintegerChecker<uint32_t> ());
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SharedBeaconScheduler","Coalesce the beacons of all "
+                   "nodes into slotted events of a single shared scheduler "
+                   "instead of one timer per node.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_sharedBeaconScheduler),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LinkLayerBeacons","Send and receive beacons as raw "
+                   "link-layer frames instead of UDP broadcasts.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_linkLayerBeacons),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PassiveDiscovery","Treat overheard epidemic frames as "
+                   "beacons of their sender and skip own beacons while "
+                   "this node is sending traffic.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_passiveDiscovery),
+                   MakeBooleanChecker ())
+    .AddAttribute ("OverhearBundles","Store overheard data packets "
+                   "addressed to other nodes in the epidemic queue.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_overhearBundles),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxSessions","Maximum number of concurrent anti-entropy "
+                   "sessions a node starts or answers, 0 means no limit. "
+                   "Further peers wait in a FIFO until a session ends.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxSessions),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SessionStartJitter","Upper bound of the uniform random "
+                   "delay before a granted session sends its summary vector.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RoutingProtocol::m_sessionStartJitter),
+                   MakeTimeChecker ())
+    .AddAttribute ("SessionTimeout","Time after which the summary vector "
+                   "of a session is retransmitted if the peer did not send "
+                   "its summary vector back.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_sessionTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("SessionRetries","Number of summary vector "
+                   "retransmissions before a session is ended as failed.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&RoutingProtocol::m_sessionRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ResumeSessions","Start an early session, ignoring "
+                   "HostRecentPeriod, with a peer whose last contact was "
+                   "cut short.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_resumeSessions),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ContactBudget","Send the most valuable packets first and "
+                   "only as many as fit into the contact time estimated from "
+                   "the positions and velocities of both nodes.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_contactBudget),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ContactRange","Communication range in meters used to "
+                   "estimate the remaining contact time.",
+                   DoubleValue (100),
+                   MakeDoubleAccessor (&RoutingProtocol::m_contactRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ContactDataRate","Link rate used to convert the "
+                   "remaining contact time into a transfer budget.",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&RoutingProtocol::m_contactDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Aggregation","Pack several queued packets into one "
+                   "AGGREGATE message when sending disjoint packets.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_aggregation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("AggregationSize","Maximum size in bytes of an AGGREGATE "
+                   "message, excluding UDP and IP headers.",
+                   UintegerValue (1472),
+                   MakeUintegerAccessor (&RoutingProtocol::m_aggregationSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ChunkSize","Packets originated by a node that are "
+                   "larger than this many bytes are split into chunks "
+                   "forwarded independently, 0 disables chunking.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_chunkSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NetworkCoding","Send packets originated by a node as "
+                   "random linear combinations of generations of packets "
+                   "to the same destination.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_networkCoding),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GenerationSize","Maximum number of packets coded "
+                   "together.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RoutingProtocol::m_generationSize),
+                   MakeUintegerChecker<uint32_t> (1, 255))
+    .AddAttribute ("CodingRedundancy","Number of coded packets sent per "
+                   "generation beyond the number of packets it holds.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&RoutingProtocol::m_codingRedundancy),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("GenerationTimeout","Time after which a generation "
+                   "that is not full is coded and sent.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_generationTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ForwardingMode","How copies of a packet are handed to "
+                   "peers.",
+                   EnumValue (EPIDEMIC),
+                   MakeEnumAccessor (&RoutingProtocol::m_forwardingMode),
+                   MakeEnumChecker (EPIDEMIC, "Epidemic",
+                                    SPRAY_AND_WAIT, "SprayAndWait",
+                                    PROPHET, "Prophet",
+                                    MAXPROP, "MaxProp"))
+    .AddAttribute ("SprayCopies","Copy budget of packets originated in "
+                   "Spray-and-Wait mode.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RoutingProtocol::m_sprayCopies),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ProphetInit","Delivery predictability gained per "
+                   "encounter in PRoPHET mode.",
+                   DoubleValue (0.75),
+                   MakeDoubleAccessor (&RoutingProtocol::m_prophetInit),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ProphetBeta","Scaling of transitive delivery "
+                   "predictabilities in PRoPHET mode.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RoutingProtocol::m_prophetBeta),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ProphetGamma","Decay of delivery predictabilities per "
+                   "ProphetTimeUnit in PRoPHET mode.",
+                   DoubleValue (0.98),
+                   MakeDoubleAccessor (&RoutingProtocol::m_prophetGamma),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ProphetTimeUnit","Aging time unit of delivery "
+                   "predictabilities in PRoPHET mode.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&RoutingProtocol::m_prophetTimeUnit),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxPropHopThreshold","Packets that travelled fewer "
+                   "hops are sent first and ordered by hop count in "
+                   "MaxProp mode.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxPropHopThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Hybrid","Flood neighbor lists in beacons and forward "
+                   "packets along a path when their destination is in the "
+                   "connected component.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_hybrid),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LinkStateTimeout","Time after which a neighbor or a "
+                   "flooded neighbor list is stale in hybrid mode.",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&RoutingProtocol::m_linkStateTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("DeliveredWindow","Number of sequence numbers of each "
+                   "source tracked to detect duplicates at the destination, "
+                   "rounded up to a multiple of 64.  0 keeps delivered "
+                   "packets in the queue instead.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_deliveredWindowSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CompactHeader","Send the epidemic header of packets "
+                   "originated by this node, and beacons, in the "
+                   "variable-length format.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_compactHeader),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxSummaryVectorSize","Largest number of packet IDs "
+                   "accepted in a received summary vector, 0 only limits "
+                   "them to the size of the message.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxSummaryVectorSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Enqueue", "A packet was added to the queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_enqueueTrace),
+                     "ns3::Epidemic::PacketQueue::PacketTracedCallback")
+    .AddTraceSource ("Duplicate", "A packet was received while "
+                     "already in the queue or delivered.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_duplicateTrace),
+                     "ns3::Epidemic::PacketQueue::PacketTracedCallback")
+    .AddTraceSource ("Drop", "A packet was dropped from the queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_dropTrace),
+                     "ns3::Epidemic::PacketQueue::DropTracedCallback")
+    .AddTraceSource ("Forward", "A packet was sent to a peer.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_forwardTrace),
+                     "ns3::Epidemic::RoutingProtocol::ForwardTracedCallback")
+    .AddTraceSource ("LocalDeliver", "A packet was delivered to this node.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_localDeliverTrace),
+                     "ns3::Epidemic::RoutingProtocol::DeliverTracedCallback")
+    .AddTraceSource ("BeaconTx", "A beacon was sent.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_beaconTxTrace),
+                     "ns3::Epidemic::RoutingProtocol::BeaconTracedCallback")
+    .AddTraceSource ("BeaconRx", "A beacon was received.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_beaconRxTrace),
+                     "ns3::Epidemic::RoutingProtocol::BeaconTracedCallback")
+    .AddTraceSource ("SessionStart", "An anti-entropy session started "
+                     "by this node sent its summary vector.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_sessionStartTrace),
+                     "ns3::Epidemic::RoutingProtocol::SessionStartTracedCallback")
+    .AddTraceSource ("SessionEnd", "An anti-entropy session started "
+                     "by this node ended.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_sessionEndTrace),
+                     "ns3::Epidemic::RoutingProtocol::SessionEndTracedCallback");
 
   return tid;
 }
@@ -116,9 +321,43 @@ RoutingProtocol::RoutingProtocol ()
     m_hostRecentPeriod (Seconds (0)),
     m_beaconMaxJitterMs (0),
     m_dataPacketCounter (0),
-    m_queue (m_maxQueueLen)
+    m_loopbackDevice (-1),
+    m_queue (m_maxQueueLen),
+    m_sharedBeaconScheduler (false),
+    m_beaconHandle (0),
+    m_linkLayerBeacons (false),
+    m_passiveDiscovery (false),
+    m_lastTxTime (Seconds (0)),
+    m_overhearBundles (false),
+    m_maxSessions (0),
+    m_sessionStartJitter (Seconds (0)),
+    m_sessionTimeout (Seconds (0)),
+    m_sessionRetries (0),
+    m_resumeSessions (false),
+    m_contactBudget (false),
+    m_contactRange (0),
+    m_aggregation (false),
+    m_aggregationSize (0),
+    m_chunkSize (0),
+    m_networkCoding (false),
+    m_generationSize (0),
+    m_codingRedundancy (0),
+    m_generationTimeout (Seconds (0)),
+    m_forwardingMode (EPIDEMIC),
+    m_sprayCopies (0),
+    m_prophetInit (0),
+    m_prophetBeta (0),
+    m_prophetGamma (0),
+    m_prophetTimeUnit (Seconds (0)),
+    m_maxPropHopThreshold (0),
+    m_hybrid (false),
+    m_linkStateTimeout (Seconds (0)),
+    m_deliveredWindowSize (0),
+    m_compactHeader (false),
+    m_maxSummaryVectorSize (0)
 {
   NS_LOG_FUNCTION (this);
+  m_queue.SetTraces (&m_enqueueTrace, &m_duplicateTrace, &m_dropTrace);
 }
 
 RoutingProtocol::~RoutingProtocol ()
@@ -131,6 +370,23 @@ RoutingProtocol::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   m_ipv4 = 0;
+  m_sessions.Clear ();
+  for (std::map<GenerationKey, CodingGeneration>::iterator
+       i = m_generations.begin (); i != m_generations.end (); ++i)
+    {
+      i->second.flush.Cancel ();
+    }
+  m_generations.clear ();
+  m_decoders.clear ();
+  m_decoderExpiry.clear ();
+  m_decodedGenerations.clear ();
+  m_decodedExpiry.clear ();
+  m_delivered.Clear ();
+  if (m_beaconScheduler != 0)
+    {
+      m_beaconScheduler->Unregister (m_beaconHandle);
+      m_beaconScheduler = 0;
+    }
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::iterator
        iter = m_socketAddresses.begin (); iter
        != m_socketAddresses.end (); iter++)
@@ -138,6 +394,9 @@ RoutingProtocol::DoDispose ()
       iter->first->Close ();
     }
   m_socketAddresses.clear ();
+  m_localAddresses.clear ();
+  m_deviceSubnets.clear ();
+  m_neighborRoutes.clear ();
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -157,12 +416,64 @@ void
 RoutingProtocol::Start ()
 {
   NS_LOG_FUNCTION (this );
+  UpdateInterfaceTables ();
   m_queue.SetMaxQueueLen (m_maxQueueLen);
-  m_beaconTimer.SetFunction (&RoutingProtocol::SendBeacons,this);
   m_beaconJitter = CreateObject<UniformRandomVariable> ();
   m_beaconJitter->SetAttribute ("Max", DoubleValue (m_beaconMaxJitterMs));
-  m_beaconTimer.Schedule (m_beaconInterval + MilliSeconds
-                            (m_beaconJitter->GetValue ()));
+  m_sessions.SetMaxSessions (m_maxSessions);
+  m_sessionJitter = CreateObject<UniformRandomVariable> ();
+  m_sessionJitter->SetAttribute ("Max",
+                                 DoubleValue (m_sessionStartJitter.GetSeconds ()));
+  m_codingCoefficients = CreateObject<UniformRandomVariable> ();
+  m_prophet.SetParameters (m_prophetInit, m_prophetBeta, m_prophetGamma,
+                           m_prophetTimeUnit);
+  m_linkState.SetAddress (m_mainAddress);
+  m_linkState.SetTimeout (m_linkStateTimeout);
+  m_delivered.SetSize (m_deliveredWindowSize);
+  if (m_forwardingMode == MAXPROP)
+    {
+      m_queue.SetCostCallback (MakeCallback (&RoutingProtocol::GetMaxPropCost,
+                                             this));
+    }
+  if (m_sharedBeaconScheduler)
+    {
+      m_beaconScheduler = BeaconScheduler::Get ();
+      m_beaconHandle = m_beaconScheduler->Register (
+          MakeCallback (&RoutingProtocol::SendBeacons,this),
+          GetObject<Node> ()->GetId ());
+    }
+  else
+    {
+      m_beaconTimer.SetFunction (&RoutingProtocol::SendBeacons,this);
+    }
+  if (m_linkLayerBeacons)
+    {
+      GetObject<Node> ()->RegisterProtocolHandler (
+        MakeCallback (&RoutingProtocol::RecvLinkLayerBeacon,this),
+        EPIDEMIC_BEACON_PROTOCOL, 0);
+    }
+  if (m_passiveDiscovery || m_overhearBundles)
+    {
+      GetObject<Node> ()->RegisterProtocolHandler (
+        MakeCallback (&RoutingProtocol::RecvPromiscuous,this),
+        0, 0, true);
+    }
+  ScheduleNextBeacon ();
+}
+
+void
+RoutingProtocol::ScheduleNextBeacon ()
+{
+  NS_LOG_FUNCTION (this);
+  Time delay = m_beaconInterval + MilliSeconds (m_beaconJitter->GetValue ());
+  if (m_beaconScheduler != 0)
+    {
+      m_beaconScheduler->Schedule (m_beaconHandle, delay);
+    }
+  else
+    {
+      m_beaconTimer.Schedule (delay);
+    }
 }
 
 bool
@@ -207,6 +518,7 @@ RoutingProtocol::SendPacket (Ptr<Packet> p,InetSocketAddress addr)
           Ptr<Socket> socket = j->first;
           NS_LOG_LOGIC ("Packet " << p << " is sent to" << addr );
           socket->SendTo (p,0, addr);
+          m_lastTxTime = Now ();
         }
     }
   NS_LOG_FUNCTION (this << *p);
@@ -245,7 +557,6 @@ void
 RoutingProtocol::SendPacketFromQueue (Ipv4Address dst,QueueEntry queueEntry)
 {
   NS_LOG_FUNCTION (this << dst << queueEntry.GetPacketID ());
-  Ptr<Packet> p = ConstCast<Packet> (queueEntry.GetPacket ());
   UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
   Ipv4Header header = queueEntry.GetIpv4Header ();
   /*
@@ -253,20 +564,6 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst,QueueEntry queueEntry)
    *  on hop count, IP TTL dropping mechanism is avoided by incrementing TTL.
    */
   header.SetTtl (header.GetTtl () + 1);
-  header.SetPayloadSize (p->GetSize ());
-  Ptr<Ipv4Route> rt = Create<Ipv4Route> ();
-  rt->SetSource (header.GetSource ());
-  rt->SetDestination (header.GetDestination ());
-  rt->SetGateway (dst);
-  if (m_ipv4->GetInterfaceForAddress (m_mainAddress) != -1)
-    {
-      Ptr<Node> node = m_ipv4->GetObject<Node> ();
-      rt->SetOutputDevice (m_ipv4->GetNetDevice
-                             (m_ipv4->GetInterfaceForAddress (m_mainAddress)));
-
-    }
-
-  Ptr<Packet> copy = p->Copy ();
   /*
    *  The packet will not be sent if:
    *  The forward address is the source address of the packet.
@@ -274,7 +571,160 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst,QueueEntry queueEntry)
    */
   if (dst != header.GetSource () && !IsMyOwnAddress (header.GetDestination ()))
     {
+      // The copy budget is only split for a packet that leaves
+      queueEntry = SplitCopies (queueEntry);
+      Ptr<Packet> copy = CopyForSending (queueEntry);
+      header.SetPayloadSize (copy->GetSize ());
+      Ptr<Ipv4Route> rt = GetNeighborRoute (dst);
       ucb (rt, copy, header);
+      m_lastTxTime = Now ();
+      m_forwardTrace (copy, queueEntry.GetPacketID (), dst);
+    }
+}
+
+Ptr<Packet>
+RoutingProtocol::CopyForSending (const QueueEntry &entry) const
+{
+  Ptr<Packet> copy = entry.GetPacket ()->Copy ();
+  EpidemicHeader eHeader;
+  copy->PeekHeader (eHeader);
+  if (eHeader.IsValid () && eHeader.GetVersion () == EpidemicHeader::COMPACT)
+    {
+      // The queued bytes give the age of the packet when it was queued
+      copy->RemoveHeader (eHeader);
+      eHeader.SetTimeStamp (entry.GetExpireTime () - m_queueEntryExpireTime);
+      copy->AddHeader (eHeader);
+    }
+  return copy;
+}
+
+void
+RoutingProtocol::SendAggregatedPackets (Ipv4Address dst,
+                                        const std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << dst << packets.size ());
+  TypeHeader tHeader (TypeHeader::AGGREGATE);
+  BundleHeader bHeader;
+  // An AggregationSize below the type header leaves no room for bundles
+  uint32_t budget = m_aggregationSize > tHeader.GetSerializedSize ()
+    ? m_aggregationSize - tHeader.GetSerializedSize () : 0;
+  Ptr<Packet> aggregate;
+  // Bundles of the aggregate, traced once it is sent
+  std::vector<std::pair<Ptr<const Packet>, uint32_t> > bundles;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      QueueEntry entry = m_queue.Find (*i);
+      if (!entry.GetPacket ())
+        {
+          continue;
+        }
+      Ipv4Header header = entry.GetIpv4Header ();
+      // Same rule as SendPacketFromQueue
+      if (dst == header.GetSource () || IsMyOwnAddress (header.GetDestination ()))
+        {
+          continue;
+        }
+      Ptr<Packet> bundle = CopyForSending (entry);
+      uint32_t size = bHeader.GetSerializedSize () + bundle->GetSize ();
+      if (size > budget)
+        {
+          // Too large to share a message, send it on its own
+          QueueTransfer (dst, *i);
+          continue;
+        }
+      QueueEntry split = SplitCopies (entry);
+      if (split.GetPacket () != entry.GetPacket ())
+        {
+          // The halved copy budget may take fewer header bytes
+          bundle = CopyForSending (split);
+          size = bHeader.GetSerializedSize () + bundle->GetSize ();
+        }
+      if (aggregate && aggregate->GetSize () + size > budget)
+        {
+          Simulator::Schedule (Time (0), &RoutingProtocol::SendAggregate,
+                               this, aggregate, bundles, dst);
+          aggregate = 0;
+          bundles.clear ();
+        }
+      if (!aggregate)
+        {
+          aggregate = Create<Packet> ();
+        }
+      // The traced copy is only taken when a sink is connected
+      if (!m_forwardTrace.IsEmpty ())
+        {
+          bundles.push_back (std::make_pair (bundle->Copy (), *i));
+        }
+      bundle->AddHeader (BundleHeader (header, bundle->GetSize ()));
+      aggregate->AddAtEnd (bundle);
+    }
+  if (aggregate)
+    {
+      Simulator::Schedule (Time (0), &RoutingProtocol::SendAggregate, this,
+                           aggregate, bundles, dst);
+    }
+}
+
+void
+RoutingProtocol::SendAggregate (
+  Ptr<Packet> aggregate,
+  const std::vector<std::pair<Ptr<const Packet>, uint32_t> > &bundles,
+  Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << aggregate->GetSize () << bundles.size () << dst);
+  TypeHeader tHeader (TypeHeader::AGGREGATE);
+  aggregate->AddHeader (tHeader);
+  ControlTag tempTag (ControlTag::CONTROL);
+  aggregate->AddPacketTag (tempTag);
+  SendPacket (aggregate, InetSocketAddress (dst, EPIDEMIC_PORT));
+  for (std::vector<std::pair<Ptr<const Packet>, uint32_t> >::const_iterator
+       i = bundles.begin (); i != bundles.end (); ++i)
+    {
+      m_forwardTrace (i->first, i->second, dst);
+    }
+}
+
+void
+RoutingProtocol::RecvAggregate (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet->GetSize ());
+  ControlTag tag;
+  packet->RemovePacketTag (tag);
+  BundleHeader bHeader;
+  while (packet->GetSize () >= bHeader.GetSerializedSize ())
+    {
+      packet->RemoveHeader (bHeader);
+      if (!bHeader.IsValid () || packet->GetSize () < bHeader.GetLength ())
+        {
+          NS_LOG_LOGIC ("Truncated bundle in AGGREGATE message");
+          return;
+        }
+      Ptr<Packet> bundle = packet->CreateFragment (0, bHeader.GetLength ());
+      packet->RemoveAtStart (bHeader.GetLength ());
+      Ipv4Header header = bHeader.GetIpv4Header ();
+      // The IP header of a bundle covers the bundle, as for a data packet
+      header.SetPayloadSize (bHeader.GetLength ());
+      if (IsMyOwnAddress (header.GetDestination ()))
+        {
+          // Same as the local delivery of a data packet in RouteInput
+          EpidemicHeader eHeader;
+          bundle->PeekHeader (eHeader);
+          if (eHeader.IsValid ()
+              && StoreDeliveredPacket (bundle, eHeader, header,
+                                       m_forwardCallback, m_errorCallback)
+              && !m_localDeliverCallback.IsNull ())
+            {
+              DeliverLocally (bundle->Copy (), eHeader, header,
+                              m_localDeliverCallback,
+                              m_ipv4->GetInterfaceForAddress (m_mainAddress));
+            }
+        }
+      else
+        {
+          EnqueueRelayedPacket (bundle, header, m_forwardCallback,
+                                m_errorCallback);
+        }
     }
 }
 
@@ -282,39 +732,118 @@ void
 RoutingProtocol::SendBeacons ()
 {
   NS_LOG_FUNCTION (this);
+  if (m_passiveDiscovery && !m_hybrid
+      && Now () < m_lastTxTime + m_beaconInterval)
+    {
+      // Neighbors overhear the traffic of this node, no beacon is needed
+      NS_LOG_LOGIC ("Beacon suppressed, last transmission at " << m_lastTxTime);
+      ScheduleNextBeacon ();
+      return;
+    }
+  if (m_linkLayerBeacons)
+    {
+      SendLinkLayerBeacons ();
+      ScheduleNextBeacon ();
+      return;
+    }
   Ptr<Packet> packet = Create<Packet> ();
   EpidemicHeader header;
   // This number does not have any effect but it has to be more than
   // 1 to avoid dropping at the receiver
   header.SetHopCount (m_hopCount);
-  packet->AddHeader (header);
   TypeHeader tHeader (TypeHeader::BEACON);
+  // A compact beacon is its type byte alone
+  tHeader.SetCompact (m_compactHeader);
+  uint32_t headerSize = m_compactHeader ? 0 : header.GetSerializedSize ();
+  if (m_hybrid)
+    {
+      uint32_t overhead = Ipv4Header ().GetSerializedSize ()
+        + UdpHeader ().GetSerializedSize () + tHeader.GetSerializedSize ()
+        + headerSize;
+      packet->AddHeader (LinkStateHeader (m_linkState.GetEntries (
+                                            GetLinkStateBudget (overhead))));
+    }
+  if (!m_compactHeader)
+    {
+      packet->AddHeader (header);
+    }
   packet->AddHeader (tHeader);
   ControlTag tempTag (ControlTag::CONTROL);
   // Packet tag is added and will be removed before local delivery in
   // RouteInput function
   packet->AddPacketTag (tempTag);
 
-
+  m_beaconTxTrace (packet, Ipv4Address::GetAny ());
   BroadcastPacket (packet);
-  m_beaconTimer.Schedule (m_beaconInterval + MilliSeconds
-                            (m_beaconJitter->GetValue ()));
+  ScheduleNextBeacon ();
+}
+
+void
+RoutingProtocol::SendLinkLayerBeacons ()
+{
+  NS_LOG_FUNCTION (this);
+  LinkStateHeader linkState;
+  if (m_hybrid)
+    {
+      uint32_t overhead = TypeHeader ().GetSerializedSize ()
+        + BeaconHeader ().GetSerializedSize ();
+      linkState = LinkStateHeader (m_linkState.GetEntries (
+                                     GetLinkStateBudget (overhead)));
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator
+       j = m_socketAddresses.begin ();
+       j != m_socketAddresses.end (); ++j)
+    {
+      int32_t interface = m_ipv4->GetInterfaceForAddress (j->second.GetLocal ());
+      if (interface < 0)
+        {
+          continue;
+        }
+      Ptr<Packet> packet = Create<Packet> ();
+      if (m_hybrid)
+        {
+          packet->AddHeader (linkState);
+        }
+      Ptr<NetDevice> dev = m_ipv4->GetNetDevice (interface);
+      BeaconHeader bHeader (j->second.GetLocal ());
+      packet->AddHeader (bHeader);
+      TypeHeader tHeader (TypeHeader::BEACON);
+      packet->AddHeader (tHeader);
+      NS_LOG_LOGIC ("Link-layer beacon " << packet->GetUid () << " is sent on "
+                                         << j->second.GetLocal ());
+      m_beaconTxTrace (packet, j->second.GetLocal ());
+      dev->Send (packet, dev->GetBroadcast (), EPIDEMIC_BEACON_PROTOCOL);
+    }
 }
 
+uint32_t
+RoutingProtocol::GetLinkStateBudget (uint32_t overhead) const
+{
+  // One view is sent on every interface, it fits the smallest MTU
+  uint32_t mtu = 0xFFFF;
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator
+       j = m_socketAddresses.begin ();
+       j != m_socketAddresses.end (); ++j)
+    {
+      int32_t interface = m_ipv4->GetInterfaceForAddress (j->second.GetLocal ());
+      if (interface >= 0)
+        {
+          mtu = std::min (mtu, static_cast<uint32_t> (m_ipv4->GetMtu (interface)));
+        }
+    }
+  return mtu > overhead ? mtu - overhead : 0;
+}
 
 uint32_t
 RoutingProtocol::FindOutputDeviceForAddress (Ipv4Address  dst)
 {
   NS_LOG_FUNCTION (this << dst);
-  Ptr<Node> mynode = m_ipv4->GetObject<Node> ();
-  for (uint32_t i = 0; i < mynode->GetNDevices (); i++)
+  for (std::vector<DeviceSubnet>::const_iterator i = m_deviceSubnets.begin ();
+       i != m_deviceSubnets.end (); ++i)
     {
-      Ipv4InterfaceAddress iface = m_ipv4->GetAddress (
-          m_ipv4->GetInterfaceForDevice (mynode->GetDevice (i)),0);
-      if (dst.CombineMask (iface.GetMask ()) ==
-          iface.GetLocal ().CombineMask (iface.GetMask ()))
+      if (dst.CombineMask (i->mask) == i->network)
         {
-          return i;
+          return i->device;
         }
     }
   return -1;
@@ -325,34 +854,93 @@ uint32_t
 RoutingProtocol::FindLoopbackDevice ()
 {
   NS_LOG_FUNCTION (this);
+  return m_loopbackDevice;
+}
+
+void
+RoutingProtocol::UpdateInterfaceTables ()
+{
+  NS_LOG_FUNCTION (this);
+  m_neighborRoutes.clear ();
+  m_deviceSubnets.clear ();
+  m_loopbackDevice = -1;
   Ptr<Node> mynode = m_ipv4->GetObject<Node> ();
   for (uint32_t i = 0; i < mynode->GetNDevices (); i++)
     {
-      Ipv4InterfaceAddress iface = m_ipv4->GetAddress (
-          m_ipv4->GetInterfaceForDevice (mynode->GetDevice (i)),0);
-      if (iface.GetLocal () == Ipv4Address ("127.0.0.1") )
+      int32_t interface = m_ipv4->GetInterfaceForDevice (mynode->GetDevice (i));
+      if (interface < 0 || m_ipv4->GetNAddresses (interface) == 0)
+        {
+          continue;
+        }
+      Ipv4InterfaceAddress iface = m_ipv4->GetAddress (interface, 0);
+      DeviceSubnet subnet;
+      subnet.network = iface.GetLocal ().CombineMask (iface.GetMask ());
+      subnet.mask = iface.GetMask ();
+      subnet.device = i;
+      m_deviceSubnets.push_back (subnet);
+      if (iface.GetLocal () == Ipv4Address ("127.0.0.1")
+          && m_loopbackDevice == static_cast<uint32_t> (-1))
         {
-          return i;
+          m_loopbackDevice = i;
         }
     }
-  return -1;
+  m_localAddresses.clear ();
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      m_localAddresses.insert (j->second.GetLocal ());
+    }
 }
 
 
-bool
-RoutingProtocol::IsMyOwnAddress (Ipv4Address src)
+Ptr<Ipv4Route>
+RoutingProtocol::GetNeighborRoute (Ipv4Address neighbor)
 {
-  NS_LOG_FUNCTION (this << src);
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
-         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+  NS_LOG_FUNCTION (this << neighbor);
+  std::map<Ipv4Address, NeighborRoute>::iterator i =
+    m_neighborRoutes.find (neighbor);
+  if (i != m_neighborRoutes.end () && i->second.expire >= Now ())
     {
-      Ipv4InterfaceAddress iface = j->second;
-      if (src == iface.GetLocal ())
+      i->second.expire = Now () + m_hostRecentPeriod;
+      return i->second.route;
+    }
+  for (i = m_neighborRoutes.begin (); i != m_neighborRoutes.end (); )
+    {
+      // Advance before the entry is erased
+      if (i->second.expire < Now ())
         {
-          return true;
+          m_neighborRoutes.erase (i++);
+        }
+      else
+        {
+          ++i;
         }
     }
-  return false;
+  /*
+   * The IP layer only uses the gateway and the output device to forward
+   * a packet, its addresses come from the IP header, so one route per
+   * neighbor serves all the packets sent to it.
+   */
+  Ptr<Ipv4Route> rt = Create<Ipv4Route> ();
+  rt->SetSource (m_mainAddress);
+  rt->SetDestination (neighbor);
+  rt->SetGateway (neighbor);
+  int32_t interface = m_ipv4->GetInterfaceForAddress (m_mainAddress);
+  if (interface != -1)
+    {
+      rt->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+    }
+  NeighborRoute &cached = m_neighborRoutes[neighbor];
+  cached.route = rt;
+  cached.expire = Now () + m_hostRecentPeriod;
+  return rt;
+}
+
+bool
+RoutingProtocol::IsMyOwnAddress (Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << src);
+  return m_localAddresses.find (src) != m_localAddresses.end ();
 }
 
 
@@ -446,6 +1034,13 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
       NS_LOG_ERROR ("No  interfaces");
       return false;
     }
+  if (m_forwardCallback.IsNull ())
+    {
+      // Kept to store packets that do not pass through RouteInput
+      m_forwardCallback = ucb;
+      m_errorCallback = ecb;
+      m_localDeliverCallback = lcb;
+    }
 
 
 
@@ -480,51 +1075,44 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
             {
               ControlTag tag;
               p->PeekPacketTag (tag);
-              Ptr<Packet> local_copy = p->Copy ();
-              bool duplicatePacket = false;
               /*
                * If this is a data packet, add it to the epidemic
                * queue in order to avoid
                * receiving duplicates of the same packet.
+               * The queue keeps p itself, only a packet that is
+               * delivered is copied.
                */
               if (tag.GetTagType () == ControlTag::NOT_SET)
                 {
-                  Ptr<Packet> copy = p->Copy ();
-                  QueueEntry newEntry (copy, header, ucb, ecb);
-                  EpidemicHeader current_Header;
-                  copy->PeekHeader (current_Header);
-                  newEntry.SetExpireTime (m_queueEntryExpireTime +
-                                          current_Header.GetTimeStamp ());
-                  newEntry.SetPacketID (current_Header.GetPacketID ());
-                  EpidemicHeader header;
-                  local_copy->RemoveHeader (header);
-                  // Try to see the packet has been
-                  // delivered i.e. in the epidemic buffer
-                  if (m_queue.Find (
-                        current_Header.GetPacketID ()).GetPacketID ()
-                      == 0)
-                    {
-                      m_queue.Enqueue (newEntry);
-                    }
-                  else
+                  EpidemicHeader eHeader;
+                  p->PeekHeader (eHeader);
+                  if (eHeader.IsValid ()
+                      && StoreDeliveredPacket (p, eHeader, header, ucb, ecb))
                     {
-                      duplicatePacket = true;
+                      DeliverLocally (p->Copy (), eHeader, header, lcb, iif);
                     }
+                  return true;
                 }
-              /*
-              Deliver the packet locally
-              */
-              if (!duplicatePacket)
-                {
-                  local_copy->RemovePacketTag (tag);
-                  lcb (local_copy, header, iif);
-                }
+              Ptr<Packet> local_copy = p->Copy ();
+              local_copy->RemovePacketTag (tag);
+              lcb (local_copy, header, iif);
               return true;
 
             }
         }
     }
 
+  if (!IsMyOwnAddress (header.GetSource ()))
+    {
+      // A known packet was already forwarded when it was first received
+      uint32_t packetID = EnqueueRelayedPacket (p, header, ucb, ecb);
+      if (packetID != 0)
+        {
+          ForwardInCluster (packetID);
+        }
+      return true;
+    }
+
   /*
   If the packet does not have an epidemic header,
   create one and attach it to the packet.
@@ -547,98 +1135,422 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p,
 
 
 
-  // Adding the data packet to the queue
-  QueueEntry newEntry (copy, header, ucb, ecb);
-  newEntry.SetPacketID (global_packet_ID);
-
-  if (IsMyOwnAddress (header.GetSource ()))
+  if (m_networkCoding && copy->GetSize () + 2 <= 0xFFFF)
+    {
+      AddToGeneration (copy, header, ucb, ecb);
+    }
+  else if (m_chunkSize > 0 && copy->GetSize () > m_chunkSize)
+    {
+      return EnqueueChunks (copy, header, ucb, ecb, global_packet_ID);
+    }
+  else
     {
+      // Adding the data packet to the queue
+      QueueEntry newEntry (copy, header, ucb, ecb);
+      newEntry.SetPacketID (global_packet_ID);
       NS_LOG_DEBUG ("Adding Epidemic packet header " << p->GetUid () );
       //ADD EPIDEMIC HEADER
-      EpidemicHeader new_Header;
+      EpidemicHeader new_Header = CreateHeader ();
       new_Header.SetPacketID (global_packet_ID);
-      new_Header.SetTimeStamp (Simulator::Now ());
-      new_Header.SetHopCount (m_hopCount);
       // If the packet is generated in this node, add the epidemic header
       copy->AddHeader (new_Header);
       // If the packet is generated in this node,
       // make the Expire time start from now + the user specified period
       newEntry.SetExpireTime (m_queueEntryExpireTime + Simulator::Now ());
+      m_queue.Enqueue (newEntry);
+      ForwardInCluster (global_packet_ID);
+    }
+  return true;
+
+}
 
+EpidemicHeader
+RoutingProtocol::CreateHeader () const
+{
+  EpidemicHeader header;
+  header.SetTimeStamp (Simulator::Now ());
+  header.SetHopCount (m_hopCount);
+  // Hop counts above 255 do not fit the compact format
+  if (m_compactHeader && m_hopCount <= 0xFF)
+    {
+      header.SetVersion (EpidemicHeader::COMPACT);
     }
-  else
+  if (m_forwardingMode == SPRAY_AND_WAIT)
     {
-      // If the packet is generated in another node, read the epidemic header
-      EpidemicHeader current_Header;
-      copy->RemoveHeader (current_Header);
-      if (current_Header.GetHopCount () <= 1
-          || (current_Header.GetTimeStamp ()
-              + m_queueEntryExpireTime) < Simulator::Now () )
-        {
-          // Exit  the function to not add the packet to the queue
-          // since the flood count limit is reached
-          NS_LOG_DEBUG ("Exit the function  and not add the "
-                        "packet to the queue since the flood count limit is reached");
-          return true;
+      header.SetCopies (m_sprayCopies);
+    }
+  return header;
+}
+
+bool
+RoutingProtocol::EnqueueChunks (Ptr<Packet> packet, const Ipv4Header &header,
+                                UnicastForwardCallback ucb,
+                                ErrorCallback ecb, uint32_t bundleID)
+{
+  NS_LOG_FUNCTION (this << packet->GetUid () << header << bundleID);
+  uint32_t count = (packet->GetSize () + m_chunkSize - 1) / m_chunkSize;
+  if (count > 0xFFFF)
+    {
+      NS_LOG_LOGIC ("Packet of " << packet->GetSize () << " bytes needs "
+                                 << count << " chunks, dropped");
+      return false;
+    }
+  EpidemicHeader new_Header = CreateHeader ();
+  new_Header.SetChunk (bundleID, 0, count);
+  // The chunk IDs wrap around the packet counter, they must not take
+  // the IDs of packets still queued
+  for (uint32_t index = 0; index < count; ++index)
+    {
+      if (m_queue.Contains (new_Header.GetChunkPacketID (index)))
+        {
+          NS_LOG_LOGIC ("Chunk " << index << " of bundle " << bundleID
+                                 << " would reuse a queued packet ID, dropped");
+          return false;
+        }
+    }
+  for (uint32_t index = 0; index < count; ++index)
+    {
+      uint32_t offset = index * m_chunkSize;
+      Ptr<Packet> chunk = packet->CreateFragment (
+          offset, std::min (m_chunkSize, packet->GetSize () - offset));
+      if (index > 0)
+        {
+          // Chunks take consecutive values of the packet counter
+          m_dataPacketCounter++;
         }
-      // If the packet is generated in another node,
-      // use the timestamp from the epidemic header
-      newEntry.SetExpireTime (m_queueEntryExpireTime +
-                              current_Header.GetTimeStamp ());
-      // If the packet is generated in another node,
-      // use the PacketID from the epidemic header
-      newEntry.SetPacketID (current_Header.GetPacketID ());
-      //Decrease the packet flood counter
-      current_Header.SetHopCount (
-        current_Header.GetHopCount () - 1);
-      // Add the updated header
-      copy->AddHeader (current_Header);
-    }
-
-  m_queue.Enqueue (newEntry);
+      uint32_t chunkID = new_Header.GetChunkPacketID (index);
+      new_Header.SetPacketID (chunkID);
+      new_Header.SetChunk (bundleID, index, count);
+      chunk->AddHeader (new_Header);
+      QueueEntry newEntry (chunk, header, ucb, ecb);
+      newEntry.SetPacketID (chunkID);
+      newEntry.SetExpireTime (m_queueEntryExpireTime + Simulator::Now ());
+      m_queue.Enqueue (newEntry);
+      ForwardInCluster (chunkID);
+    }
+  NS_LOG_LOGIC ("Split packet " << packet->GetUid () << " into " << count
+                                << " chunks of bundle " << bundleID);
   return true;
-
 }
 
 void
-RoutingProtocol::SetIpv4 (Ptr<Ipv4> ipv4)
+RoutingProtocol::AddToGeneration (Ptr<Packet> packet, const Ipv4Header &header,
+                                  UnicastForwardCallback ucb,
+                                  ErrorCallback ecb)
 {
-  NS_LOG_FUNCTION (this << ipv4);
-  m_ipv4 = ipv4;
-  Simulator::ScheduleNow (&RoutingProtocol::Start,this);
+  NS_LOG_FUNCTION (this << packet->GetUid () << header);
+  GenerationKey key (header.GetDestination (), header.GetProtocol ());
+  CodingGeneration &generation = m_generations[key];
+  if (generation.packets.empty ())
+    {
+      generation.header = header;
+      generation.ucb = ucb;
+      generation.ecb = ecb;
+      generation.flush = Simulator::Schedule (m_generationTimeout,
+                                              &RoutingProtocol::FlushGeneration,
+                                              this, key);
+    }
+  generation.packets.push_back (packet);
+  if (generation.packets.size () >= m_generationSize)
+    {
+      FlushGeneration (key);
+    }
 }
 
 void
-RoutingProtocol::NotifyInterfaceUp (uint32_t i)
+RoutingProtocol::FlushGeneration (GenerationKey key)
 {
-  NS_LOG_FUNCTION (this << i);
-  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
-  Ipv4InterfaceAddress iface = l3->GetAddress (i,0);
-  if (iface.GetLocal () == Ipv4Address ("127.0.0.1"))
+  NS_LOG_FUNCTION (this << key.first);
+  std::map<GenerationKey, CodingGeneration>::iterator it =
+    m_generations.find (key);
+  if (it == m_generations.end ())
     {
       return;
     }
-  if (m_mainAddress == Ipv4Address ())
+  CodingGeneration generation = it->second;
+  generation.flush.Cancel ();
+  m_generations.erase (it);
+
+  // Source symbols are the packets prefixed with their length
+  uint32_t symbolSize = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i =
+         generation.packets.begin (); i != generation.packets.end (); ++i)
     {
-      m_mainAddress = iface.GetLocal ();
+      symbolSize = std::max (symbolSize, (*i)->GetSize () + 2);
+    }
+  RlncEncoder encoder (symbolSize);
+  std::vector<uint8_t> buffer (symbolSize);
+  for (std::vector<Ptr<Packet> >::const_iterator i =
+         generation.packets.begin (); i != generation.packets.end (); ++i)
+    {
+      uint32_t size = (*i)->GetSize ();
+      buffer[0] = size >> 8;
+      buffer[1] = size & 0xFF;
+      (*i)->CopyData (&buffer[2], size);
+      encoder.AddSymbol (&buffer[0], size + 2);
     }
 
-  /*
-  Create a socket to be used for epidemic routing port
-  */
-  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-  Ptr<Socket> socket = Socket::CreateSocket (GetObject<Node> (),tid);
-  socket->SetRecvCallback (MakeCallback (&RoutingProtocol::RecvEpidemic,this));
-  socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), EPIDEMIC_PORT));
-  socket->BindToNetDevice (l3->GetNetDevice (i));
-  socket->SetAllowBroadcast (true);
-  m_socketAddresses.insert (std::make_pair (socket,iface));
+  // Coded packets take consecutive values of the packet counter
+  uint32_t hostID = generation.header.GetSource ().Get () & 0xFFFF;
+  uint32_t generationID = hostID << 16 | ((m_dataPacketCounter + 1) & 0xFFFF);
+  uint32_t count = encoder.GetGenerationSize () + m_codingRedundancy;
+  std::vector<uint8_t> coefficients (encoder.GetGenerationSize ());
+  EpidemicHeader new_Header = CreateHeader ();
+  new_Header.SetCoded ();
+  for (uint32_t k = 0; k < count; ++k)
+    {
+      bool zero = true;
+      while (zero)
+        {
+          for (uint32_t j = 0; j < coefficients.size (); ++j)
+            {
+              coefficients[j] = m_codingCoefficients->GetInteger (0, 255);
+              zero = zero && coefficients[j] == 0;
+            }
+        }
+      encoder.Encode (&coefficients[0], &buffer[0]);
+      Ptr<Packet> coded = Create<Packet> (&buffer[0], symbolSize);
+      coded->AddHeader (CodingHeader (generationID, symbolSize, coefficients));
+      m_dataPacketCounter++;
+      uint32_t packetID = hostID << 16 | m_dataPacketCounter;
+      new_Header.SetPacketID (packetID);
+      coded->AddHeader (new_Header);
+      QueueEntry newEntry (coded, generation.header, generation.ucb,
+                           generation.ecb);
+      newEntry.SetPacketID (packetID);
+      newEntry.SetExpireTime (m_queueEntryExpireTime + Simulator::Now ());
+      m_queue.Enqueue (newEntry);
+      ForwardInCluster (packetID);
+    }
+  NS_LOG_LOGIC ("Coded " << encoder.GetGenerationSize ()
+                         << " packets to " << key.first << " into " << count
+                         << " packets of generation " << generationID);
 }
 
 void
-RoutingProtocol::NotifyInterfaceDown (uint32_t i)
+RoutingProtocol::DeliverLocally (Ptr<Packet> packet,
+                                 const EpidemicHeader &eHeader,
+                                 const Ipv4Header &header,
+                                 LocalDeliverCallback lcb, int32_t iif)
 {
-  NS_LOG_FUNCTION (this << m_ipv4->GetAddress (i, 0).GetLocal ());
+  NS_LOG_FUNCTION (this << packet->GetUid () << header);
+  packet->RemoveAtStart (eHeader.GetSerializedSize ());
+  if (eHeader.IsCoded ())
+    {
+      DecodePacket (packet, header, lcb, iif);
+      return;
+    }
+  if (eHeader.IsChunk ())
+    {
+      // Chunks are delivered as the whole bundle once all are stored
+      packet = m_queue.ReassembleBundle (eHeader);
+      if (!packet)
+        {
+          return;
+        }
+    }
+  m_localDeliverTrace (packet, header);
+  lcb (packet, header, iif);
+}
+
+void
+RoutingProtocol::DecodePacket (Ptr<Packet> packet, const Ipv4Header &header,
+                               LocalDeliverCallback lcb, int32_t iif)
+{
+  NS_LOG_FUNCTION (this << packet->GetUid () << header);
+  while (!m_decodedExpiry.empty ()
+         && m_decodedExpiry.front ().first < Simulator::Now ())
+    {
+      m_decodedGenerations.erase (m_decodedExpiry.front ().second);
+      m_decodedExpiry.pop_front ();
+    }
+  // A generation that never reaches full rank is dropped once its
+  // packets have expired, a decoded one is already gone
+  while (!m_decoderExpiry.empty ()
+         && m_decoderExpiry.front ().first < Simulator::Now ())
+    {
+      m_decoders.erase (m_decoderExpiry.front ().second);
+      m_decoderExpiry.pop_front ();
+    }
+  CodingHeader cHeader;
+  packet->RemoveHeader (cHeader);
+  uint32_t generationID = cHeader.GetGenerationID ();
+  const std::vector<uint8_t> &coefficients = cHeader.GetCoefficients ();
+  if (!cHeader.IsValid ()
+      || m_decodedGenerations.count (generationID)
+      || coefficients.empty ()
+      || packet->GetSize () != cHeader.GetSymbolSize ())
+    {
+      return;
+    }
+  std::map<uint32_t, RlncDecoder>::iterator decoder =
+    m_decoders.find (generationID);
+  if (decoder == m_decoders.end ())
+    {
+      decoder = m_decoders.insert (
+          std::make_pair (generationID,
+                          RlncDecoder (coefficients.size (),
+                                       cHeader.GetSymbolSize ()))).first;
+      m_decoderExpiry.push_back (std::make_pair (Simulator::Now ()
+                                                 + m_queueEntryExpireTime,
+                                                 generationID));
+    }
+  if (decoder->second.GetGenerationSize () != coefficients.size ()
+      || decoder->second.GetSymbolSize () != cHeader.GetSymbolSize ())
+    {
+      NS_LOG_LOGIC ("Coded packet does not match generation " << generationID);
+      return;
+    }
+  std::vector<uint8_t> symbol (cHeader.GetSymbolSize ());
+  packet->CopyData (&symbol[0], symbol.size ());
+  if (!decoder->second.AddSymbol (&coefficients[0], &symbol[0])
+      || !decoder->second.IsComplete ())
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Decoded generation " << generationID);
+  for (uint32_t i = 0; i < decoder->second.GetGenerationSize (); ++i)
+    {
+      const uint8_t *source = decoder->second.GetSymbol (i);
+      uint32_t size = (source[0] << 8) | source[1];
+      if (size + 2 > decoder->second.GetSymbolSize ())
+        {
+          continue;
+        }
+      Ptr<Packet> decoded = Create<Packet> (source + 2, size);
+      m_localDeliverTrace (decoded, header);
+      lcb (decoded, header, iif);
+    }
+  m_decoders.erase (decoder);
+  // Late packets were stamped before now and expire before this
+  m_decodedGenerations.insert (generationID);
+  m_decodedExpiry.push_back (std::make_pair (Simulator::Now ()
+                                             + m_queueEntryExpireTime,
+                                             generationID));
+}
+
+bool
+RoutingProtocol::StoreDeliveredPacket (Ptr<const Packet> p,
+                                       const EpidemicHeader &eHeader,
+                                       const Ipv4Header &header,
+                                       UnicastForwardCallback ucb,
+                                       ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << header);
+  if (m_delivered.GetSize () != 0)
+    {
+      if (!m_delivered.Record (eHeader.GetPacketID ()))
+        {
+          m_duplicateTrace (p, eHeader.GetPacketID ());
+          return false;
+        }
+      // Only chunks stay in the queue, until their bundle is reassembled
+      if (!eHeader.IsChunk ())
+        {
+          return true;
+        }
+    }
+  QueueEntry newEntry (p, header, ucb, ecb,
+                       m_queueEntryExpireTime + eHeader.GetTimeStamp (),
+                       eHeader.GetPacketID ());
+  // A packet already in the epidemic buffer has been delivered
+  return m_queue.Insert (newEntry);
+}
+
+uint32_t
+RoutingProtocol::EnqueueRelayedPacket (Ptr<const Packet> p,
+                                       const Ipv4Header &header,
+                                       UnicastForwardCallback ucb,
+                                       ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << header);
+  // If the packet is generated in another node, read the epidemic header
+  EpidemicHeader current_Header;
+  p->PeekHeader (current_Header);
+  if (!current_Header.IsValid ())
+    {
+      NS_LOG_DEBUG ("Invalid epidemic header, packet is dropped");
+      return 0;
+    }
+  if (current_Header.GetHopCount () <= 1
+      || (current_Header.GetTimeStamp ()
+          + m_queueEntryExpireTime) < Simulator::Now () )
+    {
+      // Exit  the function to not add the packet to the queue
+      // since the flood count limit is reached
+      NS_LOG_DEBUG ("Exit the function  and not add the "
+                    "packet to the queue since the flood count limit is reached");
+      return 0;
+    }
+  if (m_queue.Contains (current_Header.GetPacketID ()))
+    {
+      // Most received packets are known, they are not copied
+      m_duplicateTrace (p, current_Header.GetPacketID ());
+      return 0;
+    }
+  Ptr<Packet> packet = p->Copy ();
+  packet->RemoveHeader (current_Header);
+  QueueEntry newEntry (packet, header, ucb, ecb);
+  // If the packet is generated in another node,
+  // use the timestamp from the epidemic header
+  newEntry.SetExpireTime (m_queueEntryExpireTime +
+                          current_Header.GetTimeStamp ());
+  // If the packet is generated in another node,
+  // use the PacketID from the epidemic header
+  newEntry.SetPacketID (current_Header.GetPacketID ());
+  //Decrease the packet flood counter
+  current_Header.SetHopCount (
+    current_Header.GetHopCount () - 1);
+  // Add the updated header
+  packet->AddHeader (current_Header);
+  if (!m_queue.Insert (newEntry))
+    {
+      return 0;
+    }
+  return current_Header.GetPacketID ();
+}
+
+void
+RoutingProtocol::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  NS_LOG_FUNCTION (this << ipv4);
+  m_ipv4 = ipv4;
+  Simulator::ScheduleNow (&RoutingProtocol::Start,this);
+}
+
+void
+RoutingProtocol::NotifyInterfaceUp (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
+  Ipv4InterfaceAddress iface = l3->GetAddress (i,0);
+  if (iface.GetLocal () == Ipv4Address ("127.0.0.1"))
+    {
+      UpdateInterfaceTables ();
+      return;
+    }
+  if (m_mainAddress == Ipv4Address ())
+    {
+      m_mainAddress = iface.GetLocal ();
+    }
+
+  /*
+  Create a socket to be used for epidemic routing port
+  */
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<Socket> socket = Socket::CreateSocket (GetObject<Node> (),tid);
+  socket->SetRecvCallback (MakeCallback (&RoutingProtocol::RecvEpidemic,this));
+  socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), EPIDEMIC_PORT));
+  socket->BindToNetDevice (l3->GetNetDevice (i));
+  socket->SetAllowBroadcast (true);
+  m_socketAddresses.insert (std::make_pair (socket,iface));
+  UpdateInterfaceTables ();
+}
+
+void
+RoutingProtocol::NotifyInterfaceDown (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << m_ipv4->GetAddress (i, 0).GetLocal ());
   // Disable layer 2 link state monitoring (if possible)
   Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
   Ptr<NetDevice> dev = l3->GetNetDevice (i);
@@ -648,6 +1560,7 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
   NS_ASSERT (socket);
   socket->Close ();
   m_socketAddresses.erase (socket);
+  UpdateInterfaceTables ();
 }
 
 void
@@ -667,6 +1580,7 @@ RoutingProtocol::NotifyAddAddress (uint32_t i,Ipv4InterfaceAddress address)
         {
           if (iface.GetLocal () == Ipv4Address ("127.0.0.1"))
             {
+              UpdateInterfaceTables ();
               return;
             }
           // Create a socket to listen only on this interface
@@ -688,9 +1602,7 @@ RoutingProtocol::NotifyAddAddress (uint32_t i,Ipv4InterfaceAddress address)
       NS_LOG_LOGIC ("Epidemic does not work with more then "
                     "one address per each interface. Ignore added address");
     }
-
-
-
+  UpdateInterfaceTables ();
 }
 
 void
@@ -725,36 +1637,197 @@ RoutingProtocol::NotifyRemoveAddress (uint32_t i,Ipv4InterfaceAddress address)
     {
       NS_LOG_LOGIC ("Remove address not participating in Epidemic operation");
     }
+  UpdateInterfaceTables ();
 }
 
 
 
 void
-RoutingProtocol::SendDisjointPackets (SummaryVectorHeader packet_SMV,
-                                      Ipv4Address dest)
+RoutingProtocol::SendDisjointPackets (std::vector<uint32_t> packets,
+                                      Ipv4Address dest, bool retransmission)
 {
-  NS_LOG_FUNCTION (this << dest);
+  NS_LOG_FUNCTION (this << dest << packets.size ());
   /*
   This function is used to find send the packets listed in the vector list
   */
-  SummaryVectorHeader list = m_queue.FindDisjointPackets (packet_SMV);
+  if (m_sessions.GetPeerState (dest).delivered.GetSourceCount () != 0)
+    {
+      FilterDelivered (dest, packets);
+    }
+  if (m_forwardingMode == SPRAY_AND_WAIT)
+    {
+      FilterSprayAndWait (dest, packets);
+    }
+  else if (m_forwardingMode == PROPHET)
+    {
+      FilterProphet (dest, packets);
+    }
+  if (m_forwardingMode == MAXPROP || m_contactBudget)
+    {
+      // Ordered once, Offer keeps the order within resumed and new packets
+      m_queue.OrderTransferList (packets, dest);
+    }
+  if (retransmission)
+    {
+      // The packets sent on the first copy are still on their way
+      m_sessions.OfferRemaining (dest, packets);
+    }
+  else
+    {
+      // Packets offered in an interrupted session go first
+      m_sessions.Offer (dest, packets);
+    }
+  if (m_contactBudget)
+    {
+      ApplyContactBudget (dest, packets);
+    }
+  if (m_aggregation)
+    {
+      SendAggregatedPackets (dest, packets);
+      return;
+    }
   for (std::vector<uint32_t>::iterator
-       i = list.m_packets.begin ();
-       i  != list.m_packets.end ();
+       i = packets.begin ();
+       i  != packets.end ();
        ++i)
     {
-      QueueEntry newEntry = m_queue.Find (*i);
-      if (newEntry.GetPacket ())
+      QueueTransfer (dest, *i);
+    }
+}
+
+
+
+void
+RoutingProtocol::FilterSprayAndWait (Ipv4Address peer,
+                                     std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  std::vector<uint32_t> handed;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      QueueEntry entry = m_queue.Find (*i);
+      if (!entry.GetPacket ())
         {
+          continue;
+        }
+      Ipv4Header header = entry.GetIpv4Header ();
+      // Packets SendPacketFromQueue would not send keep their budget
+      if (peer == header.GetSource ()
+          || IsMyOwnAddress (header.GetDestination ()))
+        {
+          continue;
+        }
+      EpidemicHeader eHeader;
+      entry.GetPacket ()->PeekHeader (eHeader);
+      // In the wait phase, a packet only goes to its destination
+      if (eHeader.HasCopies () && eHeader.GetCopies () <= 1
+          && header.GetDestination () != peer)
+        {
+          continue;
+        }
+      handed.push_back (*i);
+    }
+  NS_LOG_LOGIC ("Handing " << handed.size () << " of " << packets.size ()
+                           << " packets to " << peer);
+  packets.swap (handed);
+}
 
-          Simulator::Schedule (Time (0),
-                               &RoutingProtocol::SendPacketFromQueue,
-                               this,dest, newEntry);
+void
+RoutingProtocol::FilterProphet (Ipv4Address peer,
+                                std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  std::vector<uint32_t> handed;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      QueueEntry entry = m_queue.Find (*i);
+      if (!entry.GetPacket ())
+        {
+          continue;
+        }
+      Ipv4Address destination = entry.GetIpv4Header ().GetDestination ();
+      if (destination == peer
+          || m_prophet.GetPeer (peer, destination) > m_prophet.Get (destination))
+        {
+          handed.push_back (*i);
         }
     }
+  NS_LOG_LOGIC ("Handing " << handed.size () << " of " << packets.size ()
+                           << " packets to " << peer);
+  packets.swap (handed);
 }
 
+void
+RoutingProtocol::FilterDelivered (Ipv4Address peer,
+                                  std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  const DeliveredWindow &delivered = m_sessions.GetPeerState (peer).delivered;
+  std::vector<uint32_t> handed;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      // The windows only cover the packets delivered to the peer
+      QueueEntry entry = m_queue.Find (*i);
+      if (entry.GetPacket ()
+          && entry.GetIpv4Header ().GetDestination () == peer
+          && delivered.IsDelivered (*i))
+        {
+          continue;
+        }
+      handed.push_back (*i);
+    }
+  NS_LOG_LOGIC ("Handing " << handed.size () << " of " << packets.size ()
+                           << " packets to " << peer);
+  packets.swap (handed);
+}
 
+double
+RoutingProtocol::GetMaxPropCost (const QueueEntry &entry)
+{
+  EpidemicHeader header;
+  entry.GetPacket ()->PeekHeader (header);
+  uint32_t remaining = header.GetHopCount ();
+  // Packets from nodes with a larger HopCount may have more hops left
+  if (remaining > m_hopCount
+      || m_hopCount - remaining < m_maxPropHopThreshold)
+    {
+      // Young packets go first, fewest hops travelled first
+      return -static_cast<double> (remaining);
+    }
+  return m_maxprop.GetCost (entry.GetIpv4Header ().GetDestination ());
+}
+
+QueueEntry
+RoutingProtocol::SplitCopies (QueueEntry entry)
+{
+  NS_LOG_FUNCTION (this << entry.GetPacketID ());
+  if (!entry.GetPacket ())
+    {
+      return entry;
+    }
+  EpidemicHeader eHeader;
+  entry.GetPacket ()->PeekHeader (eHeader);
+  if (!eHeader.HasCopies () || eHeader.GetCopies () <= 1)
+    {
+      return entry;
+    }
+  uint32_t copies = eHeader.GetCopies ();
+  // The peer gets the lower half, this node keeps the rest
+  Ptr<Packet> kept = entry.GetPacket ()->Copy ();
+  kept->RemoveHeader (eHeader);
+  Ptr<Packet> handed = kept->Copy ();
+  eHeader.SetCopies (copies - copies / 2);
+  kept->AddHeader (eHeader);
+  eHeader.SetCopies (copies / 2);
+  handed->AddHeader (eHeader);
+  entry.SetPacket (kept);
+  m_queue.Enqueue (entry);
+  entry.SetPacket (handed);
+  return entry;
+}
 
 Ptr<Socket>
 RoutingProtocol::FindSocketWithInterfaceAddress
@@ -777,12 +1850,22 @@ RoutingProtocol::FindSocketWithInterfaceAddress
 
 
 void
-RoutingProtocol::SendSummaryVector (Ipv4Address dest,bool firstNode)
+RoutingProtocol::SendSummaryVector (Ipv4Address dest,bool firstNode,
+                                    bool retransmission)
 {
-  NS_LOG_FUNCTION (this << dest << firstNode);
+  NS_LOG_FUNCTION (this << dest << firstNode << retransmission);
   // Creating the packet
   Ptr<Packet> packet_summary = Create<Packet> ();
-  SummaryVectorHeader header_summary = m_queue.GetSummaryVector ();
+  // The IDs are written from the queue index when the header is added
+  m_queue.DropExpiredPackets ();
+  SummaryVectorView header_summary (m_queue);
+  AddSummaryVectorOptions (packet_summary);
+  if (retransmission)
+    {
+      // Tells the peer that its REPLY_BACK was lost, not that a new
+      // session started
+      packet_summary->AddHeader (OptionHeader (OptionHeader::RETRANSMISSION));
+    }
   packet_summary->AddHeader (header_summary);
   TypeHeader tHeader;
   if (firstNode)
@@ -798,7 +1881,8 @@ RoutingProtocol::SendSummaryVector (Ipv4Address dest,bool firstNode)
   ControlTag tempTag (ControlTag::CONTROL);
   packet_summary->AddPacketTag (tempTag);
   // Send the summary vector
-  NS_LOG_INFO ("Sending the summary vector 2 packet " << header_summary );
+  NS_LOG_INFO ("Sending the summary vector 2 packet with "
+               << header_summary.Size () << " IDs");
   InetSocketAddress addr = InetSocketAddress (dest, EPIDEMIC_PORT);
   SendPacket (packet_summary, addr);
 
@@ -806,6 +1890,151 @@ RoutingProtocol::SendSummaryVector (Ipv4Address dest,bool firstNode)
 
 
 
+void
+RoutingProtocol::AddSummaryVectorOptions (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  if (m_contactBudget)
+    {
+      Ptr<MobilityModel> mobility = GetObject<Node> ()->GetObject<MobilityModel> ();
+      if (mobility != 0)
+        {
+          ContactHeader contact (mobility->GetPosition (),
+                                 mobility->GetVelocity ());
+          packet->AddHeader (contact);
+          OptionHeader option (OptionHeader::CONTACT,
+                               contact.GetSerializedSize ());
+          packet->AddHeader (option);
+        }
+    }
+  if (m_forwardingMode == PROPHET)
+    {
+      // Values that quantize to zero are not worth sending
+      PredictabilityHeader predictability (m_prophet.GetEntries (1 / 255.0));
+      packet->AddHeader (predictability);
+      OptionHeader option (OptionHeader::PREDICTABILITY,
+                           predictability.GetSerializedSize ());
+      packet->AddHeader (option);
+    }
+  else if (m_forwardingMode == MAXPROP)
+    {
+      PredictabilityHeader encounters (m_maxprop.GetEntries ());
+      packet->AddHeader (encounters);
+      OptionHeader option (OptionHeader::ENCOUNTER,
+                           encounters.GetSerializedSize ());
+      packet->AddHeader (option);
+    }
+  if (m_delivered.GetSourceCount () != 0)
+    {
+      // Delivered packets are not in the summary vector, their windows
+      // are sent instead, as many as the option length allows
+      uint32_t entrySize = 2 * sizeof (uint16_t) + m_delivered.GetSize () / 8;
+      DeliveredList entries = m_delivered.GetEntries (
+          (0xFFFF - 2 * sizeof (uint16_t)) / entrySize);
+      if (!entries.empty ())
+        {
+          DeliveredHeader delivered (entries);
+          packet->AddHeader (delivered);
+          OptionHeader option (OptionHeader::DELIVERED,
+                               delivered.GetSerializedSize ());
+          packet->AddHeader (option);
+        }
+    }
+}
+
+void
+RoutingProtocol::ReadSummaryVectorOptions (Ptr<Packet> packet,
+                                           Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << packet << sender);
+  PeerState &state = m_sessions.GetPeerState (sender);
+  state.hasContact = false;
+  state.retransmitted = false;
+  state.delivered.Clear ();
+  // The encounter is counted once all options are read
+  bool encounter = false;
+  PredictabilityList entries;
+  OptionHeader option;
+  while (packet->GetSize () >= option.GetSerializedSize ())
+    {
+      packet->RemoveHeader (option);
+      if (!option.IsValid () || packet->GetSize () < option.GetLength ())
+        {
+          NS_LOG_LOGIC ("Truncated option " << (uint32_t) option.GetOptionType ());
+          return;
+        }
+      ContactHeader contact;
+      if (option.GetOptionType () == OptionHeader::CONTACT
+          && option.GetLength () == contact.GetSerializedSize ())
+        {
+          packet->RemoveHeader (contact);
+          state.hasContact = contact.IsValid ();
+          state.position = contact.GetPosition ();
+          state.velocity = contact.GetVelocity ();
+        }
+      else if ((option.GetOptionType () == OptionHeader::PREDICTABILITY
+                && m_forwardingMode == PROPHET)
+               || (option.GetOptionType () == OptionHeader::ENCOUNTER
+                   && m_forwardingMode == MAXPROP))
+        {
+          PredictabilityHeader predictability;
+          packet->RemoveHeader (predictability);
+          if (!predictability.IsValid ()
+              || predictability.GetSerializedSize () != option.GetLength ())
+            {
+              NS_LOG_LOGIC ("Malformed predictability option");
+              return;
+            }
+          entries.clear ();
+          for (PredictabilityList::const_iterator i =
+                 predictability.GetEntries ().begin ();
+               i != predictability.GetEntries ().end (); ++i)
+            {
+              if (!IsMyOwnAddress (i->first))
+                {
+                  entries.push_back (*i);
+                }
+            }
+          encounter = true;
+        }
+      else if (option.GetOptionType () == OptionHeader::RETRANSMISSION
+               && option.GetLength () == 0)
+        {
+          state.retransmitted = true;
+        }
+      else if (option.GetOptionType () == OptionHeader::DELIVERED)
+        {
+          DeliveredHeader delivered;
+          packet->RemoveHeader (delivered);
+          if (!delivered.IsValid ()
+              || delivered.GetSerializedSize () != option.GetLength ())
+            {
+              NS_LOG_LOGIC ("Malformed delivered option");
+              return;
+            }
+          state.delivered.SetEntries (delivered.GetEntries ());
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Skipping option " << (uint32_t) option.GetOptionType ());
+          packet->RemoveAtStart (option.GetLength ());
+        }
+    }
+  // A retransmitted summary vector belongs to a session already counted
+  if (!encounter || state.retransmitted)
+    {
+      return;
+    }
+  if (m_forwardingMode == PROPHET)
+    {
+      m_prophet.Update (sender, entries);
+    }
+  else
+    {
+      m_maxprop.Update (sender, entries);
+    }
+}
+
 void
 RoutingProtocol::RecvEpidemic (Ptr<Socket> socket)
 {
@@ -818,41 +2047,564 @@ RoutingProtocol::RecvEpidemic (Ptr<Socket> socket)
 
   InetSocketAddress inetSourceAddr = InetSocketAddress::ConvertFrom (address);
   Ipv4Address sender = inetSourceAddr.GetIpv4 ();
-  if (tHeader.GetMessageType () == TypeHeader::BEACON)
+  if (!tHeader.IsValid ())
+    {
+      NS_LOG_LOGIC ("Unknown MessageType packet ");
+    }
+  else if (tHeader.GetMessageType () == TypeHeader::BEACON)
     {
       NS_LOG_LOGIC ("Got a beacon from " << sender << " " << packet->GetUid ()
                                          << " " << m_mainAddress);
-      // Anti-entropy session
-      // Check if you have the smaller address and the host has not been
-      // contacted recently
-      if (m_mainAddress.Get () < sender.Get ()
-          && !IsHostContactedRecently (sender))
+      m_beaconRxTrace (packet, sender);
+      if (m_hybrid)
         {
-          SendSummaryVector (sender,true);
+          if (!tHeader.IsCompact ())
+            {
+              EpidemicHeader header;
+              packet->RemoveHeader (header);
+            }
+          if (packet->GetSize () > 0)
+            {
+              LinkStateHeader linkState;
+              packet->RemoveHeader (linkState);
+              if (linkState.IsValid ())
+                {
+                  m_linkState.Update (linkState.GetEntries ());
+                }
+            }
         }
+      HandleBeacon (sender);
     }
   else if (tHeader.GetMessageType () == TypeHeader::REPLY)
     {
       NS_LOG_LOGIC ("Got a A reply from " << sender << " "
                                           << packet->GetUid () << " " << m_mainAddress);
-      SummaryVectorHeader packet_SMV;
+      SummaryVectorDifference packet_SMV (m_queue, m_maxSummaryVectorSize);
       packet->RemoveHeader (packet_SMV);
-      SendDisjointPackets (packet_SMV, sender);
-      SendSummaryVector (sender,false);
+      if (!packet_SMV.IsValid ())
+        {
+          NS_LOG_LOGIC ("Invalid summary vector from " << sender);
+          return;
+        }
+      ReadSummaryVectorOptions (packet, sender);
+      PeerState &state = m_sessions.GetPeerState (sender);
+      state.timedOut = false;
+      state.missing = packet_SMV.GetMissing ();
+      state.answerPending = true;
+      RequestAnswer (sender);
     }
   else if (tHeader.GetMessageType () == TypeHeader::REPLY_BACK)
     {
       NS_LOG_LOGIC ("Got a A reply back from " << sender
                                                << " " << packet->GetUid () << " " << m_mainAddress);
-      SummaryVectorHeader packet_SMV;
+      SummaryVectorDifference packet_SMV (m_queue, m_maxSummaryVectorSize);
       packet->RemoveHeader (packet_SMV);
-      SendDisjointPackets (packet_SMV, sender);
-
+      if (!packet_SMV.IsValid ())
+        {
+          NS_LOG_LOGIC ("Invalid summary vector from " << sender);
+          return;
+        }
+      ReadSummaryVectorOptions (packet, sender);
+      m_sessions.GetPeerState (sender).timedOut = false;
+      SendDisjointPackets (packet_SMV.GetMissing (), sender);
+      if (m_sessions.Complete (sender))
+        {
+          m_sessionEndTrace (sender, true);
+          GrantPendingSessions ();
+        }
+    }
+  else if (tHeader.GetMessageType () == TypeHeader::AGGREGATE)
+    {
+      NS_LOG_LOGIC ("Got an aggregate from " << sender << " "
+                                             << packet->GetUid () << " " << m_mainAddress);
+      RecvAggregate (packet);
     }
   else
     {
       NS_LOG_LOGIC ("Unknown MessageType packet ");
     }
 }
+
+void
+RoutingProtocol::RecvLinkLayerBeacon (Ptr<NetDevice> device,
+                                      Ptr<const Packet> packet,
+                                      uint16_t protocol, const Address &from,
+                                      const Address &to,
+                                      NetDevice::PacketType packetType)
+{
+  NS_LOG_FUNCTION (this << device << packet << protocol << from);
+  Ptr<Packet> copy = packet->Copy ();
+  TypeHeader tHeader;
+  copy->RemoveHeader (tHeader);
+  if (!tHeader.IsMessageType (TypeHeader::BEACON))
+    {
+      NS_LOG_LOGIC ("Unknown link-layer MessageType packet ");
+      return;
+    }
+  BeaconHeader bHeader;
+  copy->RemoveHeader (bHeader);
+  Ipv4Address sender = bHeader.GetSender ();
+  if (!bHeader.IsValid () || IsMyOwnAddress (sender))
+    {
+      return;
+    }
+  if (m_hybrid && copy->GetSize () > 0)
+    {
+      LinkStateHeader linkState;
+      copy->RemoveHeader (linkState);
+      if (linkState.IsValid ())
+        {
+          m_linkState.Update (linkState.GetEntries ());
+        }
+    }
+  NS_LOG_LOGIC ("Got a link-layer beacon from " << sender << " "
+                                                << packet->GetUid () << " "
+                                                << m_mainAddress);
+  m_beaconRxTrace (packet, sender);
+  m_queue.DropExpiredPackets ();
+  HandleBeacon (sender);
+}
+
+void
+RoutingProtocol::RecvPromiscuous (Ptr<NetDevice> device,
+                                  Ptr<const Packet> packet,
+                                  uint16_t protocol, const Address &from,
+                                  const Address &to,
+                                  NetDevice::PacketType packetType)
+{
+  NS_LOG_FUNCTION (this << device << packet << protocol << from);
+  if (protocol != Ipv4L3Protocol::PROT_NUMBER
+      || m_ipv4->GetInterfaceForDevice (device) < 0)
+    {
+      return;
+    }
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  ControlTag tag;
+  copy->PeekPacketTag (tag);
+  if (m_overhearBundles && tag.GetTagType () == ControlTag::NOT_SET
+      && packetType == NetDevice::PACKET_OTHERHOST)
+    {
+      OverhearPacket (copy, ipHeader);
+    }
+  if (!m_passiveDiscovery)
+    {
+      return;
+    }
+  Ipv4Address sender;
+  if (tag.GetTagType () == ControlTag::CONTROL)
+    {
+      /*
+       * Control packets are sent by the epidemic agent of the
+       * transmitting node, so their source is the neighbor itself.
+       * Remember its link-layer address to recognize its data packets.
+       */
+      sender = ipHeader.GetSource ();
+      m_linkNeighbors[from] = sender;
+    }
+  else
+    {
+      /*
+       * Data packets keep the IP source of their originator, so the
+       * neighbor is only known if it has sent a control packet before.
+       */
+      LinkNeighborMap::const_iterator neighbor = m_linkNeighbors.find (from);
+      if (neighbor == m_linkNeighbors.end ())
+        {
+          return;
+        }
+      sender = neighbor->second;
+    }
+  if (IsMyOwnAddress (sender))
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Overheard a packet from " << sender << " "
+                                           << packet->GetUid () << " "
+                                           << m_mainAddress);
+  HandleBeacon (sender);
+}
+
+void
+RoutingProtocol::OverhearPacket (Ptr<const Packet> packet,
+                                 const Ipv4Header &header)
+{
+  NS_LOG_FUNCTION (this << packet->GetUid () << header);
+  /*
+   * Packets for this node are left to the anti-entropy session, storing
+   * them here would make RouteInput treat them as already delivered.
+   */
+  if (m_forwardCallback.IsNull () || IsMyOwnAddress (header.GetDestination ()))
+    {
+      return;
+    }
+  uint32_t packetID = EnqueueRelayedPacket (packet, header, m_forwardCallback,
+                                            m_errorCallback);
+  if (packetID != 0)
+    {
+      NS_LOG_LOGIC ("Stored overheard packet " << packetID
+                                               << " at " << m_mainAddress);
+    }
+}
+
+void
+RoutingProtocol::HandleBeacon (Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << sender);
+  if (m_hybrid)
+    {
+      m_linkState.AddNeighbor (sender);
+    }
+  // Anti-entropy session
+  // Check if you have the smaller address and the host has not been
+  // contacted recently
+  if (m_mainAddress.Get () < sender.Get ()
+      && !IsHostContactedRecently (sender))
+    {
+      m_sessions.GetPeerState (sender).resumed = false;
+      RequestSession (sender);
+    }
+  else if (m_resumeSessions && IsContactCutShort (sender))
+    {
+      NS_LOG_LOGIC ("Resuming the session with " << sender << " at "
+                                                  << m_mainAddress);
+      m_sessions.GetPeerState (sender).resumed = true;
+      RequestSession (sender);
+    }
+}
+
+void
+RoutingProtocol::ForwardInCluster (uint32_t packetID)
+{
+  NS_LOG_FUNCTION (this << packetID);
+  if (!m_hybrid)
+    {
+      return;
+    }
+  QueueEntry entry = m_queue.Find (packetID);
+  Ipv4Address nextHop;
+  if (entry.GetPacketID () == 0
+      || !m_linkState.GetNextHop (entry.GetIpv4Header ().GetDestination (),
+                                  nextHop))
+    {
+      // Left to store-carry-forward
+      return;
+    }
+  NS_LOG_LOGIC ("Forwarding packet " << packetID << " to "
+                                     << entry.GetIpv4Header ().GetDestination ()
+                                     << " through " << nextHop);
+  QueueTransfer (nextHop, packetID);
+}
+
+void
+RoutingProtocol::QueueTransfer (Ipv4Address peer, uint32_t packetID)
+{
+  NS_LOG_FUNCTION (this << peer << packetID);
+  PeerState &state = m_sessions.GetPeerState (peer);
+  if (!state.pending.insert (packetID).second)
+    {
+      NS_LOG_LOGIC ("Packet " << packetID << " already waits for " << peer);
+      return;
+    }
+  state.transfer.push_back (packetID);
+  if (!state.drain.IsRunning ())
+    {
+      state.drain = Simulator::Schedule (Time (0),
+                                         &RoutingProtocol::DrainTransfer,
+                                         this, peer);
+    }
+}
+
+void
+RoutingProtocol::DrainTransfer (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  PeerState &state = m_sessions.GetPeerState (peer);
+  while (!state.transfer.empty ())
+    {
+      uint32_t packetID = state.transfer.front ();
+      state.transfer.pop_front ();
+      state.pending.erase (packetID);
+      // Packets dropped meanwhile are skipped
+      QueueEntry entry = m_queue.Find (packetID);
+      if (entry.GetPacket ())
+        {
+          SendPacketFromQueue (peer, entry);
+        }
+    }
+}
+
+bool
+RoutingProtocol::IsContactCutShort (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  PeerState &state = m_sessions.GetPeerState (peer);
+  /*
+   * Only a timeout is taken as a cut.  Packets announced by the peer may
+   * never come, when the peer filters them or they were delivered here,
+   * so their absence does not tell that the contact ended early.
+   */
+  return !state.resumed && m_sessions.Find (peer) == 0 && state.timedOut;
+}
+
+void
+RoutingProtocol::RequestSession (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  if (m_sessions.Request (peer))
+    {
+      ScheduleSessionStart (peer);
+    }
+}
+
+void
+RoutingProtocol::ScheduleSessionStart (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  if (m_sessionStartJitter.IsZero ())
+    {
+      StartSession (peer);
+      return;
+    }
+  Time backoff = Seconds (m_sessionJitter->GetValue ());
+  NS_LOG_LOGIC ("Session with " << peer << " starts in " << backoff);
+  Simulator::Schedule (backoff, &RoutingProtocol::StartSession, this, peer);
+}
+
+void
+RoutingProtocol::StartSession (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  Session *session = m_sessions.Find (peer);
+  // A session answered meanwhile has already exchanged summary vectors
+  if (session == 0 || session->state != Session::STARTING)
+    {
+      return;
+    }
+  m_sessions.MarkStarted (peer);
+  m_sessionStartTrace (peer);
+  SendSummaryVector (peer,true);
+  session->timeout = Simulator::Schedule (m_sessionTimeout,
+                                          &RoutingProtocol::SessionTimeout,
+                                          this, peer);
+}
+
+void
+RoutingProtocol::SessionTimeout (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  Session *session = m_sessions.Find (peer);
+  if (session == 0)
+    {
+      return;
+    }
+  if (session->retries < m_sessionRetries)
+    {
+      session->retries++;
+      NS_LOG_LOGIC ("Retransmitting the summary vector to " << peer
+                                                            << " at " << m_mainAddress);
+      SendSummaryVector (peer,true,true);
+      session->timeout = Simulator::Schedule (m_sessionTimeout,
+                                              &RoutingProtocol::SessionTimeout,
+                                              this, peer);
+      return;
+    }
+  NS_LOG_LOGIC ("Session with " << peer << " failed at " << m_mainAddress);
+  m_sessions.GetPeerState (peer).timedOut = true;
+  if (m_sessions.Fail (peer))
+    {
+      m_sessionEndTrace (peer, false);
+    }
+  GrantPendingSessions ();
+}
+
+void
+RoutingProtocol::GrantPendingSessions ()
+{
+  NS_LOG_FUNCTION (this);
+  Ipv4Address next;
+  while (m_sessions.GrantPending (next))
+    {
+      if (m_sessions.GetPeerState (next).answerPending)
+        {
+          AnswerSession (next);
+        }
+      else
+        {
+          ScheduleSessionStart (next);
+        }
+    }
+}
+
+void
+RoutingProtocol::RequestAnswer (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  // A session already running with the peer answers at once
+  if (m_sessions.Find (peer) != 0 || m_sessions.Request (peer))
+    {
+      AnswerSession (peer);
+      return;
+    }
+  NS_LOG_LOGIC ("Answer to " << peer << " waits for a session slot at "
+                             << m_mainAddress);
+}
+
+void
+RoutingProtocol::AnswerSession (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  PeerState &state = m_sessions.GetPeerState (peer);
+  Session *session = m_sessions.Find (peer);
+  if (session == 0 || !state.answerPending)
+    {
+      return;
+    }
+  state.answerPending = false;
+  std::vector<uint32_t> missing;
+  missing.swap (state.missing);
+  // A retransmitted REPLY means that the REPLY_BACK was lost, the
+  // REPLY of a new or resumed session offers the lost packets again
+  SendDisjointPackets (missing, peer, state.retransmitted);
+  SendSummaryVector (peer,false);
+  if (session->state == Session::WAIT_REPLY_BACK)
+    {
+      // The session this node started goes on
+      return;
+    }
+  if (session->state == Session::STARTING)
+    {
+      m_sessions.MarkAnswered (peer);
+    }
+  // The slot is held while the peer waits for the REPLY_BACK
+  session->timeout.Cancel ();
+  session->timeout = Simulator::Schedule (m_sessionTimeout,
+                                          &RoutingProtocol::EndAnswer,
+                                          this, peer);
+}
+
+void
+RoutingProtocol::EndAnswer (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  Session *session = m_sessions.Find (peer);
+  if (session == 0 || session->state != Session::ANSWERED)
+    {
+      return;
+    }
+  m_sessions.End (peer);
+  GrantPendingSessions ();
+}
+
+Time
+RoutingProtocol::EstimateContactTime (Vector position, Vector velocity,
+                                      Vector peerPosition, Vector peerVelocity,
+                                      double range)
+{
+  // Solve |r + v t| = range for the relative position r and velocity v
+  double rx = peerPosition.x - position.x;
+  double ry = peerPosition.y - position.y;
+  double rz = peerPosition.z - position.z;
+  double vx = peerVelocity.x - velocity.x;
+  double vy = peerVelocity.y - velocity.y;
+  double vz = peerVelocity.z - velocity.z;
+  double a = vx * vx + vy * vy + vz * vz;
+  double b = 2 * (rx * vx + ry * vy + rz * vz);
+  double c = rx * rx + ry * ry + rz * rz - range * range;
+  if (c > 0)
+    {
+      return Seconds (0);
+    }
+  if (a == 0)
+    {
+      return Time::Max ();
+    }
+  return Seconds ((-b + std::sqrt (b * b - 4 * a * c)) / (2 * a));
+}
+
+void
+RoutingProtocol::ApplyContactBudget (Ipv4Address peer,
+                                     std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  PeerState &state = m_sessions.GetPeerState (peer);
+  Ptr<MobilityModel> mobility = GetObject<Node> ()->GetObject<MobilityModel> ();
+  if (!state.hasContact || mobility == 0)
+    {
+      return;
+    }
+  Time remaining = EstimateContactTime (mobility->GetPosition (),
+                                        mobility->GetVelocity (),
+                                        state.position, state.velocity,
+                                        m_contactRange);
+  // A peer already out of range contradicts the summary vector it just
+  // sent, so the estimate is not trusted
+  if (remaining == Time::Max () || !remaining.IsStrictlyPositive ())
+    {
+      return;
+    }
+  double budget = remaining.GetSeconds () * m_contactDataRate.GetBitRate () / 8;
+  double used = 0;
+  uint32_t fits = 0;
+  for (; fits < packets.size (); ++fits)
+    {
+      QueueEntry entry = m_queue.Find (packets[fits]);
+      if (entry.GetPacket ())
+        {
+          used += entry.GetPacket ()->GetSize ()
+            + entry.GetIpv4Header ().GetSerializedSize ();
+        }
+      if (used > budget)
+        {
+          break;
+        }
+    }
+  NS_LOG_LOGIC ("Contact with " << peer << " lasts " << remaining << ", "
+                                << fits << " of " << packets.size ()
+                                << " packets fit");
+  // Packets that are not sent are not offered either
+  for (uint32_t i = fits; i < packets.size (); ++i)
+    {
+      state.offered.erase (packets[i]);
+    }
+  packets.resize (fits);
+}
+
+uint32_t
+RoutingProtocol::GetActiveSessionCount () const
+{
+  return m_sessions.GetActiveCount ();
+}
+
+uint32_t
+RoutingProtocol::GetPendingSessionCount () const
+{
+  return m_sessions.GetPendingCount ();
+}
+
+Time
+RoutingProtocol::GetMeanSessionWaitTime () const
+{
+  return m_sessions.GetMeanWaitTime ();
+}
+
+Time
+RoutingProtocol::GetMaxSessionWaitTime () const
+{
+  return m_sessions.GetMaxWaitTime ();
+}
+
+uint64_t
+RoutingProtocol::GetFailedSessionCount () const
+{
+  return m_sessions.GetFailedCount ();
+}
+
+uint64_t
+RoutingProtocol::GetRecoveredSessionCount () const
+{
+  return m_sessions.GetRecoveredCount ();
+}
 } //end namespace epidemic
 } //end namespace ns3
@@ -32,9 +32,17 @@
 
 #include "epidemic-packet-queue.h"
 #include "epidemic-packet.h"
+#include "epidemic-beacon-scheduler.h"
+#include "epidemic-session-manager.h"
+#include "epidemic-network-coding.h"
+#include "epidemic-prophet.h"
+#include "epidemic-maxprop.h"
+#include "epidemic-link-state.h"
+#include "epidemic-delivered-window.h"
 #include "ns3/random-variable-stream.h"
 #include "epidemic-tag.h"
 #include <vector>
+#include <deque>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/node.h"
@@ -44,6 +52,7 @@
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/output-stream-wrapper.h"
 #include "ns3/timer.h"
+#include "ns3/data-rate.h"
 #include <iostream>
 #include <algorithm>
 #include <functional>
@@ -83,8 +92,57 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /// How copies of a packet are handed to peers
+  enum ForwardingMode
+  {
+    EPIDEMIC = 0,     //!< every peer missing a packet gets a copy
+    SPRAY_AND_WAIT,   //!< binary Spray-and-Wait with a copy budget
+    PROPHET,          //!< peers with a higher delivery predictability
+    MAXPROP,          //!< every peer, cheapest estimated path first
+  };
+
+  /**
+   * TracedCallback signature of a packet sent to a peer.
+   * \param [in] packet the packet, with its epidemic header.
+   * \param [in] packetID the global packet ID.
+   * \param [in] peer the peer the packet is sent to.
+   */
+  typedef void (* ForwardTracedCallback)
+    (Ptr<const Packet> packet, uint32_t packetID, Ipv4Address peer);
+  /**
+   * TracedCallback signature of a packet delivered to this node.
+   * \param [in] packet the packet, without epidemic header.
+   * \param [in] header the IPv4 header of the packet.
+   */
+  typedef void (* DeliverTracedCallback)
+    (Ptr<const Packet> packet, const Ipv4Header &header);
+  /**
+   * TracedCallback signature of a beacon.
+   * \param [in] packet the beacon.
+   * \param [in] node the sender of a received beacon, or the address of
+   *  the interface a beacon is sent on, any address for a broadcast on
+   *  every interface.
+   */
+  typedef void (* BeaconTracedCallback)
+    (Ptr<const Packet> packet, Ipv4Address node);
+  /**
+   * TracedCallback signature of the start of an anti-entropy session.
+   * \param [in] peer the peer of the session.
+   */
+  typedef void (* SessionStartTracedCallback) (Ipv4Address peer);
+  /**
+   * TracedCallback signature of the end of an anti-entropy session.
+   * \param [in] peer the peer of the session.
+   * \param [in] complete true if the summary vector of the peer arrived,
+   *  false if the peer did not answer.
+   */
+  typedef void (* SessionEndTracedCallback)
+    (Ipv4Address peer, bool complete);
+
   /// Transport Port for MANET routing protocols ports, based on \RFC{5498}
   static const uint32_t EPIDEMIC_PORT = 269;
+  /// Protocol number of link-layer beacons (IEEE 802 local experimental)
+  static const uint16_t EPIDEMIC_BEACON_PROTOCOL = 0x88B5;
   /// c-tor
   RoutingProtocol ();
   /** Dummy destructor, see DoDispose. */
@@ -106,6 +164,32 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface,
                                     Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
+  /// \returns the number of anti-entropy sessions in progress
+  uint32_t GetActiveSessionCount () const;
+  /// \returns the number of peers waiting for an anti-entropy session
+  uint32_t GetPendingSessionCount () const;
+  /// \returns the mean time from session request to session start
+  Time GetMeanSessionWaitTime () const;
+  /// \returns the longest time from session request to session start
+  Time GetMaxSessionWaitTime () const;
+  /// \returns the number of sessions ended after all retransmissions failed
+  uint64_t GetFailedSessionCount () const;
+  /// \returns the number of sessions completed after a retransmission
+  uint64_t GetRecoveredSessionCount () const;
+  /**
+   * \brief Estimate how long two nodes stay within range, assuming both
+   *  keep their velocity.
+   * \param position the position of this node.
+   * \param velocity the velocity of this node.
+   * \param peerPosition the position of the peer.
+   * \param peerVelocity the velocity of the peer.
+   * \param range the communication range in meters.
+   * \returns the remaining contact time, zero if the peer is out of range
+   *  and Time::Max () if the nodes do not move apart
+   */
+  static Time EstimateContactTime (Vector position, Vector velocity,
+                                   Vector peerPosition, Vector peerVelocity,
+                                   double range);
 
 private:
   /// Main IP address for the current node
@@ -130,6 +214,28 @@ private:
   Ptr<Ipv4> m_ipv4;
   /// A map between opened sockets and IP addresses
   std::map<Ptr<Socket>, Ipv4InterfaceAddress> m_socketAddresses;
+  /// Subnet of a device, in device order
+  struct DeviceSubnet
+  {
+    Ipv4Address network;  ///< network address of the device
+    Ipv4Mask mask;        ///< network mask of the device
+    uint32_t device;      ///< device index in the node
+  };
+  /// Subnets of the devices of the node, rebuilt on interface changes
+  std::vector<DeviceSubnet> m_deviceSubnets;
+  /// Index of the loopback device, rebuilt on interface changes
+  uint32_t m_loopbackDevice;
+  /// Addresses of the epidemic interfaces, rebuilt on interface changes
+  std::set<Ipv4Address> m_localAddresses;
+  /// Cached route to a neighbor
+  struct NeighborRoute
+  {
+    Ptr<Ipv4Route> route; ///< route through the interface of the main address
+    Time expire;          ///< time after which the neighbor is gone
+  };
+  /// Routes to neighbors used to forward queued packets, cleared on
+  /// interface changes
+  std::map<Ipv4Address, NeighborRoute> m_neighborRoutes;
   /// queue associated with a node
   PacketQueue m_queue;
   /// timer for sending beacons
@@ -137,12 +243,145 @@ private:
   /// uniform random variable to be added to beacon intervals
   // to avoid collisions
   Ptr<UniformRandomVariable> m_beaconJitter;
+  /// Use the beacon scheduler shared by all nodes instead of m_beaconTimer
+  bool m_sharedBeaconScheduler;
+  /// shared beacon scheduler, set only if m_sharedBeaconScheduler is true
+  Ptr<BeaconScheduler> m_beaconScheduler;
+  /// handle of this node's beacon in m_beaconScheduler
+  uint32_t m_beaconHandle;
+  /// Send and receive beacons as link-layer frames instead of UDP
+  bool m_linkLayerBeacons;
+  /// Treat overheard frames as implicit beacons
+  bool m_passiveDiscovery;
+  /// Last time this node sent an epidemic control or data packet
+  Time m_lastTxTime;
+  /// Type to connect a link-layer address to the IP address of a neighbor
+  typedef std::map<Address, Ipv4Address> LinkNeighborMap;
+  /// Neighbors learned from overheard control packets
+  LinkNeighborMap m_linkNeighbors;
+  /// Store overheard data packets of other nodes in the queue
+  bool m_overhearBundles;
+  /// Forward callback of the IP layer, learned from RouteInput
+  UnicastForwardCallback m_forwardCallback;
+  /// Error callback of the IP layer, learned from RouteInput
+  ErrorCallback m_errorCallback;
+  /// Local delivery callback of the IP layer, learned from RouteInput
+  LocalDeliverCallback m_localDeliverCallback;
   ///  Type to connect a host address to recent contact time value
   typedef std::map<Ipv4Address, Time> HostContactMap;
   /// Pair representing host address and time value
   typedef HostContactMap::value_type   HostContactMapPair;
   /// Hash table to store recent contact time for nodes
   HostContactMap m_hostContactTime;
+  /// Maximum number of concurrent anti-entropy sessions, 0 means no limit
+  uint32_t m_maxSessions;
+  /// Upper bound of the random delay before a session is started
+  Time m_sessionStartJitter;
+  /// Time after which the summary vector of a session is retransmitted
+  Time m_sessionTimeout;
+  /// Number of summary vector retransmissions before a session fails
+  uint32_t m_sessionRetries;
+  /// Allow an early session with a peer whose last contact was cut short
+  bool m_resumeSessions;
+  /// Limit and order session transfers by the estimated contact time
+  bool m_contactBudget;
+  /// Communication range used to estimate the contact time
+  double m_contactRange;
+  /// Link rate used to convert the contact time into bytes
+  DataRate m_contactDataRate;
+  /// Send disjoint packets packed into AGGREGATE messages
+  bool m_aggregation;
+  /// Maximum size of an AGGREGATE message
+  uint32_t m_aggregationSize;
+  /// Payload size of chunks of large packets, 0 disables chunking
+  uint32_t m_chunkSize;
+  /// Send packets originated by this node as coded generations
+  bool m_networkCoding;
+  /// Maximum number of packets of a coding generation
+  uint32_t m_generationSize;
+  /// Number of coded packets sent per generation beyond its size
+  uint32_t m_codingRedundancy;
+  /// Time after which an incomplete generation is coded and sent
+  Time m_generationTimeout;
+  /// Key of an open generation: destination and IP protocol
+  typedef std::pair<Ipv4Address, uint8_t> GenerationKey;
+  /// Packets of an open coding generation
+  struct CodingGeneration
+  {
+    std::vector<Ptr<Packet> > packets;  ///< source packets
+    Ipv4Header header;                  ///< IP header of the first packet
+    UnicastForwardCallback ucb;         ///< forward callback
+    ErrorCallback ecb;                  ///< error callback
+    EventId flush;                      ///< event sending the generation
+  };
+  /// Generations of packets originated by this node, not sent yet
+  std::map<GenerationKey, CodingGeneration> m_generations;
+  /// Decoders of generations addressed to this node
+  std::map<uint32_t, RlncDecoder> m_decoders;
+  /// Decoders in the order they were created, with the time after which
+  /// no packet of their generation is left in any queue
+  std::deque<std::pair<Time, uint32_t> > m_decoderExpiry;
+  /// Generations already decoded, to ignore their late packets
+  std::set<uint32_t> m_decodedGenerations;
+  /// Decoded generations in the order they were decoded, with the time
+  /// after which no packet of theirs is left in any queue
+  std::deque<std::pair<Time, uint32_t> > m_decodedExpiry;
+  /// uniform random variable for the coding coefficients
+  Ptr<UniformRandomVariable> m_codingCoefficients;
+  /// How copies of a packet are handed to peers
+  ForwardingMode m_forwardingMode;
+  /// Copy budget of packets originated in Spray-and-Wait mode
+  uint32_t m_sprayCopies;
+  /// PRoPHET predictability gained per encounter
+  double m_prophetInit;
+  /// PRoPHET scaling of transitive predictabilities
+  double m_prophetBeta;
+  /// PRoPHET decay per time unit
+  double m_prophetGamma;
+  /// PRoPHET aging time unit
+  Time m_prophetTimeUnit;
+  /// PRoPHET delivery predictabilities
+  PredictabilityTable m_prophet;
+  /// Hops below which MaxProp orders packets by hop count
+  uint32_t m_maxPropHopThreshold;
+  /// MaxProp encounter probabilities and path costs
+  EncounterTable m_maxprop;
+  /// Forward packets along paths inside the connected component
+  bool m_hybrid;
+  /// Time after which link-state neighbors and entries are stale
+  Time m_linkStateTimeout;
+  /// Link-state view of the connected component in hybrid mode
+  LinkStateTable m_linkState;
+  /// Sequence numbers in the delivered window of each source
+  uint32_t m_deliveredWindowSize;
+  /// Packets delivered to this node when DeliveredWindow is set
+  DeliveredWindow m_delivered;
+  /// Send the epidemic headers of originated packets in compact format
+  bool m_compactHeader;
+  /// Largest number of IDs accepted in a received summary vector
+  uint32_t m_maxSummaryVectorSize;
+  /// Trace of packets added to the queue
+  PacketQueue::PacketTrace m_enqueueTrace;
+  /// Trace of packets received while already queued
+  PacketQueue::PacketTrace m_duplicateTrace;
+  /// Trace of packets dropped from the queue
+  PacketQueue::DropTrace m_dropTrace;
+  /// Trace of packets sent to a peer
+  TracedCallback<Ptr<const Packet>, uint32_t, Ipv4Address> m_forwardTrace;
+  /// Trace of packets delivered to this node
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &> m_localDeliverTrace;
+  /// Trace of beacons sent
+  TracedCallback<Ptr<const Packet>, Ipv4Address> m_beaconTxTrace;
+  /// Trace of beacons received
+  TracedCallback<Ptr<const Packet>, Ipv4Address> m_beaconRxTrace;
+  /// Trace of sessions started by this node
+  TracedCallback<Ipv4Address> m_sessionStartTrace;
+  /// Trace of sessions started by this node that ended
+  TracedCallback<Ipv4Address, bool> m_sessionEndTrace;
+  /// anti-entropy sessions started by this node and per-peer state
+  SessionManager m_sessions;
+  /// uniform random variable for the session start delay
+  Ptr<UniformRandomVariable> m_sessionJitter;
 
 
 
@@ -155,23 +394,339 @@ private:
    */
   void RecvEpidemic (Ptr<Socket> socket);
   /**
-   * \brief Sends disjoint packets given a vector containing
-   *   the other nodes Packet IDs and its IP address
-   * \param packet_SMV vector containing the other nodes Packet IDs
+   * \brief Captures incoming link-layer beacons.
+   * \param device the device the frame was received on.
+   * \param packet the received frame.
+   * \param protocol the protocol number of the frame.
+   * \param from the link-layer source address.
+   * \param to the link-layer destination address.
+   * \param packetType the type of the frame.
+   */
+  void RecvLinkLayerBeacon (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                            uint16_t protocol, const Address &from,
+                            const Address &to,
+                            NetDevice::PacketType packetType);
+  /**
+   * \brief Captures all frames heard by the node for passive discovery.
+   * \param device the device the frame was received on.
+   * \param packet the received frame.
+   * \param protocol the protocol number of the frame.
+   * \param from the link-layer source address.
+   * \param to the link-layer destination address.
+   * \param packetType the type of the frame.
+   */
+  void RecvPromiscuous (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                        uint16_t protocol, const Address &from,
+                        const Address &to, NetDevice::PacketType packetType);
+  /**
+   * \brief Store an overheard data packet as if it was received.
+   * \param packet the packet starting with its epidemic header.
+   * \param header the IP header of the packet.
+   */
+  void OverhearPacket (Ptr<const Packet> packet, const Ipv4Header &header);
+  /**
+   * \brief Add a data packet received from another node to the queue,
+   *  unless it is already queued, its hop count is exhausted or it has
+   *  expired.  The queued copy has its hop count decremented; a packet
+   *  already queued is not copied.
+   * \param p the packet starting with its epidemic header.
+   * \param header the IP header of the packet.
+   * \param ucb the callback used to forward the packet later.
+   * \param ecb the error callback of the packet.
+   * \returns the ID of the packet if it was added to the queue, 0 otherwise
+   */
+  uint32_t EnqueueRelayedPacket (Ptr<const Packet> p, const Ipv4Header &header,
+                                 UnicastForwardCallback ucb,
+                                 ErrorCallback ecb);
+  /**
+   * \brief Add a data packet addressed to this node to the queue, so that
+   *  later copies are recognized as duplicates.  The queue keeps \p p
+   *  itself, which must not be modified afterwards.
+   * \param p the packet starting with its epidemic header.
+   * \param eHeader the epidemic header of the packet.
+   * \param header the IP header of the packet.
+   * \param ucb the callback used to forward the packet later.
+   * \param ecb the error callback of the packet.
+   * \returns false if the packet was already delivered
+   */
+  bool StoreDeliveredPacket (Ptr<const Packet> p, const EpidemicHeader &eHeader,
+                             const Ipv4Header &header,
+                             UnicastForwardCallback ucb, ErrorCallback ecb);
+  /**
+   * \brief Split a packet originated by this node into chunks of
+   *  ChunkSize bytes and add them to the queue.
+   * \param packet the packet without epidemic header.
+   * \param header the IP header of the packet.
+   * \param ucb the callback used to forward the chunks.
+   * \param ecb the error callback of the chunks.
+   * \param bundleID the packet ID of the first chunk.
+   * \return false if the packet needs more than 65535 chunks or its
+   *  chunks would take the IDs of queued packets, in which case it is
+   *  dropped.
+   */
+  bool EnqueueChunks (Ptr<Packet> packet, const Ipv4Header &header,
+                      UnicastForwardCallback ucb, ErrorCallback ecb,
+                      uint32_t bundleID);
+  /**
+   * \brief Create the epidemic header of a packet originated by this
+   *  node now.  The packet ID is left to the caller.
+   * \returns the header with timestamp, hop count and copy budget set
+   */
+  EpidemicHeader CreateHeader () const;
+  /**
+   * \brief Remove the packets that Spray-and-Wait does not hand to
+   *  \p peer: packets with a single copy left that are not addressed to
+   *  the peer.
+   * \param peer the node the packets are sent to.
+   * \param packets the IDs of the packets to send, filtered in place.
+   */
+  void FilterSprayAndWait (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /**
+   * \brief Remove the packets that PRoPHET does not hand to \p peer:
+   *  packets not addressed to the peer whose destination the peer is not
+   *  more likely to reach than this node.
+   * \param peer the node the packets are sent to.
+   * \param packets the IDs of the packets to send, filtered in place.
+   */
+  void FilterProphet (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /**
+   * \brief Remove the packets addressed to \p peer that its delivered
+   *  windows mark as delivered.
+   * \param peer the node the packets are sent to.
+   * \param packets the IDs of the packets to send, filtered in place.
+   */
+  void FilterDelivered (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /**
+   * \brief MaxProp cost of a queued packet.  Packets that travelled fewer
+   *  than MaxPropHopThreshold hops are ranked by hop count and go before
+   *  all others, which are ranked by estimated path cost.
+   * \param entry the queued packet
+   * \returns the cost, lower is sent first and dropped last
+   */
+  double GetMaxPropCost (const QueueEntry &entry);
+  /**
+   * \brief Hand half of the copy budget of a queued packet to a peer.
+   *  The queued packet keeps the other half.  Packets without a copy
+   *  budget, or with a single copy, are returned unchanged.  Called by
+   *  the senders right before the packet leaves, so that a transfer
+   *  that never happens does not cost copies.
+   * \param entry the queued packet about to be sent.
+   * \returns the entry to send
+   */
+  QueueEntry SplitCopies (QueueEntry entry);
+  /**
+   * \brief Add a packet originated by this node to the open generation
+   *  of its destination.  The generation is sent once it holds
+   *  GenerationSize packets.
+   * \param packet the packet without epidemic header.
+   * \param header the IP header of the packet.
+   * \param ucb the callback used to forward the coded packets.
+   * \param ecb the error callback of the coded packets.
+   */
+  void AddToGeneration (Ptr<Packet> packet, const Ipv4Header &header,
+                        UnicastForwardCallback ucb, ErrorCallback ecb);
+  /**
+   * \brief Code an open generation and add the coded packets to the
+   *  queue.
+   * \param key the destination and protocol of the generation.
+   */
+  void FlushGeneration (GenerationKey key);
+  /**
+   * \brief Deliver a data packet addressed to this node without its
+   *  epidemic header.  A chunk is delivered as its reassembled bundle
+   *  once all chunks are stored, and a coded packet as the packets of
+   *  its generation once the generation is decoded.
+   * \param packet the packet starting with its epidemic header.
+   * \param eHeader the epidemic header of the packet, already parsed.
+   * \param header the IP header of the packet.
+   * \param lcb the local delivery callback.
+   * \param iif the input interface.
+   */
+  void DeliverLocally (Ptr<Packet> packet, const EpidemicHeader &eHeader,
+                       const Ipv4Header &header,
+                       LocalDeliverCallback lcb, int32_t iif);
+  /**
+   * \brief Add a coded packet to the decoder of its generation and
+   *  deliver the generation once it is decoded.  Decoded generations are
+   *  remembered until their packets expire.
+   * \param packet the packet starting with its coding header.
+   * \param header the IP header of the packet.
+   * \param lcb the local delivery callback.
+   * \param iif the input interface.
+   */
+  void DecodePacket (Ptr<Packet> packet, const Ipv4Header &header,
+                     LocalDeliverCallback lcb, int32_t iif);
+  /**
+   * \brief Send queued packets to \p dst packed into AGGREGATE messages
+   *  of at most AggregationSize bytes.
+   * \param dst the destination IP address.
+   * \param packets the IDs of the packets to send.
+   */
+  void SendAggregatedPackets (Ipv4Address dst,
+                              const std::vector<uint32_t> &packets);
+  /**
+   * \brief Add the type header to an AGGREGATE message, send it and
+   *  trace the bundles it carries as forwarded.
+   * \param aggregate the concatenated bundles.
+   * \param bundles the bundles and their packet IDs.
+   * \param dst the destination IP address.
+   */
+  void SendAggregate (
+    Ptr<Packet> aggregate,
+    const std::vector<std::pair<Ptr<const Packet>, uint32_t> > &bundles,
+    Ipv4Address dst);
+  /**
+   * \brief Unpack an AGGREGATE message into the queue and deliver the
+   *  packets addressed to this node.
+   * \param packet the message after its type header.
+   */
+  void RecvAggregate (Ptr<Packet> packet);
+  /**
+   * \brief Start an anti-entropy session on a beacon if this node
+   *  has the smaller address and the host was not contacted recently.
+   * \param sender the address of the beacon sender.
+   */
+  void HandleBeacon (Ipv4Address sender);
+  /**
+   * \brief Send a queued packet to the next hop of a path to its
+   *  destination if hybrid mode is on and the destination is in the
+   *  connected component.
+   * \param packetID the ID of the queued packet.
+   */
+  void ForwardInCluster (uint32_t packetID);
+  /**
+   * \brief Append a queued packet to the transfer list of \p peer and
+   *  schedule the event draining the list if none is pending.  A packet
+   *  already in the list is not appended again.
+   * \param peer the address of the peer.
+   * \param packetID the ID of the queued packet.
+   */
+  void QueueTransfer (Ipv4Address peer, uint32_t packetID);
+  /**
+   * \brief Send the packets of the transfer list of \p peer still in
+   *  the queue.
+   * \param peer the address of the peer.
+   */
+  void DrainTransfer (Ipv4Address peer);
+  /**
+   * \brief Request an anti-entropy session with a peer.
+   *  The session is started after a random backoff if a session slot is
+   *  free, otherwise the peer waits for one.
+   * \param peer the peer address.
+   */
+  void RequestSession (Ipv4Address peer);
+  /**
+   * \brief Start a granted session after the random backoff.
+   * \param peer the peer address.
+   */
+  void ScheduleSessionStart (Ipv4Address peer);
+  /**
+   * \brief Send the first summary vector of a session.
+   * \param peer the peer address.
+   */
+  void StartSession (Ipv4Address peer);
+  /**
+   * \brief Retransmit the summary vector of a session that got no
+   *  REPLY_BACK in time, or end it once the retransmissions are used up.
+   * \param peer the peer address.
+   */
+  void SessionTimeout (Ipv4Address peer);
+  /// Start or answer the sessions waiting for a free slot
+  void GrantPendingSessions ();
+  /**
+   * \brief Answer the REPLY of a peer once a session slot is free.
+   * \param peer the peer address.
+   */
+  void RequestAnswer (Ipv4Address peer);
+  /**
+   * \brief Send the packets missing at a peer and the REPLY_BACK of a
+   *  granted session.
+   * \param peer the peer address.
+   */
+  void AnswerSession (Ipv4Address peer);
+  /**
+   * \brief End an answered session once the peer had time to receive
+   *  the REPLY_BACK.
+   * \param peer the peer address.
+   */
+  void EndAnswer (Ipv4Address peer);
+  /**
+   * \brief Check if the last contact with a peer was cut short, i.e.
+   *  its session timed out.  A resumed session itself is not resumed
+   *  again.
+   * \param peer the peer address.
+   * \returns true if an early session may resume the transfer
+   */
+  bool IsContactCutShort (Ipv4Address peer);
+  /**
+   * \brief Add the options of this node to a summary vector message,
+   *  before its SummaryVectorHeader is added.
+   * \param packet the summary vector message.
+   */
+  void AddSummaryVectorOptions (Ptr<Packet> packet);
+  /**
+   * \brief Read the options following a summary vector into the state of
+   *  its sender.  Unknown options are skipped.
+   * \param packet the remainder of the message after the summary vector.
+   * \param sender the address of the sender.
+   */
+  void ReadSummaryVectorOptions (Ptr<Packet> packet, Ipv4Address sender);
+  /**
+   * \brief Cut an ordered transfer list to what fits into the remaining
+   *  contact time with the peer.
+   * \param peer the peer address.
+   * \param packets IDs of the packets to send, truncated.
+   */
+  void ApplyContactBudget (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /**
+   * \brief Sends the queued packets missing in the summary vector of
+   *   a peer
+   * \param packets IDs of the queued packets missing in the peer
    * \param dest destination address
+   * \param retransmission true if the summary vector of \p dest is a
+   *   retransmission of one already answered, only packets not sent to
+   *   \p dest before are sent
    */
   void SendDisjointPackets (
-    SummaryVectorHeader packet_SMV, Ipv4Address dest);
+    std::vector<uint32_t> packets, Ipv4Address dest,
+    bool retransmission = false);
   /// Function to send beacons periodically
   void SendBeacons ();
+  /// Schedule the next beacon after the interval plus a random jitter
+  void ScheduleNextBeacon ();
+  /// Broadcast a beacon as a link-layer frame on every epidemic interface
+  void SendLinkLayerBeacons ();
   /**
-   * \brief Finding output device for a given IP address.
+   * \brief Link-state bytes that fit one beacon on every interface.
+   * \param overhead the bytes of the beacon besides its link-state view.
+   * \returns the smallest interface MTU minus the overhead.
+   */
+  uint32_t GetLinkStateBudget (uint32_t overhead) const;
+  /**
+   * \brief Finding output device for a given IP address.  The device
+   *  subnets are scanned in device order, the first match wins.
    * \param dst the given IP address.
    * \returns the output device ID.
    */
   uint32_t FindOutputDeviceForAddress ( Ipv4Address  dst);
   /// \returns the loopback device for current node
   uint32_t FindLoopbackDevice ();
+  /**
+   * \brief Rebuild the device subnets, the loopback device and the local
+   *  addresses after an interface or address change, so that per-packet
+   *  lookups do not walk the devices of the node.
+   */
+  void UpdateInterfaceTables ();
+  /**
+   * \brief Get the route used to forward queued packets to a neighbor.
+   *  Routes are cached, so that a session reuses one route for all the
+   *  packets it sends.  A route not used for HostRecentPeriod belongs
+   *  to a neighbor that is gone, it is rebuilt on the next contact and
+   *  evicted when another route is added.
+   * \param neighbor the neighbor address.
+   * \returns the route through the interface of the main address
+   */
+  Ptr<Ipv4Route> GetNeighborRoute (Ipv4Address neighbor);
   /**
    * \brief Sending a packet to a given IP address.
    * \param p the packet to be sent.
@@ -180,6 +735,7 @@ private:
   void SendPacket (Ptr<Packet> p,InetSocketAddress addr);
   /**
    * \brief Check i a given IP address is associated with the current node.
+   *  The set of local addresses is searched in logarithmic time.
    * \param src the IP address to be checked.
    * \returns true if an address belongs to the current node
    */
@@ -195,8 +751,10 @@ private:
    * \param firstNode check the anti-entropy session in the Epidemic paper
    *    \c true send a summary vector with reply header
    *    \c false send a summary vector with reply back header
+   * \param retransmission true if the REPLY of a session is sent again
    */
-  void SendSummaryVector (Ipv4Address dest,bool firstNode);
+  void SendSummaryVector (Ipv4Address dest,bool firstNode,
+                          bool retransmission = false);
   /**
    * \brief Finding the corresponding socket for the given interface.
    * \returns socket for the given interface
@@ -209,6 +767,14 @@ private:
    * \param queueEntry the queue entry containing the packet.
    */
   void SendPacketFromQueue (Ipv4Address dst,QueueEntry queueEntry);
+  /**
+   * \brief Copy a queued packet to send it.
+   *  A compact epidemic header is written again, since it carries the
+   *  age of the packet.
+   * \param entry the queue entry containing the packet.
+   * \return the copy to send.
+   */
+  Ptr<Packet> CopyForSending (const QueueEntry &entry) const;
   /// \returns true if \p hostID has been contacted recently
   /**
    * \brief Check if a given node has been contacted recently .
@@ -0,0 +1,343 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+#include "epidemic-session-manager.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::Session and ns3::Epidemic::SessionManager implementations.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EpidemicSessionManager");
+
+namespace Epidemic {
+
+Session::Session ()
+  : state (STARTING),
+    requested (Seconds (0)),
+    started (Seconds (0)),
+    retries (0)
+{
+}
+
+PeerState::PeerState ()
+  : confirmed (0),
+    timedOut (false),
+    resumed (false),
+    retransmitted (false),
+    hasContact (false),
+    answerPending (false)
+{
+}
+
+
+SessionManager::SessionManager (uint32_t maxSessions)
+  : m_maxSessions (maxSessions),
+    m_totalWait (Seconds (0)),
+    m_maxWait (Seconds (0)),
+    m_started (0),
+    m_failed (0),
+    m_recovered (0)
+{
+  NS_LOG_FUNCTION (this << maxSessions);
+}
+
+uint32_t
+SessionManager::GetMaxSessions () const
+{
+  return m_maxSessions;
+}
+
+void
+SessionManager::SetMaxSessions (uint32_t maxSessions)
+{
+  NS_LOG_FUNCTION (this << maxSessions);
+  m_maxSessions = maxSessions;
+}
+
+bool
+SessionManager::HasFreeSlot () const
+{
+  return m_maxSessions == 0 || m_active.size () < m_maxSessions;
+}
+
+bool
+SessionManager::IsPending (Ipv4Address peer) const
+{
+  for (std::deque<PendingPeer>::const_iterator i = m_pending.begin ();
+       i != m_pending.end (); ++i)
+    {
+      if (i->first == peer)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+SessionManager::Request (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  if (m_active.find (peer) != m_active.end () || IsPending (peer))
+    {
+      return false;
+    }
+  if (m_pending.empty () && HasFreeSlot ())
+    {
+      Session session;
+      session.requested = Simulator::Now ();
+      m_active[peer] = session;
+      return true;
+    }
+  NS_LOG_LOGIC ("Session with " << peer << " is queued behind "
+                                << m_pending.size () << " peers");
+  m_pending.push_back (std::make_pair (peer, Simulator::Now ()));
+  return false;
+}
+
+bool
+SessionManager::GrantPending (Ipv4Address &peer)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_pending.empty () || !HasFreeSlot ())
+    {
+      return false;
+    }
+  PendingPeer next = m_pending.front ();
+  m_pending.pop_front ();
+  Session session;
+  session.requested = next.second;
+  m_active[next.first] = session;
+  peer = next.first;
+  return true;
+}
+
+void
+SessionManager::MarkStarted (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  Begin (peer, Session::WAIT_REPLY_BACK);
+}
+
+void
+SessionManager::MarkAnswered (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  Begin (peer, Session::ANSWERED);
+}
+
+void
+SessionManager::Begin (Ipv4Address peer, Session::State state)
+{
+  SessionMap::iterator session = m_active.find (peer);
+  if (session == m_active.end ())
+    {
+      return;
+    }
+  session->second.state = state;
+  session->second.started = Simulator::Now ();
+  Time wait = session->second.started - session->second.requested;
+  m_totalWait += wait;
+  m_maxWait = Max (m_maxWait, wait);
+  m_started++;
+}
+
+bool
+SessionManager::End (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  SessionMap::iterator session = m_active.find (peer);
+  if (session == m_active.end ())
+    {
+      return false;
+    }
+  session->second.timeout.Cancel ();
+  m_active.erase (session);
+  return true;
+}
+
+bool
+SessionManager::Complete (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  SessionMap::iterator session = m_active.find (peer);
+  if (session == m_active.end ()
+      || session->second.state != Session::WAIT_REPLY_BACK)
+    {
+      return false;
+    }
+  if (session->second.retries > 0)
+    {
+      m_recovered++;
+    }
+  return End (peer);
+}
+
+bool
+SessionManager::Fail (Ipv4Address peer)
+{
+  NS_LOG_FUNCTION (this << peer);
+  if (!End (peer))
+    {
+      return false;
+    }
+  m_failed++;
+  return true;
+}
+
+Session *
+SessionManager::Find (Ipv4Address peer)
+{
+  SessionMap::iterator session = m_active.find (peer);
+  if (session == m_active.end ())
+    {
+      return 0;
+    }
+  return &session->second;
+}
+
+PeerState &
+SessionManager::GetPeerState (Ipv4Address peer)
+{
+  return m_peers[peer];
+}
+
+void
+SessionManager::Offer (Ipv4Address peer, std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  PeerState &state = m_peers[peer];
+  std::vector<uint32_t> resumed;
+  std::vector<uint32_t> fresh;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      if (state.offered.erase (*i))
+        {
+          resumed.push_back (*i);
+        }
+      else
+        {
+          fresh.push_back (*i);
+        }
+    }
+  // What is left of the previous offer is no longer missing at the peer
+  state.confirmed += state.offered.size ();
+  NS_LOG_LOGIC ("Peer " << peer << " confirmed " << state.offered.size ()
+                        << " packets, resuming " << resumed.size ());
+  state.offered.clear ();
+  state.offered.insert (packets.begin (), packets.end ());
+  packets.swap (resumed);
+  packets.insert (packets.end (), fresh.begin (), fresh.end ());
+}
+
+void
+SessionManager::OfferRemaining (Ipv4Address peer,
+                                std::vector<uint32_t> &packets)
+{
+  NS_LOG_FUNCTION (this << peer << packets.size ());
+  PeerState &state = m_peers[peer];
+  std::vector<uint32_t> remaining;
+  for (std::vector<uint32_t>::const_iterator i = packets.begin ();
+       i != packets.end (); ++i)
+    {
+      if (state.offered.insert (*i).second)
+        {
+          remaining.push_back (*i);
+        }
+    }
+  packets.swap (remaining);
+}
+
+void
+SessionManager::Clear ()
+{
+  NS_LOG_FUNCTION (this);
+  for (SessionMap::iterator i = m_active.begin (); i != m_active.end (); ++i)
+    {
+      i->second.timeout.Cancel ();
+    }
+  m_active.clear ();
+  m_pending.clear ();
+  for (std::map<Ipv4Address, PeerState>::iterator i = m_peers.begin ();
+       i != m_peers.end (); ++i)
+    {
+      i->second.drain.Cancel ();
+    }
+  m_peers.clear ();
+}
+
+uint32_t
+SessionManager::GetActiveCount () const
+{
+  return m_active.size ();
+}
+
+uint32_t
+SessionManager::GetPendingCount () const
+{
+  return m_pending.size ();
+}
+
+Time
+SessionManager::GetMeanWaitTime () const
+{
+  if (m_started == 0)
+    {
+      return Seconds (0);
+    }
+  return m_totalWait / m_started;
+}
+
+Time
+SessionManager::GetMaxWaitTime () const
+{
+  return m_maxWait;
+}
+
+uint64_t
+SessionManager::GetFailedCount () const
+{
+  return m_failed;
+}
+
+uint64_t
+SessionManager::GetRecoveredCount () const
+{
+  return m_recovered;
+}
+
+} //end namespace epidemic
+} //end namespace ns3
@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2013 Mohammed J.F. Alenazi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mohammed J.F. Alenazi  <malenazi@ittc.ku.edu>
+ *
+ * James P.G. Sterbenz <jpgs@ittc.ku.edu>, director
+ * ResiliNets Research Group  http://wiki.ittc.ku.edu/resilinets
+ * Information and Telecommunication Technology Center (ITTC)
+ * and Department of Electrical Engineering and Computer Science
+ * The University of Kansas Lawrence, KS USA.
+ *
+ * Work supported by King Saud University and
+ * the ITTC at The University of Kansas.
+ */
+
+#ifndef EPIDEMIC_SESSION_MANAGER_H
+#define EPIDEMIC_SESSION_MANAGER_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "epidemic-delivered-window.h"
+
+/**
+ * \file
+ * \ingroup epidemic
+ * ns3::Epidemic::Session and ns3::Epidemic::SessionManager declarations.
+ */
+
+namespace ns3 {
+namespace Epidemic {
+
+/**
+ * \ingroup epidemic
+ * \brief State of one anti-entropy session with a peer
+ */
+struct Session
+{
+  /// Session states
+  enum State
+  {
+    STARTING = 0,     //!< granted, waiting for the start backoff
+    WAIT_REPLY_BACK,  //!< summary vector sent, waiting for the peer's one
+    ANSWERED,         //!< peer's summary vector answered, waiting for its packets
+  };
+  Session ();
+  /// Current state
+  State state;
+  /// Time the session was requested
+  Time requested;
+  /// Time the first summary vector was sent, zero until then
+  Time started;
+  /// Number of times the summary vector was retransmitted
+  uint32_t retries;
+  /// Event retransmitting or ending the session if the peer does not answer
+  EventId timeout;
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Transfer state kept per peer across sessions
+ */
+struct PeerState
+{
+  PeerState ();
+  /// Packets sent to the peer and not yet seen in its summary vector
+  std::set<uint32_t> offered;
+  /// Number of offered packets later confirmed by the peer
+  uint32_t confirmed;
+  /// true if the last session ended without the peer's summary vector
+  bool timedOut;
+  /// true if the last session was an early resumption
+  bool resumed;
+  /// true if the last summary vector of the peer was a retransmission
+  bool retransmitted;
+  /// true if the last summary vector of the peer carried a ContactHeader
+  bool hasContact;
+  /// Position of the peer from its last ContactHeader
+  Vector position;
+  /// Velocity of the peer from its last ContactHeader
+  Vector velocity;
+  /// Packets delivered to the peer, from its last DeliveredHeader
+  DeliveredWindow delivered;
+  /// true if a summary vector of the peer waits for a session to answer it
+  bool answerPending;
+  /// Packets the peer is missing, from the summary vector to answer
+  std::vector<uint32_t> missing;
+  /// Packets waiting to be sent to the peer
+  std::deque<uint32_t> transfer;
+  /// IDs of the packets in the transfer list
+  std::set<uint32_t> pending;
+  /// Event sending the packets of the transfer list
+  EventId drain;
+};
+
+/**
+ * \ingroup epidemic
+ * \brief Anti-entropy session manager
+ *
+ *  Limits the number of anti-entropy sessions a node runs at the same
+ *  time, both those it starts and those it answers.  Sessions requested
+ *  while the limit is reached wait in a FIFO and are granted in order as
+ *  running sessions end.  The manager only
+ *  keeps the bookkeeping; scheduling is left to the RoutingProtocol.
+ */
+class SessionManager
+{
+public:
+  /**
+   * \brief Constructor for SessionManager
+   * \param maxSessions maximum number of concurrent sessions, 0 means
+   *  no limit
+   */
+  SessionManager (uint32_t maxSessions = 0);
+  /// \returns the maximum number of concurrent sessions
+  uint32_t GetMaxSessions () const;
+  /**
+   * \brief Set the maximum number of concurrent sessions.
+   * \param maxSessions the limit, 0 means no limit
+   */
+  void SetMaxSessions (uint32_t maxSessions);
+  /**
+   * \brief Request a session with a peer.
+   *  If a slot is free, the session becomes active at once.  Otherwise
+   *  the peer is appended to the pending FIFO.  Peers that are already
+   *  active or pending are ignored.
+   * \param peer the peer address
+   * \returns true if the session is active and can be started now
+   */
+  bool Request (Ipv4Address peer);
+  /**
+   * \brief Grant the next pending session if a slot is free.
+   * \param peer set to the granted peer
+   * \returns true if a pending session became active
+   */
+  bool GrantPending (Ipv4Address &peer);
+  /**
+   * \brief Record that the first message of a session was sent.
+   * \param peer the peer address
+   */
+  void MarkStarted (Ipv4Address peer);
+  /**
+   * \brief Record that the summary vector of a session started by the
+   *  peer was answered.
+   * \param peer the peer address
+   */
+  void MarkAnswered (Ipv4Address peer);
+  /**
+   * \brief End an active session and cancel its timeout.
+   * \param peer the peer address
+   * \returns true if an active session was ended
+   */
+  bool End (Ipv4Address peer);
+  /**
+   * \brief End a session after the peer's summary vector arrived.
+   *  The session counts as recovered if it needed retransmissions.
+   * \param peer the peer address
+   * \returns true if an active session was ended
+   */
+  bool Complete (Ipv4Address peer);
+  /**
+   * \brief End a session whose peer did not answer.
+   * \param peer the peer address
+   * \returns true if an active session was ended
+   */
+  bool Fail (Ipv4Address peer);
+  /**
+   * \brief Find an active session.
+   * \param peer the peer address
+   * \returns the session, or 0 if none is active
+   */
+  Session * Find (Ipv4Address peer);
+  /**
+   * \brief Get the transfer state of a peer, created on first use.
+   * \param peer the peer address
+   * \returns the peer state
+   */
+  PeerState & GetPeerState (Ipv4Address peer);
+  /**
+   * \brief Record the packets about to be sent to a peer.
+   *  Packets offered before and no longer requested by the peer count as
+   *  confirmed.  Packets offered before and still requested are moved to
+   *  the front of \p packets, so an interrupted transfer resumes where it
+   *  stopped.
+   * \param peer the peer address
+   * \param packets the IDs of the packets the peer is missing, reordered
+   */
+  void Offer (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /**
+   * \brief Record the packets about to be sent again in the same session.
+   *  Packets already offered in this session are removed from
+   *  \p packets, the others are added to the offer.
+   * \param peer the peer address
+   * \param packets the IDs of the packets the peer is missing, filtered
+   */
+  void OfferRemaining (Ipv4Address peer, std::vector<uint32_t> &packets);
+  /// End all sessions, drop the pending peers and the peer states
+  void Clear ();
+  /// \returns the number of active sessions
+  uint32_t GetActiveCount () const;
+  /// \returns the number of peers waiting for a session
+  uint32_t GetPendingCount () const;
+  /// \returns the mean time from request to start of started sessions
+  Time GetMeanWaitTime () const;
+  /// \returns the longest time from request to start of started sessions
+  Time GetMaxWaitTime () const;
+  /// \returns the number of sessions ended without the peer's answer
+  uint64_t GetFailedCount () const;
+  /// \returns the number of sessions completed after a retransmission
+  uint64_t GetRecoveredCount () const;
+
+private:
+  /// Type to connect a peer address to its active session
+  typedef std::map<Ipv4Address, Session> SessionMap;
+  /// Pair of a waiting peer and its request time
+  typedef std::pair<Ipv4Address, Time> PendingPeer;
+  /// true if the limit allows another active session
+  bool HasFreeSlot () const;
+  /// true if \p peer waits in the pending FIFO
+  bool IsPending (Ipv4Address peer) const;
+  /**
+   * \brief Move an active session out of STARTING.
+   * \param peer the peer address
+   * \param state the new state of the session
+   */
+  void Begin (Ipv4Address peer, Session::State state);
+
+  /// Maximum number of concurrent sessions, 0 means no limit
+  uint32_t m_maxSessions;
+  /// Active sessions
+  SessionMap m_active;
+  /// Transfer state of every peer met so far
+  std::map<Ipv4Address, PeerState> m_peers;
+  /// Peers waiting for a free slot, in request order
+  std::deque<PendingPeer> m_pending;
+  /// Sum of the waiting times of started sessions
+  Time m_totalWait;
+  /// Longest waiting time of a started session
+  Time m_maxWait;
+  /// Number of started sessions
+  uint64_t m_started;
+  /// Number of failed sessions
+  uint64_t m_failed;
+  /// Number of sessions completed after a retransmission
+  uint64_t m_recovered;
+};
+
+} //end namespace epidemic
+} //end namespace ns3
+#endif
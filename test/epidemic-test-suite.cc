@@ -28,7 +28,19 @@
  */
 
 #include "ns3/epidemic-routing-protocol.h"
+#include "ns3/epidemic-beacon-scheduler.h"
+#include "ns3/epidemic-session-manager.h"
+#include "ns3/epidemic-gf256.h"
+#include "ns3/epidemic-network-coding.h"
+#include "ns3/epidemic-prophet.h"
+#include "ns3/epidemic-maxprop.h"
+#include "ns3/epidemic-link-state.h"
+#include "ns3/epidemic-delivered-window.h"
+#include "ns3/epidemic-id-set.h"
 #include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
 #include "ns3/ptr.h"
 #include "ns3/boolean.h"
 #include "ns3/test.h"
@@ -38,6 +50,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-address-generator.h"
 #include "ns3/network-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/mobility-module.h"
@@ -51,6 +64,48 @@
 using namespace ns3;
 using namespace Epidemic;
 
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc (std::size_t size);
+
+/// Whether malloc counts its calls, see AllocationCount
+static bool g_countAllocations = false;
+/// Number of calls to malloc while g_countAllocations is set
+static uint64_t g_allocations = 0;
+
+/*
+ * The malloc behind operator new in the test binary.  It only counts
+ * while an AllocationCount is in scope, the other tests are unaffected.
+ */
+extern "C" void *
+malloc (std::size_t size) __THROW
+{
+  if (g_countAllocations)
+    {
+      g_allocations++;
+    }
+  return __libc_malloc (size);
+}
+
+/// Count the heap allocations made while in scope
+struct AllocationCount
+{
+  AllocationCount () : m_start (g_allocations)
+  {
+    g_countAllocations = true;
+  }
+  ~AllocationCount ()
+  {
+    g_countAllocations = false;
+  }
+  /// \returns the allocations counted so far
+  uint64_t Get () const
+  {
+    return g_allocations - m_start;
+  }
+  /// Value of g_allocations when counting started
+  uint64_t m_start;
+};
+#endif
 
 class EpidemicHeaderTestCase : public TestCase
 {
@@ -97,11 +152,205 @@ EpidemicHeaderTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (header2.GetHopCount (),10,
                          "Checking hop count");
 
+  ContactHeader contact1 (Vector (12.5, -3.25, 0), Vector (-1.5, 2, 0));
+  packet->AddHeader (contact1);
+  OptionHeader option1 (OptionHeader::CONTACT, contact1.GetSerializedSize ());
+  packet->AddHeader (option1);
+  OptionHeader option2;
+  packet->RemoveHeader (option2);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) option2.GetOptionType (),
+                         (uint32_t) OptionHeader::CONTACT,
+                         "Checking option type");
+  NS_TEST_ASSERT_MSG_EQ (option2.GetLength (),24, "Checking option length");
+  ContactHeader contact2;
+  packet->RemoveHeader (contact2);
+  NS_TEST_ASSERT_MSG_EQ_TOL (contact2.GetPosition ().x, 12.5, 0.01,
+                             "Checking contact position");
+  NS_TEST_ASSERT_MSG_EQ_TOL (contact2.GetPosition ().y, -3.25, 0.01,
+                             "Checking contact position");
+  NS_TEST_ASSERT_MSG_EQ_TOL (contact2.GetVelocity ().x, -1.5, 0.01,
+                             "Checking contact velocity");
+
+  PredictabilityList entries1;
+  entries1.push_back (std::make_pair (Ipv4Address ("10.1.1.3"), 0.5));
+  entries1.push_back (std::make_pair (Ipv4Address ("10.1.1.4"), 1.0));
+  PredictabilityHeader predictability1 (entries1);
+  packet->AddHeader (predictability1);
+  PredictabilityHeader predictability2;
+  packet->RemoveHeader (predictability2);
+  NS_TEST_ASSERT_MSG_EQ (predictability2.GetSerializedSize (),12,
+                         "Checking predictability header size");
+  NS_TEST_ASSERT_MSG_EQ (predictability2.GetEntries ().size (),2,
+                         "Checking predictability count");
+  NS_TEST_ASSERT_MSG_EQ (predictability2.GetEntries ()[0].first,
+                         Ipv4Address ("10.1.1.3"),
+                         "Checking predictability destination");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictability2.GetEntries ()[0].second, 0.5,
+                             1 / 255.0, "Checking quantized predictability");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictability2.GetEntries ()[1].second, 1.0,
+                             1e-9, "Checking quantized predictability");
+
+  LinkStateList linkEntries1 (2);
+  linkEntries1[0].origin = Ipv4Address ("10.1.1.2");
+  linkEntries1[0].sequence = 7;
+  linkEntries1[0].neighbors.push_back (Ipv4Address ("10.1.1.1"));
+  linkEntries1[0].neighbors.push_back (Ipv4Address ("10.1.1.3"));
+  linkEntries1[1].origin = Ipv4Address ("10.1.1.3");
+  linkEntries1[1].sequence = 0xFFFF;
+  LinkStateHeader linkState1 (linkEntries1);
+  packet->AddHeader (linkState1);
+  LinkStateHeader linkState2;
+  packet->RemoveHeader (linkState2);
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetSerializedSize (),24,
+                         "Checking link-state header size");
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetEntries ().size (),2,
+                         "Checking link-state entry count");
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetEntries ()[0].sequence,7,
+                         "Checking link-state sequence number");
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetEntries ()[0].neighbors[1],
+                         Ipv4Address ("10.1.1.3"),
+                         "Checking link-state neighbor");
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetEntries ()[1].sequence,0xFFFF,
+                         "Checking the last link-state sequence number");
+  NS_TEST_ASSERT_MSG_EQ (linkState2.GetEntries ()[1].neighbors.size (),0,
+                         "Checking an empty neighbor list");
+
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.1.1.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.1.1.9"));
+  ipHeader.SetProtocol (17);
+  ipHeader.SetTtl (63);
+  BundleHeader bundle1 (ipHeader, 1200);
+  packet->AddHeader (bundle1);
+  TypeHeader type1 (TypeHeader::AGGREGATE);
+  packet->AddHeader (type1);
+  TypeHeader type2;
+  packet->RemoveHeader (type2);
+  NS_TEST_ASSERT_MSG_EQ (type2.IsValid (), true, "Checking aggregate type");
+  NS_TEST_ASSERT_MSG_EQ (type2.GetMessageType (), TypeHeader::AGGREGATE,
+                         "Checking aggregate type");
+  BundleHeader bundle2;
+  packet->RemoveHeader (bundle2);
+  NS_TEST_ASSERT_MSG_EQ (bundle2.GetSerializedSize (),12,
+                         "Checking bundle header size");
+  NS_TEST_ASSERT_MSG_EQ (bundle2.GetLength (),1200, "Checking bundle length");
+  Ipv4Header ipHeader2 = bundle2.GetIpv4Header ();
+  NS_TEST_ASSERT_MSG_EQ (ipHeader2.GetSource (),Ipv4Address ("10.1.1.1"),
+                         "Checking bundle source");
+  NS_TEST_ASSERT_MSG_EQ (ipHeader2.GetDestination (),Ipv4Address ("10.1.1.9"),
+                         "Checking bundle destination");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) ipHeader2.GetProtocol (),17,
+                         "Checking bundle protocol");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) ipHeader2.GetTtl (),63,
+                         "Checking bundle TTL");
+
+}
+
+/// Unit test for the compact EpidemicHeader and TypeHeader formats
+struct EpidemicCompactHeaderTest : public TestCase
+{
+  EpidemicCompactHeaderTest () : TestCase ("EpidemicCompactHeader")
+  {
+  }
+  virtual void DoRun ();
+  /// Write and read headers at a time past their timestamp
+  void CheckHeaders ();
+};
+
+void
+EpidemicCompactHeaderTest::DoRun ()
+{
+  Simulator::Schedule (Seconds (5),
+                       &EpidemicCompactHeaderTest::CheckHeaders, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
 }
 
+void
+EpidemicCompactHeaderTest::CheckHeaders ()
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  // A legacy header from a host whose third address byte is 255
+  EpidemicHeader legacy1;
+  legacy1.SetPacketID (0xFF01002A);
+  legacy1.SetHopCount (30);
+  legacy1.SetTimeStamp (Seconds (1));
+  packet->AddHeader (legacy1);
+  EpidemicHeader compact1;
+  compact1.SetVersion (EpidemicHeader::COMPACT);
+  compact1.SetPacketID (0x0101002A);
+  compact1.SetHopCount (30);
+  compact1.SetTimeStamp (Seconds (2) + MicroSeconds (700));
+  packet->AddHeader (compact1);
+  EpidemicHeader compact2;
+  packet->RemoveHeader (compact2);
+  NS_TEST_ASSERT_MSG_EQ (compact2.IsValid (), true,
+                         "Checking a compact header");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetSerializedSize (), 8,
+                         "Checking compact header size");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetVersion (), EpidemicHeader::COMPACT,
+                         "Checking compact header version");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetPacketID (), 0x0101002A,
+                         "Checking compact packet ID");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetHopCount (), 30,
+                         "Checking compact hop count");
+  // The age of 2999 ms is read back against the same clock
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetTimeStamp (), MilliSeconds (2001),
+                         "Checking the timestamp carried as an age");
+  EpidemicHeader legacy2;
+  packet->RemoveHeader (legacy2);
+  NS_TEST_ASSERT_MSG_EQ (legacy2.IsValid (), true, "Checking a legacy header");
+  NS_TEST_ASSERT_MSG_EQ (legacy2.GetVersion (), EpidemicHeader::LEGACY,
+                         "Checking that a leading 0xFF is a legacy header");
+  NS_TEST_ASSERT_MSG_EQ (legacy2.GetPacketID (), 0xFF01002A,
+                         "Checking legacy packet ID");
+
+  compact1.SetChunk (0x01010028, 1, 3);
+  compact1.SetCopies (5);
+  packet->AddHeader (compact1);
+  packet->RemoveHeader (compact2);
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetSerializedSize (), 15,
+                         "Checking compact chunk header size");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetBundleID (), 0x01010028,
+                         "Checking compact bundle ID");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetChunkCount (), 3,
+                         "Checking compact chunk count");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetCopies (), 5,
+                         "Checking compact copy budget");
 
+  // A hop count above 255 is not clamped, the header stays legacy
+  compact1.SetHopCount (300);
+  packet->AddHeader (compact1);
+  packet->RemoveHeader (compact2);
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetVersion (), EpidemicHeader::LEGACY,
+                         "Checking the format of a large hop count");
+  NS_TEST_ASSERT_MSG_EQ (compact2.GetHopCount (), 300,
+                         "Checking a large hop count");
 
+  // An unknown version in the flags byte is rejected
+  Buffer buffer;
+  buffer.AddAtStart (16);
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteHtonU32 (0x0101002A);
+  i.WriteU8 (0x20);
+  i.WriteU8 (0, 11);
+  compact2.Deserialize (buffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (compact2.IsValid (), false,
+                         "Checking an unknown header version");
 
+  TypeHeader type1 (TypeHeader::BEACON);
+  type1.SetCompact (true);
+  packet->AddHeader (type1);
+  TypeHeader type2;
+  packet->RemoveHeader (type2);
+  NS_TEST_ASSERT_MSG_EQ (type2.IsValid (), true, "Checking a compact type");
+  NS_TEST_ASSERT_MSG_EQ (type2.IsCompact (), true,
+                         "Checking the version of a compact type");
+  NS_TEST_ASSERT_MSG_EQ (type2.GetMessageType (), TypeHeader::BEACON,
+                         "Checking the type of a compact beacon");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), 0,
+                         "Checking that a compact beacon is one byte");
+}
 
 
 struct EpidemicRqueueTest : public TestCase
@@ -176,9 +425,2836 @@ EpidemicRqueueTest::DoRun ()
                          "Checking the packetID for two entries");
   NS_TEST_EXPECT_MSG_EQ (q.Dequeue (e4), false,
                          "Checking the dequeue function with empty queue");
+
+  // Packets 1111 and 2222 expire at 1 s, next to each other in the map
+  q.Enqueue (e1);
+  q.Enqueue (e2);
+  QueueEntry e5 (packet2, h, ucb, ecb, Seconds (10), 3333);
+  q.Enqueue (e5);
+  Simulator::Schedule (Seconds (2), &EpidemicRqueueTest::CheckTimeout, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+EpidemicRqueueTest::CheckTimeout ()
+{
+  // The sweep erases entries while it walks the map
+  q.DropExpiredPackets ();
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 1,
+                         "Checking that consecutive expired packets are dropped");
+  QueueEntry e;
+  q.Dequeue (e);
+  NS_TEST_EXPECT_MSG_EQ (e.GetPacketID (), 3333,
+                         "Checking the packet that has not expired");
+}
+
+
+
+static void
+RecordFireTime (Time *fireTime, uint32_t *context)
+{
+  *fireTime = Simulator::Now ();
+  *context = Simulator::GetContext ();
+}
+
+struct EpidemicBeaconSchedulerTest : public TestCase
+{
+  EpidemicBeaconSchedulerTest () : TestCase ("EpidemicBeaconScheduler")
+  {
+  }
+  virtual void DoRun ();
+  Time m_fireTimes[3];
+  uint32_t m_contexts[3];
+};
+
+void
+EpidemicBeaconSchedulerTest::DoRun ()
+{
+  Ptr<BeaconScheduler> scheduler = CreateObject<BeaconScheduler> ();
+  scheduler->SetAttribute ("SlotWidth", TimeValue (MilliSeconds (10)));
+  uint32_t a = scheduler->Register (
+      MakeBoundCallback (&RecordFireTime, &m_fireTimes[0], &m_contexts[0]), 3);
+  uint32_t b = scheduler->Register (
+      MakeBoundCallback (&RecordFireTime, &m_fireTimes[1], &m_contexts[1]), 7);
+  uint32_t c = scheduler->Register (
+      MakeBoundCallback (&RecordFireTime, &m_fireTimes[2], &m_contexts[2]), 9);
+  m_fireTimes[2] = Seconds (-1);
+  scheduler->Schedule (a, MilliSeconds (1));
+  scheduler->Schedule (b, MilliSeconds (5));
+  scheduler->Schedule (c, MilliSeconds (15));
+  scheduler->Cancel (c);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // Both share the event of the first slot but keep their own jitter
+  NS_TEST_EXPECT_MSG_EQ (m_fireTimes[0], MilliSeconds (1),
+                         "Checking the due time of the first beacon");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[0], 3,
+                         "Checking the context of the first beacon");
+  NS_TEST_EXPECT_MSG_EQ (m_fireTimes[1], MilliSeconds (5),
+                         "Checking the due time of the second beacon");
+  NS_TEST_EXPECT_MSG_EQ (m_contexts[1], 7,
+                         "Checking the context of the second beacon");
+  NS_TEST_EXPECT_MSG_EQ (m_fireTimes[2], Seconds (-1),
+                         "Checking that a cancelled beacon does not fire");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetSlotEventCount (), 2,
+                         "Checking the number of slot events");
+  scheduler->Dispose ();
+}
+
+/// Unit test for the SessionManager
+struct EpidemicSessionManagerTest : public TestCase
+{
+  EpidemicSessionManagerTest () : TestCase ("EpidemicSessionManager"),
+                                  m_sessions (1)
+  {
+  }
+  virtual void DoRun ();
+  /// End the first session and start the queued one
+  void EndFirst ();
+  SessionManager m_sessions;
+};
+
+void
+EpidemicSessionManagerTest::DoRun ()
+{
+  Ipv4Address a ("10.0.0.1");
+  Ipv4Address b ("10.0.0.2");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.Request (a), true,
+                         "Checking that a free slot is granted");
+  m_sessions.MarkStarted (a);
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.Request (b), false,
+                         "Checking that a session waits when the limit is reached");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.Request (a), false,
+                         "Checking that an active peer is not requested twice");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.Request (b), false,
+                         "Checking that a pending peer is not queued twice");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GetActiveCount (), 1,
+                         "Checking the number of active sessions");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GetPendingCount (), 1,
+                         "Checking the number of pending peers");
+  Simulator::Schedule (Seconds (2), &EpidemicSessionManagerTest::EndFirst,
+                       this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GetPendingCount (), 0,
+                         "Checking that the pending peer was granted");
+  NS_TEST_EXPECT_MSG_EQ ((m_sessions.Find (b) != 0), true,
+                         "Checking that the granted session is active");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GetMaxWaitTime (), Seconds (2),
+                         "Checking the longest waiting time");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GetMeanWaitTime (), Seconds (1),
+                         "Checking the mean waiting time");
+}
+
+void
+EpidemicSessionManagerTest::EndFirst ()
+{
+  Ipv4Address peer;
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GrantPending (peer), false,
+                         "Checking that no slot is free before a session ends");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.End (Ipv4Address ("10.0.0.1")), true,
+                         "Checking that the active session is ended");
+  NS_TEST_EXPECT_MSG_EQ (m_sessions.GrantPending (peer), true,
+                         "Checking that the freed slot is granted");
+  NS_TEST_EXPECT_MSG_EQ (peer, Ipv4Address ("10.0.0.2"),
+                         "Checking that pending peers are granted in order");
+  m_sessions.MarkStarted (peer);
+}
+
+/// Unit test for resuming the transfer of an interrupted session
+struct EpidemicSessionResumeTest : public TestCase
+{
+  EpidemicSessionResumeTest () : TestCase ("EpidemicSessionResume")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicSessionResumeTest::DoRun ()
+{
+  SessionManager sessions;
+  Ipv4Address peer ("10.0.0.2");
+  std::vector<uint32_t> packets;
+  packets.push_back (1);
+  packets.push_back (2);
+  packets.push_back (3);
+  sessions.Offer (peer, packets);
+  NS_TEST_EXPECT_MSG_EQ (sessions.GetPeerState (peer).offered.size (), 3,
+                         "Checking that the first offer is recorded");
+
+  // Packet 1 arrived, 2 and 3 were lost, 4 and 5 are new
+  packets.clear ();
+  packets.push_back (2);
+  packets.push_back (4);
+  packets.push_back (3);
+  packets.push_back (5);
+  sessions.Offer (peer, packets);
+  NS_TEST_EXPECT_MSG_EQ (sessions.GetPeerState (peer).confirmed, 1,
+                         "Checking the number of confirmed packets");
+  NS_TEST_EXPECT_MSG_EQ (packets.size (), 4, "Checking the offer size");
+  NS_TEST_EXPECT_MSG_EQ (packets[0], 2, "Checking that lost packets go first");
+  NS_TEST_EXPECT_MSG_EQ (packets[1], 3, "Checking that lost packets go first");
+  NS_TEST_EXPECT_MSG_EQ (packets[2], 4, "Checking that new packets follow");
+  NS_TEST_EXPECT_MSG_EQ (packets[3], 5, "Checking that new packets follow");
+}
+
+/// Unit test for failed and recovered session accounting
+struct EpidemicSessionRetryTest : public TestCase
+{
+  EpidemicSessionRetryTest () : TestCase ("EpidemicSessionRetry")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicSessionRetryTest::DoRun ()
+{
+  SessionManager sessions;
+  Ipv4Address a ("10.0.0.2");
+  Ipv4Address b ("10.0.0.3");
+  Ipv4Address c ("10.0.0.4");
+  sessions.Request (a);
+  sessions.Request (b);
+  sessions.Request (c);
+  NS_TEST_EXPECT_MSG_EQ (sessions.Complete (a), false,
+                         "Checking that a session not started is not completed");
+  sessions.MarkStarted (a);
+  sessions.MarkStarted (b);
+  sessions.MarkStarted (c);
+  sessions.Find (b)->retries = 1;
+  NS_TEST_EXPECT_MSG_EQ (sessions.Complete (a), true, "Checking completion");
+  NS_TEST_EXPECT_MSG_EQ (sessions.Complete (b), true, "Checking completion");
+  NS_TEST_EXPECT_MSG_EQ (sessions.Fail (c), true, "Checking failure");
+  NS_TEST_EXPECT_MSG_EQ (sessions.Complete (c), false,
+                         "Checking that a failed session is gone");
+  NS_TEST_EXPECT_MSG_EQ (sessions.GetRecoveredCount (), 1,
+                         "Checking the number of recovered sessions");
+  NS_TEST_EXPECT_MSG_EQ (sessions.GetFailedCount (), 1,
+                         "Checking the number of failed sessions");
+
+  // A retransmitted summary vector only triggers packets not sent yet
+  std::vector<uint32_t> packets;
+  packets.push_back (1);
+  packets.push_back (2);
+  sessions.Offer (a, packets);
+  packets.push_back (3);
+  sessions.OfferRemaining (a, packets);
+  NS_TEST_EXPECT_MSG_EQ (packets.size (), 1, "Checking the remaining packets");
+  NS_TEST_EXPECT_MSG_EQ (packets[0], 3, "Checking the remaining packets");
+  NS_TEST_EXPECT_MSG_EQ (sessions.GetPeerState (a).offered.size (), 3,
+                         "Checking that the remaining packets are offered");
+}
+
+/// Unit test for the contact time estimate
+struct EpidemicContactTimeTest : public TestCase
+{
+  EpidemicContactTimeTest () : TestCase ("EpidemicContactTime")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicContactTimeTest::DoRun ()
+{
+  // Peer 20 m ahead, moving away at 10 m/s, range 100 m
+  Time t = RoutingProtocol::EstimateContactTime (Vector (0, 0, 0),
+                                                 Vector (0, 0, 0),
+                                                 Vector (20, 0, 0),
+                                                 Vector (10, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ_TOL (t.GetSeconds (), 8, 1e-6,
+                             "Checking the time until the peer leaves");
+  // Peer 20 m ahead, approaching at 10 m/s, passes and leaves at -100 m
+  t = RoutingProtocol::EstimateContactTime (Vector (0, 0, 0),
+                                            Vector (0, 0, 0),
+                                            Vector (20, 0, 0),
+                                            Vector (-10, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ_TOL (t.GetSeconds (), 12, 1e-6,
+                             "Checking the time for an approaching peer");
+  t = RoutingProtocol::EstimateContactTime (Vector (0, 0, 0),
+                                            Vector (5, 0, 0),
+                                            Vector (20, 0, 0),
+                                            Vector (5, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ (t, Time::Max (),
+                         "Checking that nodes moving together stay in contact");
+  t = RoutingProtocol::EstimateContactTime (Vector (0, 0, 0),
+                                            Vector (0, 0, 0),
+                                            Vector (200, 0, 0),
+                                            Vector (0, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ (t, Seconds (0),
+                         "Checking that a peer out of range has no contact");
+}
+
+/// Unit test for GF(2^8) arithmetic and random linear network coding
+struct EpidemicNetworkCodingTest : public TestCase
+{
+  EpidemicNetworkCodingTest () : TestCase ("EpidemicNetworkCoding")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicNetworkCodingTest::DoRun ()
+{
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) Gf256::Mul (0x80, 2), 0x1D,
+                         "Checking reduction by the field polynomial");
+  for (uint32_t a = 1; a < 256; ++a)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) Gf256::Mul (a, Gf256::Inv (a)), 1,
+                             "Checking inverse of " << a);
+    }
+
+  // Both paths of the region kernel give the same result, including
+  // the bytes after the last full vector
+  std::vector<uint8_t> src (37);
+  std::vector<uint8_t> scalar (37);
+  for (uint32_t i = 0; i < src.size (); ++i)
+    {
+      src[i] = i * 7 + 3;
+      scalar[i] = i * 13;
+    }
+  std::vector<uint8_t> simd (scalar);
+  uint8_t last = scalar[36];
+  bool simdEnabled = Gf256::IsSimdEnabled ();
+  Gf256::EnableSimd (false);
+  Gf256::MulAddRegion (&scalar[0], &src[0], 0xA7, scalar.size ());
+  Gf256::EnableSimd (true);
+  Gf256::MulAddRegion (&simd[0], &src[0], 0xA7, simd.size ());
+  Gf256::EnableSimd (simdEnabled);
+  NS_TEST_EXPECT_MSG_EQ ((simd == scalar), true,
+                         "Checking SIMD and scalar kernels");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) scalar[36],
+                         (uint32_t) (last ^ Gf256::Mul (0xA7, src[36])),
+                         "Checking the scalar kernel");
+
+  // Coded packets carry a coding header behind the epidemic header
+  Ptr<Packet> packet = Create<Packet> ();
+  std::vector<uint8_t> coefficients1;
+  coefficients1.push_back (7);
+  coefficients1.push_back (0);
+  coefficients1.push_back (201);
+  CodingHeader coding1 (0x00010005, 1002, coefficients1);
+  packet->AddHeader (coding1);
+  EpidemicHeader coded1;
+  coded1.SetPacketID (0x00010006);
+  coded1.SetCoded ();
+  packet->AddHeader (coded1);
+  EpidemicHeader coded2;
+  packet->RemoveHeader (coded2);
+  NS_TEST_ASSERT_MSG_EQ (coded2.IsCoded (),true, "Checking coded flag");
+  NS_TEST_ASSERT_MSG_EQ (coded2.IsChunk (),false, "Checking chunk flag");
+  CodingHeader coding2;
+  packet->RemoveHeader (coding2);
+  NS_TEST_ASSERT_MSG_EQ (coding2.GetSerializedSize (),10,
+                         "Checking coding header size");
+  NS_TEST_ASSERT_MSG_EQ (coding2.GetGenerationID (),0x00010005,
+                         "Checking generation ID");
+  NS_TEST_ASSERT_MSG_EQ (coding2.GetSymbolSize (),1002,
+                         "Checking symbol size");
+  NS_TEST_ASSERT_MSG_EQ ((coding2.GetCoefficients () == coefficients1), true,
+                         "Checking coding coefficients");
+
+  // Three source symbols, the last one shorter
+  RlncEncoder encoder (4);
+  const uint8_t s0[] = { 1, 2, 3, 4 };
+  const uint8_t s1[] = { 5, 6, 7, 8 };
+  const uint8_t s2[] = { 9, 10 };
+  encoder.AddSymbol (s0, 4);
+  encoder.AddSymbol (s1, 4);
+  encoder.AddSymbol (s2, 2);
+  NS_TEST_EXPECT_MSG_EQ (encoder.GetGenerationSize (), 3,
+                         "Checking generation size");
+  RlncDecoder decoder (3, 4);
+  uint8_t coded[4];
+  const uint8_t c0[] = { 1, 2, 3 };
+  const uint8_t c1[] = { 2, 4, 6 };   // 2 * c0, not innovative
+  const uint8_t c2[] = { 0, 1, 5 };
+  const uint8_t c3[] = { 4, 0, 9 };
+  encoder.Encode (c0, coded);
+  NS_TEST_EXPECT_MSG_EQ (decoder.AddSymbol (c0, coded), true,
+                         "Checking first coded symbol");
+  encoder.Encode (c1, coded);
+  NS_TEST_EXPECT_MSG_EQ (decoder.AddSymbol (c1, coded), false,
+                         "Checking dependent coded symbol");
+  encoder.Encode (c2, coded);
+  NS_TEST_EXPECT_MSG_EQ (decoder.AddSymbol (c2, coded), true,
+                         "Checking second coded symbol");
+  NS_TEST_EXPECT_MSG_EQ (decoder.IsComplete (), false,
+                         "Checking partial generation");
+  encoder.Encode (c3, coded);
+  NS_TEST_EXPECT_MSG_EQ (decoder.AddSymbol (c3, coded), true,
+                         "Checking third coded symbol");
+  NS_TEST_ASSERT_MSG_EQ (decoder.IsComplete (), true,
+                         "Checking decoded generation");
+  NS_TEST_EXPECT_MSG_EQ (std::equal (s0, s0 + 4, decoder.GetSymbol (0)), true,
+                         "Checking first source symbol");
+  NS_TEST_EXPECT_MSG_EQ (std::equal (s1, s1 + 4, decoder.GetSymbol (1)), true,
+                         "Checking second source symbol");
+  NS_TEST_EXPECT_MSG_EQ (std::equal (s2, s2 + 2, decoder.GetSymbol (2)), true,
+                         "Checking third source symbol");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) decoder.GetSymbol (2)[3], 0,
+                         "Checking padding of the third source symbol");
+}
+
+/// Unit test for the PRoPHET predictability table
+struct EpidemicProphetTest : public TestCase
+{
+  EpidemicProphetTest () : TestCase ("EpidemicProphet")
+  {
+  }
+  virtual void DoRun ();
+  /// Check the aging after one time unit
+  void CheckAging ();
+  /// Table under test
+  PredictabilityTable m_table;
+};
+
+void
+EpidemicProphetTest::DoRun ()
+{
+  Ipv4Address b ("10.1.1.2");
+  Ipv4Address c ("10.1.1.3");
+  m_table.SetParameters (0.75, 0.25, 0.98, Seconds (30));
+  PredictabilityList peerTable;
+  peerTable.push_back (std::make_pair (c, 0.8));
+  m_table.Update (b, peerTable);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.Get (b), 0.75, 1e-9,
+                             "Checking the first encounter");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.Get (c), 0.75 * 0.8 * 0.25, 1e-9,
+                             "Checking transitivity");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.GetPeer (b, c), 0.8, 1e-9,
+                             "Checking the table kept for the peer");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetPeer (c, b), 0,
+                         "Checking a peer without table");
+  m_table.Update (b, PredictabilityList ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.Get (b), 0.9375, 1e-9,
+                             "Checking the second encounter");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetPeer (b, c), 0,
+                         "Checking that the peer table is replaced");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetEntries (0.5).size (), 1,
+                         "Checking the entries above a threshold");
+  Simulator::Schedule (Seconds (30), &EpidemicProphetTest::CheckAging, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+EpidemicProphetTest::CheckAging ()
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.Get (Ipv4Address ("10.1.1.2")),
+                             0.9375 * 0.98, 1e-9,
+                             "Checking the decay over one time unit");
+}
+
+/// Unit test for the MaxProp encounter table
+struct EpidemicMaxPropTest : public TestCase
+{
+  EpidemicMaxPropTest () : TestCase ("EpidemicMaxProp")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicMaxPropTest::DoRun ()
+{
+  Ipv4Address b ("10.1.1.2");
+  Ipv4Address c ("10.1.1.3");
+  Ipv4Address d ("10.1.1.4");
+  EncounterTable table;
+  PredictabilityList peerTable;
+  peerTable.push_back (std::make_pair (c, 0.25));
+  table.Update (b, peerTable);
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetProbability (b), 1, 1e-9,
+                             "Checking the first encounter");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetCost (b), 0, 1e-9,
+                             "Checking the cost of a direct neighbor");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetCost (c), 0.75, 1e-9,
+                             "Checking the cost through a peer");
+  NS_TEST_EXPECT_MSG_EQ (table.GetCost (d),
+                         std::numeric_limits<double>::infinity (),
+                         "Checking an unknown destination");
+  NS_TEST_EXPECT_MSG_EQ (table.GetComputationCount (), 1,
+                         "Checking that costs are computed once per change");
+  table.Update (c, PredictabilityList ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetProbability (b), 0.5, 1e-9,
+                             "Checking the normalization");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetProbability (c), 0.5, 1e-9,
+                             "Checking the second encounter");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetCost (c), 0.5, 1e-9,
+                             "Checking the shorter direct path");
+  NS_TEST_EXPECT_MSG_EQ (table.GetComputationCount (), 2,
+                         "Checking the recomputation after a change");
+  NS_TEST_EXPECT_MSG_EQ (table.GetEntries ().size (), 2,
+                         "Checking the exchanged entries");
+}
+
+/**
+ * \param entry a queued packet
+ * \returns the cost of the packet, its ID in the MaxProp queue test
+ */
+static double
+GetIdCost (const QueueEntry &entry)
+{
+  return entry.GetPacketID ();
+}
+
+/// Unit test for the send order and the drops of a queue ordered by cost
+struct EpidemicMaxPropQueueTest : public TestCase
+{
+  EpidemicMaxPropQueueTest () : TestCase ("EpidemicMaxPropQueue")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicMaxPropQueueTest::DoRun ()
+{
+  Ipv4Address peer ("10.1.1.2");
+  PacketQueue q (3);
+  q.SetCostCallback (MakeCallback (&GetIdCost));
+  Ipv4Header h;
+  h.SetDestination (Ipv4Address ("10.1.1.9"));
+  uint32_t ids[] = { 5, 9, 1 };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      if (ids[i] == 9)
+        {
+          h.SetDestination (peer);
+        }
+      QueueEntry e (Create<Packet> (), h, QueueEntry::UnicastForwardCallback (),
+                    QueueEntry::ErrorCallback (), Seconds (100), ids[i]);
+      q.Insert (e);
+      h.SetDestination (Ipv4Address ("10.1.1.9"));
+    }
+  std::vector<uint32_t> packets (ids, ids + 3);
+  q.OrderTransferList (packets, peer);
+  NS_TEST_EXPECT_MSG_EQ (packets[0], 9,
+                         "Checking that packets for the peer go first");
+  NS_TEST_EXPECT_MSG_EQ (packets[1], 1, "Checking the cheapest packet");
+  NS_TEST_EXPECT_MSG_EQ (packets[2], 5, "Checking the most expensive packet");
+
+  // The most expensive packet is dropped, not the oldest one
+  QueueEntry e (Create<Packet> (), h, QueueEntry::UnicastForwardCallback (),
+                QueueEntry::ErrorCallback (), Seconds (100), 3);
+  q.Insert (e);
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 3, "Checking the queue size");
+  NS_TEST_EXPECT_MSG_EQ (q.Contains (9), false,
+                         "Checking that the most expensive packet is dropped");
+  NS_TEST_EXPECT_MSG_EQ (q.Contains (5), true,
+                         "Checking that the oldest packet is kept");
+}
+
+/// Unit test for the link-state table of hybrid mode
+struct EpidemicLinkStateTest : public TestCase
+{
+  EpidemicLinkStateTest () : TestCase ("EpidemicLinkState")
+  {
+  }
+  virtual void DoRun ();
+  /// Check that the own entry is sent again before it turns stale
+  void CheckRefresh ();
+  /// Check that stale neighbors and entries are dropped
+  void CheckTimeout ();
+  /// Table under test
+  LinkStateTable m_table;
+};
+
+void
+EpidemicLinkStateTest::DoRun ()
+{
+  Ipv4Address a ("10.1.1.1");
+  Ipv4Address b ("10.1.1.2");
+  Ipv4Address c ("10.1.1.3");
+  Ipv4Address d ("10.1.1.4");
+  Ipv4Address nextHop;
+  m_table.SetAddress (a);
+  m_table.SetTimeout (Seconds (3));
+  m_table.AddNeighbor (b);
+  // Chain a - b - c - d
+  LinkStateList entries (2);
+  entries[0].origin = b;
+  entries[0].sequence = 1;
+  entries[0].neighbors.push_back (a);
+  entries[0].neighbors.push_back (c);
+  entries[1].origin = c;
+  entries[1].sequence = 1;
+  entries[1].neighbors.push_back (b);
+  entries[1].neighbors.push_back (d);
+  m_table.Update (entries);
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetNextHop (d, nextHop), true,
+                         "Checking a destination three hops away");
+  NS_TEST_EXPECT_MSG_EQ (nextHop, b, "Checking the next hop");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetNextHop (Ipv4Address ("10.1.1.5"),
+                                             nextHop), false,
+                         "Checking a destination outside the component");
+  // An older entry of c without d is ignored
+  entries[1].sequence = 0;
+  entries[1].neighbors.pop_back ();
+  m_table.Update (entries);
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetNextHop (d, nextHop), true,
+                         "Checking that an older entry is ignored");
+  LinkStateList own = m_table.GetEntries (1400);
+  NS_TEST_EXPECT_MSG_EQ (own.size (), 3, "Checking the flooded entries");
+  NS_TEST_EXPECT_MSG_EQ (own[0].origin, a, "Checking the own entry");
+  NS_TEST_EXPECT_MSG_EQ (own[0].neighbors.size (), 1,
+                         "Checking the own neighbors");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetEntries (1400).size (), 0,
+                         "Checking that unchanged entries are not flooded");
+  // Only the entry of c changed, and it does not fit the first beacon
+  entries[1].sequence = 2;
+  m_table.Update (entries);
+  m_table.AddNeighbor (c);
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetEntries (2 + 15).size (), 1,
+                         "Checking the own entry in a small beacon");
+  own = m_table.GetEntries (2 + 15);
+  NS_TEST_EXPECT_MSG_EQ (own.size (), 1, "Checking the deferred entry");
+  NS_TEST_EXPECT_MSG_EQ (own[0].origin, c, "Checking the deferred origin");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetEntries (1400).size (), 0,
+                         "Checking that the deferred entry went once");
+  Simulator::Schedule (Seconds (1.5), &EpidemicLinkStateTest::CheckRefresh,
+                       this);
+  // A count beyond the bytes of the frame is rejected
+  Buffer buffer;
+  buffer.AddAtStart (2 + 7);
+  buffer.Begin ().WriteHtonU16 (0xFFFF);
+  LinkStateHeader header;
+  NS_TEST_EXPECT_MSG_EQ ((header.Deserialize (buffer.Begin ()) <= 2 + 7), true,
+                         "Checking that a link-state view stays in the frame");
+  NS_TEST_EXPECT_MSG_EQ (header.IsValid (), false,
+                         "Checking that a forged count is rejected");
+  NS_TEST_EXPECT_MSG_EQ (header.GetEntries ().size (), 0,
+                         "Checking the entries of a rejected view");
+  Simulator::Schedule (Seconds (4), &EpidemicLinkStateTest::CheckTimeout,
+                       this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+EpidemicLinkStateTest::CheckRefresh ()
+{
+  LinkStateList own = m_table.GetEntries (1400);
+  NS_TEST_EXPECT_MSG_EQ (own.size (), 1, "Checking the refreshed entries");
+  NS_TEST_EXPECT_MSG_EQ (own[0].origin, Ipv4Address ("10.1.1.1"),
+                         "Checking the refreshed entry");
+}
+
+void
+EpidemicLinkStateTest::CheckTimeout ()
+{
+  Ipv4Address nextHop;
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetNextHop (Ipv4Address ("10.1.1.4"),
+                                             nextHop), false,
+                         "Checking that stale entries are dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_table.GetSize (), 0,
+                         "Checking the table size after the timeout");
+}
+
+/// Unit test for the delivered windows of the destination
+struct EpidemicDeliveredWindowTest : public TestCase
+{
+  EpidemicDeliveredWindowTest () : TestCase ("EpidemicDeliveredWindow")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicDeliveredWindowTest::DoRun ()
+{
+  DeliveredWindow window (100);
+  NS_TEST_EXPECT_MSG_EQ (window.GetSize (), 128,
+                         "Checking that the size is rounded up");
+  uint32_t source = 0x0102 << 16;
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 10), true,
+                         "Checking the first packet of a source");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 10), false,
+                         "Checking a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 5), true,
+                         "Checking a packet received out of order");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 5), false,
+                         "Checking a duplicate below the highest");
+  // Move the window across a word boundary
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 80), true,
+                         "Checking a packet ahead of the window");
+  NS_TEST_EXPECT_MSG_EQ (window.IsDelivered (source | 5), true,
+                         "Checking that the window keeps shifted bits");
+  NS_TEST_EXPECT_MSG_EQ (window.IsDelivered (source | 6), false,
+                         "Checking a packet not delivered yet");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 200), true,
+                         "Checking a packet past the whole window");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 6), false,
+                         "Checking a packet older than the window");
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 81), true,
+                         "Checking a packet at the end of the window");
+  NS_TEST_EXPECT_MSG_EQ (window.Record ((0x0103 << 16) | 80), true,
+                         "Checking that sources have separate windows");
+  NS_TEST_EXPECT_MSG_EQ (window.GetSourceCount (), 2,
+                         "Checking the number of sources");
+  // Sequence numbers wrap
+  source = 0x0104 << 16;
+  window.Record (source | 0xFFF0);
+  NS_TEST_EXPECT_MSG_EQ (window.Record (source | 5), true,
+                         "Checking a packet after the wrap");
+  NS_TEST_EXPECT_MSG_EQ (window.IsDelivered (source | 0xFFF0), true,
+                         "Checking a packet before the wrap");
+  NS_TEST_EXPECT_MSG_EQ (window.IsDelivered (source | 0xFFF1), false,
+                         "Checking a missing packet before the wrap");
+
+  // The windows as a neighbor reads them from a DELIVERED option
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (DeliveredHeader (window.GetEntries (2)));
+  DeliveredHeader delivered;
+  packet->RemoveHeader (delivered);
+  NS_TEST_ASSERT_MSG_EQ (delivered.IsValid (), true,
+                         "Checking the delivered header");
+  NS_TEST_EXPECT_MSG_EQ (delivered.GetEntries ().size (), 2,
+                         "Checking the limit of advertised windows");
+  DeliveredWindow peer;
+  peer.SetEntries (delivered.GetEntries ());
+  NS_TEST_EXPECT_MSG_EQ (peer.GetSize (), 128,
+                         "Checking the size of the advertised windows");
+  NS_TEST_EXPECT_MSG_EQ (peer.IsDelivered ((0x0102 << 16) | 81), true,
+                         "Checking an advertised packet");
+  NS_TEST_EXPECT_MSG_EQ (peer.IsDelivered ((0x0102 << 16) | 82), false,
+                         "Checking a packet the window does not hold");
+  NS_TEST_EXPECT_MSG_EQ (peer.IsDelivered ((0x0104 << 16) | 5), false,
+                         "Checking a source beyond the limit");
+}
+
+/// Unit test for the set operations on packet IDs
+struct EpidemicIdSetTest : public TestCase
+{
+  EpidemicIdSetTest () : TestCase ("EpidemicIdSet")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicIdSetTest::DoRun ()
+{
+  // Own IDs are the multiples of 3 below 300, the peer has the even
+  // numbers below 200 and some IDs past the end of the own ones
+  std::vector<uint32_t> own;
+  std::vector<uint32_t> peer;
+  for (uint32_t id = 0; id < 300; id += 3)
+    {
+      own.push_back (id);
+    }
+  for (uint32_t id = 0; id < 200; id += 2)
+    {
+      peer.push_back (id);
+    }
+  peer.push_back (301);
+  peer.push_back (302);
+  std::vector<uint32_t> difference;
+  std::vector<uint32_t> intersection;
+  for (uint32_t i = 0; i < own.size (); ++i)
+    {
+      bool found = own[i] < 200 && own[i] % 2 == 0;
+      (found ? intersection : difference).push_back (own[i]);
+    }
+  IdSet::Path path = IdSet::GetPath ();
+  for (uint32_t p = IdSet::SCALAR; p <= IdSet::GetBestPath (); ++p)
+    {
+      IdSet::SetPath (static_cast<IdSet::Path> (p));
+      // Every size exercises a different tail of the blocks
+      for (uint32_t size = 0; size <= own.size (); size += 7)
+        {
+          std::vector<uint32_t> out (size);
+          out.resize (IdSet::Difference (own.data (), size, peer.data (),
+                                         peer.size (), out.data ()));
+          std::vector<uint32_t> expected;
+          for (uint32_t i = 0; i < difference.size (); ++i)
+            {
+              if (difference[i] < 3 * size)
+                {
+                  expected.push_back (difference[i]);
+                }
+            }
+          NS_TEST_EXPECT_MSG_EQ ((out == expected), true,
+                                 "Checking the difference on path " << p);
+        }
+      std::vector<uint32_t> out (own.size ());
+      out.resize (IdSet::Intersection (own.data (), own.size (), peer.data (),
+                                       peer.size (), out.data ()));
+      NS_TEST_EXPECT_MSG_EQ ((out == intersection), true,
+                             "Checking the intersection on path " << p);
+      out.resize (own.size ());
+      out.resize (IdSet::Difference (own.data (), own.size (), 0, 0,
+                                     out.data ()));
+      NS_TEST_EXPECT_MSG_EQ ((out == own), true,
+                             "Checking the difference with an empty set");
+    }
+  IdSet::SetPath (path);
+}
+
+/**
+ * Summary vectors sent from the queue index and compared with the queue
+ * while they are read.
+ */
+struct EpidemicSummaryVectorViewTest : public TestCase
+{
+  EpidemicSummaryVectorViewTest () : TestCase ("EpidemicSummaryVectorView")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicSummaryVectorViewTest::DoRun ()
+{
+  // Own IDs are the multiples of 3 below 1500, the peer has the even
+  // numbers below 1000 and some IDs past the end of the own ones, which
+  // spans several blocks of the difference
+  PacketQueue q (1000);
+  Ipv4Header h;
+  std::vector<uint32_t> own;
+  for (uint32_t id = 0; id < 1500; id += 3)
+    {
+      QueueEntry e (Create<Packet> (), h, QueueEntry::UnicastForwardCallback (),
+                    QueueEntry::ErrorCallback (), Seconds (100), id);
+      q.Enqueue (e);
+      own.push_back (id);
+    }
+  SummaryVectorHeader peer;
+  std::vector<uint32_t> missing;
+  std::vector<uint32_t> unknown;
+  for (uint32_t id = 0; id < 1000; id += 2)
+    {
+      peer.Add (id);
+      if (id % 3 != 0)
+        {
+          unknown.push_back (id);
+        }
+    }
+  peer.Add (1501);
+  peer.Add (1502);
+  unknown.push_back (1501);
+  unknown.push_back (1502);
+  for (uint32_t i = 0; i < own.size (); ++i)
+    {
+      if (own[i] >= 1000 || own[i] % 2 != 0)
+        {
+          missing.push_back (own[i]);
+        }
+    }
+
+  Ptr<Packet> p = Create<Packet> ();
+  SummaryVectorView view (q);
+  p->AddHeader (view);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 4 + 4 * own.size (),
+                         "Checking the size of the summary vector view");
+  SummaryVectorHeader sent;
+  p->RemoveHeader (sent);
+  NS_TEST_EXPECT_MSG_EQ (sent.Size (), own.size (),
+                         "Checking the IDs read from the view");
+  bool same = true;
+  for (uint32_t i = 0; i < own.size (); ++i)
+    {
+      same = same && sent.Contains (own[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (same, true, "Checking the IDs read from the view");
+
+  p = Create<Packet> ();
+  p->AddHeader (peer);
+  SummaryVectorDifference difference (q);
+  p->RemoveHeader (difference);
+  NS_TEST_EXPECT_MSG_EQ (difference.IsValid (), true,
+                         "Checking a sorted summary vector");
+  NS_TEST_EXPECT_MSG_EQ (difference.Size (), peer.Size (),
+                         "Checking the size of a sorted summary vector");
+  NS_TEST_EXPECT_MSG_EQ ((difference.GetMissing () == missing), true,
+                         "Checking the IDs missing in the peer");
+  NS_TEST_EXPECT_MSG_EQ ((difference.GetUnknown () == unknown), true,
+                         "Checking the IDs missing in the queue");
+
+  // IDs out of order and repeated are sorted first
+  SummaryVectorHeader shuffled;
+  for (uint32_t id = 998; id < 1000; id -= 2)
+    {
+      shuffled.Add (id);
+    }
+  shuffled.Add (1502);
+  shuffled.Add (1501);
+  shuffled.Add (1502);
+  p = Create<Packet> ();
+  p->AddHeader (shuffled);
+  p->RemoveHeader (difference);
+  NS_TEST_EXPECT_MSG_EQ ((difference.GetMissing () == missing), true,
+                         "Checking the IDs missing in an unsorted peer");
+  NS_TEST_EXPECT_MSG_EQ ((difference.GetUnknown () == unknown), true,
+                         "Checking the IDs missing in the queue, unsorted");
+
+  SummaryVectorDifference bounded (q, 100);
+  p = Create<Packet> ();
+  p->AddHeader (peer);
+  p->RemoveHeader (bounded);
+  NS_TEST_EXPECT_MSG_EQ (bounded.IsValid (), false,
+                         "Checking that a too long summary vector is rejected");
+}
+
+/// Unit test for the trace sources of the queue
+struct EpidemicQueueTraceTest : public TestCase
+{
+  EpidemicQueueTraceTest () : TestCase ("EpidemicQueueTrace"),
+                              q (4)
+  {
+  }
+  virtual void DoRun ();
+  void Enqueued (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    enqueued.push_back (packetID);
+  }
+  void Duplicated (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    duplicated.push_back (packetID);
+  }
+  void Dropped (Ptr<const Packet> packet, uint32_t packetID,
+                PacketQueue::DropReason reason)
+  {
+    dropped.push_back (packetID);
+    reasons.push_back (reason);
+  }
+  void CheckExpired ();
+  PacketQueue q;
+  PacketQueue::PacketTrace enqueueTrace;
+  PacketQueue::PacketTrace duplicateTrace;
+  PacketQueue::DropTrace dropTrace;
+  std::vector<uint32_t> enqueued;
+  std::vector<uint32_t> duplicated;
+  std::vector<uint32_t> dropped;
+  std::vector<PacketQueue::DropReason> reasons;
+};
+
+void
+EpidemicQueueTraceTest::DoRun ()
+{
+  enqueueTrace.ConnectWithoutContext (
+    MakeCallback (&EpidemicQueueTraceTest::Enqueued, this));
+  duplicateTrace.ConnectWithoutContext (
+    MakeCallback (&EpidemicQueueTraceTest::Duplicated, this));
+  dropTrace.ConnectWithoutContext (
+    MakeCallback (&EpidemicQueueTraceTest::Dropped, this));
+  q.SetTraces (&enqueueTrace, &duplicateTrace, &dropTrace);
+
+  Ipv4Header h;
+  // Three packets expire at 1 s, two more at 10 s
+  for (uint32_t id = 1; id <= 5; ++id)
+    {
+      QueueEntry e (Create<Packet> (), h, QueueEntry::UnicastForwardCallback (),
+                    QueueEntry::ErrorCallback (),
+                    Seconds (id <= 3 ? 1 : 10 + id), id);
+      q.Insert (e);
+    }
+  NS_TEST_EXPECT_MSG_EQ (enqueued.size (), 5, "Checking the enqueue trace");
+  NS_TEST_EXPECT_MSG_EQ (dropped.size (), 1,
+                         "Checking the drop trace of a full queue");
+  NS_TEST_EXPECT_MSG_EQ (dropped[0], 1, "Checking the oldest packet");
+  NS_TEST_EXPECT_MSG_EQ (reasons[0], PacketQueue::OLDEST,
+                         "Checking the reason of a full queue");
+
+  QueueEntry again (Create<Packet> (), h, QueueEntry::UnicastForwardCallback (),
+                    QueueEntry::ErrorCallback (), Seconds (10), 4);
+  NS_TEST_EXPECT_MSG_EQ (q.Insert (again), false,
+                         "Checking the insertion of a queued packet");
+  NS_TEST_EXPECT_MSG_EQ (duplicated.size (), 1, "Checking the duplicate trace");
+  q.Enqueue (again);
+  NS_TEST_EXPECT_MSG_EQ (enqueued.size (), 5,
+                         "Checking that an update is not traced");
+
+  Simulator::Schedule (Seconds (2), &EpidemicQueueTraceTest::CheckExpired,
+                       this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+EpidemicQueueTraceTest::CheckExpired ()
+{
+  // Consecutive expired packets are dropped in one pass
+  q.DropExpiredPackets ();
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 2,
+                         "Checking the queue size after the timeout");
+  NS_TEST_EXPECT_MSG_EQ (dropped.size (), 3, "Checking the expired packets");
+  NS_TEST_EXPECT_MSG_EQ (dropped[1], 2, "Checking the first expired packet");
+  NS_TEST_EXPECT_MSG_EQ (dropped[2], 3, "Checking the second expired packet");
+  NS_TEST_EXPECT_MSG_EQ (reasons[2], PacketQueue::EXPIRED,
+                         "Checking the reason of an expired packet");
+}
+
+/**
+ * Fuzz test for the deserialization of received headers.  Every entry
+ * of a corpus of valid and known-bad frames is mutated, truncated and
+ * extended with a generator seeded the same way in every run, and each
+ * result is read as every header type a node receives.  No read may go
+ * past the frame or allocate more than the frame can describe, and a
+ * header marked valid must serialize back to the bytes it was read from.
+ */
+struct EpidemicFuzzTest : public TestCase
+{
+  EpidemicFuzzTest () : TestCase ("EpidemicFuzz"),
+                        m_state (0x2545F491)
+  {
+  }
+  virtual void DoRun ();
+  /// \returns the next value of a xorshift generator
+  uint32_t Next ();
+  /**
+   * Read the headers from a frame.
+   * \param data the frame
+   */
+  void Check (const std::vector<uint8_t> &data);
+  /**
+   * Read one header type from a frame.
+   * \param buffer the frame
+   * \param data the bytes of the frame
+   * \param name the header name in the messages
+   */
+  template <typename T>
+  void CheckHeader (const Buffer &buffer, const std::vector<uint8_t> &data,
+                    const std::string &name);
+  /**
+   * \param header a header
+   * \returns the serialized header
+   */
+  static std::vector<uint8_t> Serialize (const Header &header);
+  /// State of the generator
+  uint32_t m_state;
+};
+
+uint32_t
+EpidemicFuzzTest::Next ()
+{
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
 }
 
+std::vector<uint8_t>
+EpidemicFuzzTest::Serialize (const Header &header)
+{
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+  header.Serialize (buffer.Begin ());
+  std::vector<uint8_t> data (buffer.GetSize ());
+  buffer.Begin ().Read (&data[0], data.size ());
+  return data;
+}
 
+template <typename T>
+void
+EpidemicFuzzTest::CheckHeader (const Buffer &buffer,
+                               const std::vector<uint8_t> &data,
+                               const std::string &name)
+{
+  T header;
+  uint32_t read = header.Deserialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ ((read <= data.size ()), true,
+                         "Checking that a " << name << " stays in the frame");
+  if (header.IsValid ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (read, header.GetSerializedSize (),
+                             "Checking the size of a valid " << name);
+      std::vector<uint8_t> again = Serialize (header);
+      NS_TEST_EXPECT_MSG_EQ (std::equal (again.begin (), again.end (),
+                                         data.begin ()), true,
+                             "Checking a valid " << name);
+    }
+}
+
+void
+EpidemicFuzzTest::Check (const std::vector<uint8_t> &data)
+{
+  Buffer buffer;
+  buffer.AddAtStart (data.size ());
+  if (!data.empty ())
+    {
+      buffer.Begin ().Write (&data[0], data.size ());
+    }
+  TypeHeader type;
+  NS_TEST_EXPECT_MSG_EQ ((type.Deserialize (buffer.Begin ()) <= data.size ()),
+                         true, "Checking that a type stays in the frame");
+  SummaryVectorHeader vector;
+  vector.SetMaxSize (64);
+  uint32_t read = vector.Deserialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ ((read <= data.size ()), true,
+                         "Checking that a summary vector stays in the frame");
+  NS_TEST_EXPECT_MSG_EQ ((vector.Size () <= 64), true,
+                         "Checking the summary vector limit");
+  if (vector.IsValid ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (read, vector.GetSerializedSize (),
+                             "Checking the size of a valid summary vector");
+    }
+  EpidemicHeader epidemic;
+  read = epidemic.Deserialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ ((read <= data.size ()), true,
+                         "Checking that an epidemic header stays in the frame");
+  if (epidemic.IsValid ())
+    {
+      // A valid header serializes back to the bytes it was read from
+      std::vector<uint8_t> again = Serialize (epidemic);
+      NS_TEST_EXPECT_MSG_EQ (std::equal (again.begin (), again.end (),
+                                         data.begin ()), true,
+                             "Checking a valid epidemic header");
+    }
+  CheckHeader<BeaconHeader> (buffer, data, "beacon header");
+  CheckHeader<BundleHeader> (buffer, data, "bundle header");
+  CheckHeader<OptionHeader> (buffer, data, "option header");
+  CheckHeader<ContactHeader> (buffer, data, "contact option");
+  CheckHeader<PredictabilityHeader> (buffer, data, "predictability option");
+  CheckHeader<CodingHeader> (buffer, data, "coding header");
+  CheckHeader<LinkStateHeader> (buffer, data, "link-state view");
+  CheckHeader<DeliveredHeader> (buffer, data, "delivered option");
+}
+
+void
+EpidemicFuzzTest::DoRun ()
+{
+  std::vector<std::vector<uint8_t> > corpus;
+  corpus.push_back (std::vector<uint8_t> ());
+  corpus.push_back (Serialize (TypeHeader (TypeHeader::REPLY)));
+  corpus.push_back (std::vector<uint8_t> (1, 0x7F));
+  SummaryVectorHeader vector;
+  vector.Add (0x01010001);
+  vector.Add (0x01020003);
+  vector.Add (0x0103FFFF);
+  corpus.push_back (Serialize (vector));
+  // A length of 2^32 - 1 without any ID behind it
+  std::vector<uint8_t> huge (4, 0xFF);
+  corpus.push_back (huge);
+  // More IDs than the limit, all present
+  SummaryVectorHeader large;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      large.Add (i);
+    }
+  corpus.push_back (Serialize (large));
+  EpidemicHeader epidemic;
+  epidemic.SetPacketID (0x0101002A);
+  epidemic.SetHopCount (10);
+  epidemic.SetTimeStamp (Seconds (12));
+  corpus.push_back (Serialize (epidemic));
+  epidemic.SetChunk (0x01010028, 1, 3);
+  epidemic.SetCopies (4);
+  corpus.push_back (Serialize (epidemic));
+  epidemic.SetVersion (EpidemicHeader::COMPACT);
+  corpus.push_back (Serialize (epidemic));
+  // A compact header with an endless age
+  std::vector<uint8_t> overlong (16, 0x80);
+  overlong[0] = 0x01;
+  overlong[1] = 0x01;
+  overlong[2] = 0x00;
+  overlong[3] = 0x2A;
+  overlong[4] = 0x10;
+  overlong[5] = 0x05;
+  corpus.push_back (overlong);
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.1.1.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.1.1.2"));
+  ipHeader.SetTtl (64);
+  corpus.push_back (Serialize (BundleHeader (ipHeader, 1000)));
+  corpus.push_back (Serialize (OptionHeader (OptionHeader::CONTACT, 24)));
+  corpus.push_back (Serialize (ContactHeader (Vector (-12.5, 3, 0),
+                                              Vector (1, -1, 0))));
+  PredictabilityList predictabilities;
+  predictabilities.push_back (std::make_pair (Ipv4Address ("10.1.1.2"), 0.5));
+  predictabilities.push_back (std::make_pair (Ipv4Address ("10.1.1.3"), 1.0));
+  corpus.push_back (Serialize (PredictabilityHeader (predictabilities)));
+  std::vector<uint8_t> coefficients (4, 0x11);
+  corpus.push_back (Serialize (CodingHeader (0x01010001, 256, coefficients)));
+  LinkStateList linkEntries (1);
+  linkEntries[0].origin = Ipv4Address ("10.1.1.1");
+  linkEntries[0].sequence = 3;
+  linkEntries[0].neighbors.push_back (Ipv4Address ("10.1.1.2"));
+  corpus.push_back (Serialize (LinkStateHeader (linkEntries)));
+  DeliveredWindow window (64);
+  window.Record (0x01010001);
+  window.Record (0x01010003);
+  corpus.push_back (Serialize (DeliveredHeader (window.GetEntries (4))));
+  // Counts of 2^16 - 1 without any entry behind them
+  corpus.push_back (std::vector<uint8_t> (2, 0xFF));
+  corpus.push_back (std::vector<uint8_t> (4, 0xFF));
+
+  for (uint32_t i = 0; i < corpus.size (); ++i)
+    {
+      Check (corpus[i]);
+    }
+  Buffer buffer;
+  buffer.AddAtStart (huge.size ());
+  buffer.Begin ().Write (&huge[0], huge.size ());
+  SummaryVectorHeader rejected;
+  rejected.Deserialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (rejected.IsValid (), false,
+                         "Checking a length larger than the frame");
+  NS_TEST_EXPECT_MSG_EQ (rejected.Size (), 0,
+                         "Checking that a rejected vector holds no IDs");
+
+  for (uint32_t round = 0; round < 256; ++round)
+    {
+      for (uint32_t i = 0; i < corpus.size (); ++i)
+        {
+          std::vector<uint8_t> data = corpus[i];
+          switch (Next () % 3)
+            {
+            case 0:
+              for (uint32_t n = Next () % 4 + 1; n > 0 && !data.empty (); --n)
+                {
+                  data[Next () % data.size ()] = Next ();
+                }
+              break;
+            case 1:
+              data.resize (Next () % (data.size () + 1));
+              break;
+            default:
+              for (uint32_t n = Next () % 8 + 1; n > 0; --n)
+                {
+                  data.push_back (Next ());
+                }
+              break;
+            }
+          Check (data);
+        }
+    }
+}
+
+/**
+ * Unit test for the packet copies of RouteInput.  The queue keeps a
+ * packet for this node as received and a relayed packet as one copy
+ * with its hop count decremented, and a duplicate is found before any
+ * copy is made.  The Enqueue and Duplicate traces pass the packet they
+ * see, which tells whether it is the received one.  With glibc, the heap
+ * allocations of each RouteInput call are counted as well.
+ */
+struct EpidemicRouteInputCopyTest : public TestCase
+{
+  EpidemicRouteInputCopyTest () : TestCase ("EpidemicRouteInputCopy"),
+                                  m_delivered (0),
+                                  m_allocations (0)
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Pass a data packet from 10.1.1.2 to RouteInput of the node.
+   * \param packetID the epidemic packet ID
+   * \param destination the IP destination of the packet
+   * \returns the packet passed to RouteInput
+   */
+  Ptr<Packet> Receive (uint32_t packetID, Ipv4Address destination);
+  void Unicast (Ptr<Ipv4Route> route,
+                Ptr<const Packet> packet, const Ipv4Header & header)
+  {
+  }
+  void Multicast (Ptr<Ipv4MulticastRoute> route,
+                  Ptr<const Packet> packet, const Ipv4Header & header)
+  {
+  }
+  void Local (Ptr<const Packet> packet, const Ipv4Header & header,
+              uint32_t iif)
+  {
+    m_delivered++;
+    m_local = packet;
+  }
+  void Error (Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno)
+  {
+  }
+  void Enqueued (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_enqueued = packet;
+  }
+  void Duplicated (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_duplicate = packet;
+  }
+  /// Routing protocol of the node
+  Ptr<Ipv4RoutingProtocol> m_routing;
+  /// Input device of the node
+  Ptr<NetDevice> m_device;
+  /// Number of packets delivered to the node
+  uint32_t m_delivered;
+  /// Last packet delivered to the node
+  Ptr<const Packet> m_local;
+  /// Last packet added to the queue
+  Ptr<const Packet> m_enqueued;
+  /// Last packet found in the queue
+  Ptr<const Packet> m_duplicate;
+  /// Heap allocations made by the last RouteInput call
+  uint64_t m_allocations;
+};
+
+Ptr<Packet>
+EpidemicRouteInputCopyTest::Receive (uint32_t packetID,
+                                     Ipv4Address destination)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  EpidemicHeader eHeader;
+  eHeader.SetPacketID (packetID);
+  eHeader.SetHopCount (10);
+  eHeader.SetTimeStamp (Simulator::Now ());
+  packet->AddHeader (eHeader);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.1.2"));
+  header.SetDestination (destination);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  m_local = 0;
+  m_enqueued = 0;
+  m_duplicate = 0;
+  // The callbacks allocate, so they are made before counting
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb =
+    MakeCallback (&EpidemicRouteInputCopyTest::Unicast, this);
+  Ipv4RoutingProtocol::MulticastForwardCallback mcb =
+    MakeCallback (&EpidemicRouteInputCopyTest::Multicast, this);
+  Ipv4RoutingProtocol::LocalDeliverCallback lcb =
+    MakeCallback (&EpidemicRouteInputCopyTest::Local, this);
+  Ipv4RoutingProtocol::ErrorCallback ecb =
+    MakeCallback (&EpidemicRouteInputCopyTest::Error, this);
+#ifdef __GLIBC__
+  AllocationCount count;
+  m_routing->RouteInput (packet, header, m_device, ucb, mcb, lcb, ecb);
+  m_allocations = count.Get ();
+#else
+  m_routing->RouteInput (packet, header, m_device, ucb, mcb, lcb, ecb);
+#endif
+  return packet;
+}
+
+void
+EpidemicRouteInputCopyTest::DoRun ()
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetChannel (CreateObject<SimpleChannel> ());
+  node->AddDevice (device);
+  EpidemicHelper epidemic;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (epidemic);
+  internet.Install (node);
+  Ipv4AddressGenerator::Reset ();
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (NetDeviceContainer (device));
+  m_routing = node->GetObject<Ipv4> ()->GetRoutingProtocol ();
+  m_device = device;
+  m_routing->TraceConnectWithoutContext (
+    "Enqueue", MakeCallback (&EpidemicRouteInputCopyTest::Enqueued, this));
+  m_routing->TraceConnectWithoutContext (
+    "Duplicate", MakeCallback (&EpidemicRouteInputCopyTest::Duplicated, this));
+  // Let the protocol start, before its first beacon
+  Simulator::Stop (Seconds (0.5));
+  Simulator::Run ();
+
+  Ipv4Address local ("10.1.1.1");
+  Ptr<Packet> packet = Receive (1, local);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered, 1, "Checking the delivered packet");
+  NS_TEST_EXPECT_MSG_EQ ((m_enqueued == packet), true,
+                         "Checking that the queue keeps the received packet");
+  NS_TEST_EXPECT_MSG_EQ ((m_local != packet), true,
+                         "Checking that the delivered packet is a copy");
+#ifdef __GLIBC__
+  // One clone of the packet to deliver and one node of the queue map
+  NS_TEST_EXPECT_MSG_EQ (m_allocations, 2,
+                         "Checking the allocations per received bundle");
+#endif
+  packet = Receive (1, local);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered, 1, "Checking a duplicate");
+  NS_TEST_EXPECT_MSG_EQ ((m_duplicate == packet), true,
+                         "Checking that a duplicate is not copied");
+#ifdef __GLIBC__
+  NS_TEST_EXPECT_MSG_EQ (m_allocations, 0,
+                         "Checking that a duplicate allocates nothing");
+  Receive (3, local);
+  NS_TEST_EXPECT_MSG_EQ (m_allocations, 2,
+                         "Checking that allocations do not grow per bundle");
+#endif
+
+  Ipv4Address remote ("10.1.1.9");
+  packet = Receive (2, remote);
+  NS_TEST_ASSERT_MSG_EQ ((m_enqueued != 0 && m_enqueued != packet), true,
+                         "Checking that a relayed packet is copied once");
+  EpidemicHeader eHeader;
+  m_enqueued->PeekHeader (eHeader);
+  NS_TEST_EXPECT_MSG_EQ (eHeader.GetHopCount (), 9,
+                         "Checking the hop count of the relayed copy");
+  packet->PeekHeader (eHeader);
+  NS_TEST_EXPECT_MSG_EQ (eHeader.GetHopCount (), 10,
+                         "Checking that the received packet is unchanged");
+  packet = Receive (2, remote);
+  NS_TEST_EXPECT_MSG_EQ ((m_enqueued == 0), true,
+                         "Checking that a relayed duplicate is not queued");
+  NS_TEST_EXPECT_MSG_EQ ((m_duplicate == packet), true,
+                         "Checking that a relayed duplicate is not copied");
+#ifdef __GLIBC__
+  NS_TEST_EXPECT_MSG_EQ (m_allocations, 0,
+                         "Checking that a relayed duplicate allocates nothing");
+#endif
+  m_routing = 0;
+  m_device = 0;
+  m_local = 0;
+  m_enqueued = 0;
+  m_duplicate = 0;
+  Simulator::Destroy ();
+}
+
+
+/**
+ * Base of the tests of two nodes, 10.1.1.1 and 10.1.1.2, on one
+ * channel.  Control messages go through the stack.  Data packets are
+ * handed by the forward callback of one node to RouteInput of the
+ * other, so that a test sees every packet forwarded.  The reception of
+ * either node can be cut.
+ */
+struct EpidemicPairTest : public TestCase
+{
+  EpidemicPairTest (std::string name) : TestCase (name)
+  {
+  }
+  /**
+   * Create the nodes.
+   * \param epidemic the helper of both routing protocols
+   */
+  void Setup (EpidemicHelper &epidemic);
+  /**
+   * Pass a data packet originated at a node to its RouteInput.
+   * \param node the index of the source
+   * \param destination the IP destination of the packet
+   * \param size the payload size
+   */
+  void Originate (uint32_t node, Ipv4Address destination, uint32_t size);
+  /**
+   * \param address an address
+   * \returns the index of the node with the address, 2 if none
+   */
+  uint32_t GetIndex (Ipv4Address address) const;
+  /**
+   * Cut or restore the reception of a node.
+   * \param node the index of the node
+   * \param up whether the node receives
+   */
+  void SetReceiving (uint32_t node, bool up);
+  /// Release the nodes and destroy the simulator
+  void Release ();
+  void Forward (Ptr<Ipv4Route> route,
+                Ptr<const Packet> packet, const Ipv4Header & header);
+  /**
+   * Pass a forwarded packet to RouteInput of a node.
+   * \param node the index of the node
+   * \param packet the packet
+   * \param header the IP header of the packet
+   */
+  void Receive (uint32_t node, Ptr<const Packet> packet, Ipv4Header header);
+  void Multicast (Ptr<Ipv4MulticastRoute> route,
+                  Ptr<const Packet> packet, const Ipv4Header & header)
+  {
+  }
+  void Local (Ptr<const Packet> packet, const Ipv4Header & header,
+              uint32_t iif)
+  {
+    uint32_t node = GetIndex (header.GetDestination ());
+    if (node < 2)
+      {
+        m_delivered[node]++;
+      }
+  }
+  void Error (Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno)
+  {
+  }
+  /// Routing protocols of the nodes
+  Ptr<Ipv4RoutingProtocol> m_routing[2];
+  /// Devices of the nodes
+  Ptr<SimpleNetDevice> m_devices[2];
+  /// Error models dropping the frames received by the nodes
+  Ptr<RateErrorModel> m_errors[2];
+  /// Addresses of the nodes
+  Ipv4Address m_addresses[2];
+  /// IDs of the data packets forwarded by each node
+  std::vector<uint32_t> m_forwarded[2];
+  /// Copy budgets of the data packets forwarded by each node, 0 if none
+  std::vector<uint32_t> m_copies[2];
+  /// Routes of the data packets forwarded by each node
+  std::vector<Ptr<Ipv4Route> > m_routes[2];
+  /// Number of data packets delivered by RouteInput to each node
+  uint32_t m_delivered[2];
+  /// Whether each node receives
+  bool m_receiving[2];
+};
+
+void
+EpidemicPairTest::Setup (EpidemicHelper &epidemic)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      m_devices[i] = CreateObject<SimpleNetDevice> ();
+      m_devices[i]->SetAddress (Mac48Address::Allocate ());
+      m_devices[i]->SetChannel (channel);
+      m_errors[i] = CreateObject<RateErrorModel> ();
+      m_errors[i]->SetRate (1);
+      m_errors[i]->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+      m_errors[i]->Disable ();
+      m_devices[i]->SetReceiveErrorModel (m_errors[i]);
+      nodes.Get (i)->AddDevice (m_devices[i]);
+      devices.Add (m_devices[i]);
+    }
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (epidemic);
+  internet.Install (nodes);
+  Ipv4AddressGenerator::Reset ();
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      m_routing[i] = nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ();
+      m_addresses[i] = interfaces.GetAddress (i);
+      m_forwarded[i].clear ();
+      m_copies[i].clear ();
+      m_routes[i].clear ();
+      m_delivered[i] = 0;
+      m_receiving[i] = true;
+    }
+}
+
+void
+EpidemicPairTest::Originate (uint32_t node, Ipv4Address destination,
+                             uint32_t size)
+{
+  Ipv4Header header;
+  header.SetSource (m_addresses[node]);
+  header.SetDestination (destination);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  header.SetPayloadSize (size);
+  m_routing[node]->RouteInput (Create<Packet> (size), header, m_devices[node],
+                               MakeCallback (&EpidemicPairTest::Forward, this),
+                               MakeCallback (&EpidemicPairTest::Multicast, this),
+                               MakeCallback (&EpidemicPairTest::Local, this),
+                               MakeCallback (&EpidemicPairTest::Error, this));
+}
+
+uint32_t
+EpidemicPairTest::GetIndex (Ipv4Address address) const
+{
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      if (m_addresses[i] == address)
+        {
+          return i;
+        }
+    }
+  return 2;
+}
+
+void
+EpidemicPairTest::SetReceiving (uint32_t node, bool up)
+{
+  m_receiving[node] = up;
+  if (up)
+    {
+      m_errors[node]->Disable ();
+    }
+  else
+    {
+      m_errors[node]->Enable ();
+    }
+}
+
+void
+EpidemicPairTest::Release ()
+{
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      m_routing[i] = 0;
+      m_devices[i] = 0;
+      m_errors[i] = 0;
+      m_routes[i].clear ();
+    }
+  Simulator::Destroy ();
+}
+
+void
+EpidemicPairTest::Forward (Ptr<Ipv4Route> route,
+                           Ptr<const Packet> packet, const Ipv4Header & header)
+{
+  uint32_t from = GetIndex (route->GetSource ());
+  uint32_t to = GetIndex (route->GetGateway ());
+  if (from == 2 || to == 2)
+    {
+      return;
+    }
+  EpidemicHeader eHeader;
+  packet->PeekHeader (eHeader);
+  m_forwarded[from].push_back (eHeader.GetPacketID ());
+  m_copies[from].push_back (eHeader.HasCopies () ? eHeader.GetCopies () : 0);
+  m_routes[from].push_back (route);
+  if (m_receiving[to])
+    {
+      // Received after the sender has returned, as from the channel
+      Simulator::ScheduleNow (&EpidemicPairTest::Receive, this, to,
+                              packet, header);
+    }
+}
+
+void
+EpidemicPairTest::Receive (uint32_t node, Ptr<const Packet> packet,
+                           Ipv4Header header)
+{
+  m_routing[node]->RouteInput (packet, header, m_devices[node],
+                               MakeCallback (&EpidemicPairTest::Forward, this),
+                               MakeCallback (&EpidemicPairTest::Multicast, this),
+                               MakeCallback (&EpidemicPairTest::Local, this),
+                               MakeCallback (&EpidemicPairTest::Error, this));
+}
+
+/**
+ * Test of the reception of AGGREGATE messages.  The bundles of the
+ * first session are delivered with the IP header of a data packet, or
+ * relayed.
+ */
+struct EpidemicAggregateTest : public EpidemicPairTest
+{
+  EpidemicAggregateTest () : EpidemicPairTest ("EpidemicAggregate")
+  {
+  }
+  virtual void DoRun ();
+  void Delivered (Ptr<const Packet> packet, const Ipv4Header &header)
+  {
+    m_localSizes.push_back (packet->GetSize ());
+    m_localHeaders.push_back (header);
+  }
+  void Enqueued (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_enqueued.push_back (packetID);
+  }
+  /// Sizes of the packets delivered to the receiver
+  std::vector<uint32_t> m_localSizes;
+  /// IP headers of the packets delivered to the receiver
+  std::vector<Ipv4Header> m_localHeaders;
+  /// IDs of the packets queued by the receiver
+  std::vector<uint32_t> m_enqueued;
+};
+
+void
+EpidemicAggregateTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("Aggregation", BooleanValue (true));
+  Setup (epidemic);
+  m_routing[1]->TraceConnectWithoutContext (
+    "LocalDeliver", MakeCallback (&EpidemicAggregateTest::Delivered, this));
+  m_routing[1]->TraceConnectWithoutContext (
+    "Enqueue", MakeCallback (&EpidemicAggregateTest::Enqueued, this));
+  // Both packets wait for the first session, at the first beacon
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       Ipv4Address ("10.1.1.9"), 200);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[0].size (), 0,
+                         "Checking that the packets are aggregated");
+  NS_TEST_ASSERT_MSG_EQ (m_localHeaders.size (), 1,
+                         "Checking the delivered bundle");
+  NS_TEST_EXPECT_MSG_EQ (m_localSizes[0], 100,
+                         "Checking the size of the delivered bundle");
+  NS_TEST_EXPECT_MSG_EQ (m_localHeaders[0].GetSource (), m_addresses[0],
+                         "Checking the source of the delivered bundle");
+  NS_TEST_EXPECT_MSG_EQ (m_localHeaders[0].GetPayloadSize (),
+                         100 + EpidemicHeader ().GetSerializedSize (),
+                         "Checking the payload size of the delivered bundle");
+  // IDs are the low 16 bits of the source and a counter
+  uint32_t local = 0x01010001;
+  uint32_t relayed = 0x01010002;
+  NS_TEST_EXPECT_MSG_EQ ((std::find (m_enqueued.begin (), m_enqueued.end (),
+                                     relayed) != m_enqueued.end ()), true,
+                         "Checking the relayed bundle");
+  NS_TEST_EXPECT_MSG_EQ ((std::find (m_enqueued.begin (), m_enqueued.end (),
+                                     local) != m_enqueued.end ()), true,
+                         "Checking that the delivered bundle is stored");
+  Release ();
+}
+
+/**
+ * Test of chunked bundles.  A bundle is split into chunks forwarded one
+ * by one and delivered once.  A bundle that needs more than 65535
+ * chunks, or whose chunks would take the ID of a queued packet once the
+ * packet counter wraps, is dropped.
+ */
+struct EpidemicChunkTest : public EpidemicPairTest
+{
+  EpidemicChunkTest ()
+    : EpidemicPairTest ("EpidemicChunk")
+  {
+  }
+  virtual void DoRun ();
+  /// Check the chunk descriptor of the header
+  void CheckHeader ();
+  /// Check the reassembly of the bundles in the queue
+  void CheckReassembly ();
+  /// Take the packet counter of the source up to 0xFFFF
+  void WrapCounter ();
+  /// IDs of the packets queued by the source
+  std::vector<uint32_t> m_enqueued;
+  void Enqueued (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_enqueued.push_back (packetID);
+  }
+};
+
+void
+EpidemicChunkTest::CheckHeader ()
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  EpidemicHeader chunk1;
+  chunk1.SetPacketID (0x0001FFFF);
+  chunk1.SetHopCount (10);
+  chunk1.SetChunk (0x0001FFFE, 1, 3);
+  packet->AddHeader (chunk1);
+  EpidemicHeader chunk2;
+  packet->RemoveHeader (chunk2);
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetSerializedSize (),24,
+                         "Checking chunk header size");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.IsChunk (),true, "Checking chunk flag");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetHopCount (),10,
+                         "Checking that flags do not change the hop count");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetBundleID (),0x0001FFFE,
+                         "Checking bundle ID");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetChunkIndex (),1, "Checking chunk index");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetChunkCount (),3, "Checking chunk count");
+  NS_TEST_ASSERT_MSG_EQ (chunk2.GetChunkPacketID (2),0x00010000,
+                         "Checking that chunk IDs wrap within the host part");
+
+  // An index past the count does not describe a chunk
+  chunk1.SetChunk (0x0001FFFE, 3, 3);
+  packet->AddHeader (chunk1);
+  packet->RemoveHeader (chunk2);
+  NS_TEST_EXPECT_MSG_EQ (chunk2.IsValid (), false,
+                         "Checking that a chunk past the count is rejected");
+}
+
+void
+EpidemicChunkTest::CheckReassembly ()
+{
+  PacketQueue q (64);
+  Ipv4Header h;
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb =
+    MakeCallback (&EpidemicPairTest::Forward, this);
+  Ipv4RoutingProtocol::ErrorCallback ecb =
+    MakeCallback (&EpidemicPairTest::Error, this);
+  EpidemicHeader chunkHeader;
+  chunkHeader.SetPacketID (0x00050001);
+  chunkHeader.SetChunk (0x00050001, 0, 2);
+  Ptr<Packet> chunk0 = Create<Packet> (100);
+  chunk0->AddHeader (chunkHeader);
+  QueueEntry c0 (chunk0, h, ucb, ecb, Seconds (1), 0x00050001);
+  q.Enqueue (c0);
+  NS_TEST_EXPECT_MSG_EQ ((q.ReassembleBundle (chunkHeader) == 0), true,
+                         "Checking that an incomplete bundle is not rebuilt");
+  chunkHeader.SetPacketID (0x00050002);
+  chunkHeader.SetChunk (0x00050001, 1, 2);
+  Ptr<Packet> chunk1 = Create<Packet> (50);
+  chunk1->AddHeader (chunkHeader);
+  QueueEntry c1 (chunk1, h, ucb, ecb, Seconds (1), 0x00050002);
+  q.Enqueue (c1);
+  Ptr<Packet> bundle = q.ReassembleBundle (chunkHeader);
+  NS_TEST_ASSERT_MSG_EQ ((bundle != 0), true,
+                         "Checking that a complete bundle is rebuilt");
+  NS_TEST_EXPECT_MSG_EQ (bundle->GetSize (), 150,
+                         "Checking the size of the rebuilt bundle");
+}
+
+void
+EpidemicChunkTest::WrapCounter ()
+{
+  // Bundles of 65536 chunks are dropped, their IDs are not reused
+  for (uint32_t i = 0x0002; i <= 0xFFFF; ++i)
+    {
+      Originate (0, m_addresses[1], 0x10000);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued.size (), 1,
+                         "Checking that the oversized bundles are dropped");
+}
+
+void
+EpidemicChunkTest::DoRun ()
+{
+  CheckHeader ();
+  CheckReassembly ();
+
+  // 250 bytes in chunks of 100 bytes
+  EpidemicHelper epidemic;
+  epidemic.Set ("ChunkSize", UintegerValue (100));
+  Setup (epidemic);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 250);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[0].size (), 3,
+                         "Checking that the chunks are forwarded");
+  for (uint32_t id = 0x01010001; id <= 0x01010003; ++id)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((std::find (m_forwarded[0].begin (),
+                                         m_forwarded[0].end (), id)
+                              != m_forwarded[0].end ()), true,
+                             "Checking the consecutive chunk IDs");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1,
+                         "Checking that the bundle is delivered once");
+  Release ();
+
+  // One byte chunks, all before the first session
+  epidemic.Set ("ChunkSize", UintegerValue (1));
+  Setup (epidemic);
+  m_enqueued.clear ();
+  m_routing[0]->TraceConnectWithoutContext (
+    "Enqueue", MakeCallback (&EpidemicChunkTest::Enqueued, this));
+  // Packet 0x01010001 is small enough to be queued whole
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 1);
+  Simulator::Schedule (Seconds (0.6), &EpidemicChunkTest::WrapCounter, this);
+  // The first two bundles would take 0x01010001, the third one is queued
+  Simulator::Schedule (Seconds (0.7), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 2);
+  Simulator::Schedule (Seconds (0.7), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 2);
+  Simulator::Schedule (Seconds (0.7), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 2);
+  Simulator::Stop (Seconds (0.9));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_enqueued.size (), 3,
+                         "Checking that the bundles on queued IDs are dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[0], 0x01010001,
+                         "Checking the packet queued whole");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[1], 0x01010002,
+                         "Checking the first chunk past the queued IDs");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[2], 0x01010003,
+                         "Checking the second chunk past the queued IDs");
+  Release ();
+}
+
+/**
+ * Test of Spray-and-Wait.  A packet with a budget of four copies is
+ * handed to the peer with half of it.  With a single copy, a packet is
+ * only handed to its destination.
+ */
+struct EpidemicSprayTest : public EpidemicPairTest
+{
+  EpidemicSprayTest ()
+    : EpidemicPairTest ("EpidemicSpray")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicSprayTest::DoRun ()
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  EpidemicHeader spray1;
+  spray1.SetPacketID (0x00010003);
+  spray1.SetHopCount (10);
+  spray1.SetCopies (5);
+  packet->AddHeader (spray1);
+  EpidemicHeader spray2;
+  packet->RemoveHeader (spray2);
+  NS_TEST_ASSERT_MSG_EQ (spray2.GetSerializedSize (),20,
+                         "Checking copy budget header size");
+  NS_TEST_ASSERT_MSG_EQ (spray2.HasCopies (),true, "Checking copies flag");
+  NS_TEST_ASSERT_MSG_EQ (spray2.GetCopies (),5, "Checking copy budget");
+  NS_TEST_ASSERT_MSG_EQ (spray2.GetHopCount (),10,
+                         "Checking that the copies flag keeps the hop count");
+
+  EpidemicHelper epidemic;
+  epidemic.Set ("ForwardingMode", StringValue ("SprayAndWait"));
+  epidemic.Set ("SprayCopies", UintegerValue (4));
+  Setup (epidemic);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       Ipv4Address ("10.1.1.9"), 100);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_copies[0].size (), 1,
+                         "Checking the packet handed in the spray phase");
+  NS_TEST_EXPECT_MSG_EQ (m_copies[0][0], 2,
+                         "Checking that the peer gets half of the copies");
+  Release ();
+
+  epidemic.Set ("SprayCopies", UintegerValue (1));
+  Setup (epidemic);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       Ipv4Address ("10.1.1.9"), 100);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_forwarded[0].size (), 1,
+                         "Checking the packet handed in the wait phase");
+  // IDs are the low 16 bits of the source and a counter
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[0][0], 0x01010002,
+                         "Checking that only the destination gets a copy");
+  NS_TEST_EXPECT_MSG_EQ (m_copies[0][0], 1,
+                         "Checking that a single copy is not split");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1,
+                         "Checking the delivery in the wait phase");
+  Release ();
+}
+
+/**
+ * Test of the trace sources of the routing protocol in a session between
+ * two nodes.  A packet delivered again at the destination is traced as a
+ * duplicate.  Aggregated packets are traced as forwarded.
+ */
+struct EpidemicTraceTest : public EpidemicPairTest
+{
+  EpidemicTraceTest ()
+    : EpidemicPairTest ("EpidemicTrace")
+  {
+  }
+  virtual void DoRun ();
+  /// Connect the sinks to the trace sources of the nodes
+  void Connect ();
+  /// Pass the packet forwarded by the source to the destination again
+  void Resend ();
+  void Forwarded (Ptr<const Packet> packet, uint32_t packetID,
+                  Ipv4Address peer)
+  {
+    m_packet = packet;
+    m_traceForwarded.push_back (packetID);
+    m_peers.push_back (peer);
+  }
+  void Delivered (Ptr<const Packet> packet, const Ipv4Header &header)
+  {
+    m_sources.push_back (header.GetSource ());
+  }
+  void Duplicated (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_duplicated.push_back (packetID);
+  }
+  void BeaconSent (Ptr<const Packet> packet, Ipv4Address local)
+  {
+    m_beaconsSent++;
+  }
+  void BeaconReceived (Ptr<const Packet> packet, Ipv4Address sender)
+  {
+    m_beaconSenders.push_back (sender);
+  }
+  void SessionStarted (Ipv4Address peer)
+  {
+    m_started.push_back (peer);
+  }
+  void SessionEnded (Ipv4Address peer, bool complete)
+  {
+    m_ended.push_back (peer);
+    m_complete.push_back (complete);
+  }
+  /// Last data packet traced as forwarded by the source
+  Ptr<const Packet> m_packet;
+  /// IDs of the packets traced as forwarded by the source
+  std::vector<uint32_t> m_traceForwarded;
+  /// Peers of the packets traced as forwarded by the source
+  std::vector<Ipv4Address> m_peers;
+  /// Sources of the packets traced as delivered to the destination
+  std::vector<Ipv4Address> m_sources;
+  /// IDs of the packets traced as duplicates by the destination
+  std::vector<uint32_t> m_duplicated;
+  /// Number of beacons sent by the source
+  uint32_t m_beaconsSent;
+  /// Senders of the beacons received by the destination
+  std::vector<Ipv4Address> m_beaconSenders;
+  /// Peers of the sessions started by the source
+  std::vector<Ipv4Address> m_started;
+  /// Peers of the sessions ended by the source
+  std::vector<Ipv4Address> m_ended;
+  /// Whether each session ended by the source was complete
+  std::vector<bool> m_complete;
+};
+
+void
+EpidemicTraceTest::Connect ()
+{
+  m_packet = 0;
+  m_traceForwarded.clear ();
+  m_peers.clear ();
+  m_sources.clear ();
+  m_duplicated.clear ();
+  m_beaconsSent = 0;
+  m_beaconSenders.clear ();
+  m_started.clear ();
+  m_ended.clear ();
+  m_complete.clear ();
+  m_routing[0]->TraceConnectWithoutContext (
+    "Forward", MakeCallback (&EpidemicTraceTest::Forwarded, this));
+  m_routing[1]->TraceConnectWithoutContext (
+    "LocalDeliver", MakeCallback (&EpidemicTraceTest::Delivered, this));
+  m_routing[1]->TraceConnectWithoutContext (
+    "Duplicate", MakeCallback (&EpidemicTraceTest::Duplicated, this));
+  m_routing[0]->TraceConnectWithoutContext (
+    "BeaconTx", MakeCallback (&EpidemicTraceTest::BeaconSent, this));
+  m_routing[1]->TraceConnectWithoutContext (
+    "BeaconRx", MakeCallback (&EpidemicTraceTest::BeaconReceived, this));
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionStart", MakeCallback (&EpidemicTraceTest::SessionStarted, this));
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionEnd", MakeCallback (&EpidemicTraceTest::SessionEnded, this));
+}
+
+void
+EpidemicTraceTest::Resend ()
+{
+  NS_TEST_ASSERT_MSG_EQ ((m_packet != 0), true,
+                         "Checking the packet traced as forwarded");
+  Ipv4Header header;
+  header.SetSource (m_addresses[0]);
+  header.SetDestination (m_addresses[1]);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  header.SetPayloadSize (m_packet->GetSize ());
+  Receive (1, m_packet, header);
+}
+
+void
+EpidemicTraceTest::DoRun ()
+{
+  // Delivered packets are only recorded in the window
+  EpidemicHelper epidemic;
+  epidemic.Set ("DeliveredWindow", UintegerValue (64));
+  Setup (epidemic);
+  Connect ();
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Schedule (Seconds (2), &EpidemicTraceTest::Resend, this);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ ((m_beaconsSent > 0), true,
+                         "Checking the beacon transmission trace");
+  NS_TEST_ASSERT_MSG_EQ ((m_beaconSenders.size () > 0), true,
+                         "Checking the beacon reception trace");
+  NS_TEST_EXPECT_MSG_EQ (m_beaconSenders[0], m_addresses[0],
+                         "Checking the sender of the received beacon");
+  NS_TEST_ASSERT_MSG_EQ (m_started.size (), 1,
+                         "Checking the session start trace");
+  NS_TEST_EXPECT_MSG_EQ (m_started[0], m_addresses[1],
+                         "Checking the peer of the started session");
+  NS_TEST_ASSERT_MSG_EQ (m_ended.size (), 1, "Checking the session end trace");
+  NS_TEST_EXPECT_MSG_EQ (m_ended[0], m_addresses[1],
+                         "Checking the peer of the ended session");
+  NS_TEST_EXPECT_MSG_EQ (m_complete[0], true,
+                         "Checking that the session is complete");
+  NS_TEST_ASSERT_MSG_EQ (m_traceForwarded.size (), 1,
+                         "Checking the forward trace");
+  NS_TEST_EXPECT_MSG_EQ (m_traceForwarded[0], 0x01010001,
+                         "Checking the ID of the forwarded packet");
+  NS_TEST_EXPECT_MSG_EQ (m_peers[0], m_addresses[1],
+                         "Checking the peer of the forwarded packet");
+  NS_TEST_ASSERT_MSG_EQ (m_sources.size (), 1,
+                         "Checking the local delivery trace");
+  NS_TEST_EXPECT_MSG_EQ (m_sources[0], m_addresses[0],
+                         "Checking the source of the delivered packet");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1,
+                         "Checking that the packet is delivered once");
+  NS_TEST_ASSERT_MSG_EQ (m_duplicated.size (), 1,
+                         "Checking the duplicate trace of the window");
+  NS_TEST_EXPECT_MSG_EQ (m_duplicated[0], 0x01010001,
+                         "Checking the ID of the duplicate");
+  Release ();
+
+  // Bundles are traced when their AGGREGATE message is sent
+  epidemic.Set ("Aggregation", BooleanValue (true));
+  Setup (epidemic);
+  Connect ();
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       Ipv4Address ("10.1.1.9"), 200);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[0].size (), 0,
+                         "Checking that the packets are aggregated");
+  NS_TEST_ASSERT_MSG_EQ (m_traceForwarded.size (), 2,
+                         "Checking the forward trace of the bundles");
+  for (uint32_t id = 0x01010001; id <= 0x01010002; ++id)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((std::find (m_traceForwarded.begin (),
+                                         m_traceForwarded.end (), id)
+                              != m_traceForwarded.end ()), true,
+                             "Checking the IDs of the forwarded bundles");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_sources.size (), 1,
+                         "Checking the local delivery trace of a bundle");
+  Release ();
+}
+
+/**
+ * Test of overheard frames.  With PassiveDiscovery, a control frame
+ * overheard from a neighbor starts a session as its beacon would, while
+ * a data frame from an unknown link address does not.  With
+ * OverhearBundles, an overheard data packet addressed to another node is
+ * stored.
+ */
+struct EpidemicOverhearTest : public EpidemicPairTest
+{
+  EpidemicOverhearTest ()
+    : EpidemicPairTest ("EpidemicOverhear")
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Pass a frame sent to another host to the device of node 1.
+   * \param from the link-layer source of the frame
+   * \param source the IP source of the packet
+   * \param destination the IP destination of the packet
+   * \param packetID the packet ID of the data packet, 0 for a control
+   *  packet
+   */
+  void Overhear (Mac48Address from, Ipv4Address source,
+                 Ipv4Address destination, uint32_t packetID);
+  void Enqueued (Ptr<const Packet> packet, uint32_t packetID)
+  {
+    m_enqueued.push_back (packetID);
+  }
+  void SessionStarted (Ipv4Address peer)
+  {
+    m_started.push_back (peer);
+    m_startTimes.push_back (Simulator::Now ());
+  }
+  /// IDs of the packets queued by node 1
+  std::vector<uint32_t> m_enqueued;
+  /// Peers of the sessions started by node 1
+  std::vector<Ipv4Address> m_started;
+  /// Start times of the sessions started by node 1
+  std::vector<Time> m_startTimes;
+};
+
+void
+EpidemicOverhearTest::Overhear (Mac48Address from, Ipv4Address source,
+                                Ipv4Address destination, uint32_t packetID)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  if (packetID == 0)
+    {
+      packet->AddPacketTag (ControlTag (ControlTag::CONTROL));
+    }
+  else
+    {
+      EpidemicHeader eHeader;
+      eHeader.SetPacketID (packetID);
+      eHeader.SetHopCount (10);
+      eHeader.SetTimeStamp (Simulator::Now ());
+      packet->AddHeader (eHeader);
+    }
+  Ipv4Header header;
+  header.SetSource (source);
+  header.SetDestination (destination);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  header.SetPayloadSize (packet->GetSize ());
+  packet->AddHeader (header);
+  m_devices[1]->Receive (packet, Ipv4L3Protocol::PROT_NUMBER,
+                         Mac48Address::Allocate (), from);
+}
+
+void
+EpidemicOverhearTest::DoRun ()
+{
+  Ipv4Address neighbor ("10.1.1.5");
+  Mac48Address link = Mac48Address::Allocate ();
+
+  EpidemicHelper discovery;
+  discovery.Set ("PassiveDiscovery", BooleanValue (true));
+  Setup (discovery);
+  m_started.clear ();
+  m_startTimes.clear ();
+  m_routing[1]->TraceConnectWithoutContext (
+    "SessionStart", MakeCallback (&EpidemicOverhearTest::SessionStarted, this));
+  // The link address of the neighbor is only learnt from its control frame
+  Simulator::Schedule (Seconds (1.5), &EpidemicOverhearTest::Overhear, this,
+                       link, neighbor, Ipv4Address ("10.1.1.9"), 0x0105002A);
+  Simulator::Schedule (Seconds (2), &EpidemicOverhearTest::Overhear, this,
+                       link, neighbor, Ipv4Address ("10.1.1.9"), 0);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_started.size (), 1,
+                         "Checking that an overheard neighbor is discovered");
+  NS_TEST_EXPECT_MSG_EQ (m_started[0], neighbor,
+                         "Checking the peer of the session");
+  NS_TEST_EXPECT_MSG_EQ ((m_startTimes[0] >= Seconds (2)), true,
+                         "Checking that the data frame is not a beacon");
+  Release ();
+
+  EpidemicHelper overhearing;
+  overhearing.Set ("OverhearBundles", BooleanValue (true));
+  Setup (overhearing);
+  m_enqueued.clear ();
+  m_routing[1]->TraceConnectWithoutContext (
+    "Enqueue", MakeCallback (&EpidemicOverhearTest::Enqueued, this));
+  // Once beacons have passed RouteInput, which keeps its callbacks
+  Simulator::Schedule (Seconds (2), &EpidemicOverhearTest::Overhear, this,
+                       link, neighbor, Ipv4Address ("10.1.1.9"), 0x0105002A);
+  Simulator::Schedule (Seconds (2), &EpidemicOverhearTest::Overhear, this,
+                       link, neighbor, m_addresses[1], 0x0105002B);
+  Simulator::Schedule (Seconds (2), &EpidemicOverhearTest::Overhear, this,
+                       link, neighbor, Ipv4Address ("10.1.1.9"), 0);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_enqueued.size (), 1,
+                         "Checking that one overheard packet is stored");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued[0], 0x0105002A,
+                         "Checking the packet addressed to another node");
+  Release ();
+}
+
+/**
+ * Test of link-layer beacons.  The BeaconHeader carries the IP address
+ * of the sender.  Beacons sent as raw frames are received by the peer,
+ * which starts a session as with UDP beacons.
+ */
+struct EpidemicLinkLayerBeaconTest : public EpidemicPairTest
+{
+  EpidemicLinkLayerBeaconTest ()
+    : EpidemicPairTest ("EpidemicLinkLayerBeacon")
+  {
+  }
+  virtual void DoRun ();
+  /// Check the serialization of the header
+  void CheckHeader ();
+  void BeaconReceived (Ptr<const Packet> packet, Ipv4Address sender)
+  {
+    m_beaconSenders.push_back (sender);
+  }
+  void SessionStarted (Ipv4Address peer)
+  {
+    m_started.push_back (peer);
+  }
+  /// Senders of the beacons received by node 1
+  std::vector<Ipv4Address> m_beaconSenders;
+  /// Peers of the sessions started by node 0
+  std::vector<Ipv4Address> m_started;
+};
+
+void
+EpidemicLinkLayerBeaconTest::CheckHeader ()
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  BeaconHeader beacon1 (Ipv4Address ("10.1.1.7"));
+  packet->AddHeader (beacon1);
+  BeaconHeader beacon2;
+  packet->RemoveHeader (beacon2);
+  NS_TEST_ASSERT_MSG_EQ (beacon2.GetSerializedSize (),4,
+                         "Checking beacon header size");
+  NS_TEST_ASSERT_MSG_EQ (beacon2.IsValid (), true, "Checking a beacon");
+  NS_TEST_ASSERT_MSG_EQ (beacon2.GetSender (),Ipv4Address ("10.1.1.7"),
+                         "Checking beacon sender");
+
+  // A frame cut short does not carry a whole address
+  Ptr<Packet> truncated = Create<Packet> (3);
+  BeaconHeader beacon3;
+  truncated->RemoveHeader (beacon3);
+  NS_TEST_EXPECT_MSG_EQ (beacon3.IsValid (), false,
+                         "Checking that a truncated beacon is rejected");
+}
+
+void
+EpidemicLinkLayerBeaconTest::DoRun ()
+{
+  CheckHeader ();
+
+  EpidemicHelper epidemic;
+  epidemic.Set ("LinkLayerBeacons", BooleanValue (true));
+  Setup (epidemic);
+  m_routing[1]->TraceConnectWithoutContext (
+    "BeaconRx",
+    MakeCallback (&EpidemicLinkLayerBeaconTest::BeaconReceived, this));
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionStart",
+    MakeCallback (&EpidemicLinkLayerBeaconTest::SessionStarted, this));
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ ((m_beaconSenders.size () > 0), true,
+                         "Checking that link-layer beacons are received");
+  NS_TEST_EXPECT_MSG_EQ (m_beaconSenders[0], m_addresses[0],
+                         "Checking the sender of the beacon");
+  NS_TEST_ASSERT_MSG_EQ (m_started.size (), 1,
+                         "Checking the session started by a beacon");
+  NS_TEST_EXPECT_MSG_EQ (m_started[0], m_addresses[1],
+                         "Checking the peer of the session");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1,
+                         "Checking the delivery in the session");
+  Release ();
+}
+
+/**
+ * Test of the routes cached for neighbors.  The packets of a session
+ * share a route, a neighbor met again after HostRecentPeriod gets a new
+ * one.
+ */
+struct EpidemicNeighborRouteTest : public EpidemicPairTest
+{
+  EpidemicNeighborRouteTest ()
+    : EpidemicPairTest ("EpidemicNeighborRoute")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicNeighborRouteTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  Setup (epidemic);
+  // Two packets for the first session, one for the session after the
+  // route of the first has timed out
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Schedule (Seconds (15), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_routes[0].size (), 3,
+                         "Checking the forwarded packets");
+  NS_TEST_EXPECT_MSG_EQ ((m_routes[0][0] == m_routes[0][1]), true,
+                         "Checking that a session reuses its route");
+  NS_TEST_EXPECT_MSG_EQ ((m_routes[0][1] != m_routes[0][2]), true,
+                         "Checking that the route of a gone neighbor is dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_routes[0][2]->GetGateway (), m_addresses[1],
+                         "Checking the gateway of the new route");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 3, "Checking the delivered packets");
+  Release ();
+}
+
+/**
+ * Test of RouteOutput.  A data packet is looped back to be queued by
+ * RouteInput, a control packet leaves through the device on the subnet
+ * of its peer, and a packet for a local address gets no gateway.  The
+ * local addresses follow the interfaces that go down.
+ */
+struct EpidemicRouteOutputTest : public EpidemicPairTest
+{
+  EpidemicRouteOutputTest ()
+    : EpidemicPairTest ("EpidemicRouteOutput")
+  {
+  }
+  virtual void DoRun ();
+  /// Check the routes of node 0
+  void CheckRoutes ();
+  /**
+   * \param destination the IP destination of the packet
+   * \param control whether the packet is an epidemic control packet
+   * \returns the route of node 0 for a packet
+   */
+  Ptr<Ipv4Route> GetRoute (Ipv4Address destination, bool control);
+};
+
+Ptr<Ipv4Route>
+EpidemicRouteOutputTest::GetRoute (Ipv4Address destination, bool control)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+  if (control)
+    {
+      packet->AddPacketTag (ControlTag (ControlTag::CONTROL));
+    }
+  Ipv4Header header;
+  header.SetSource (m_addresses[0]);
+  header.SetDestination (destination);
+  Socket::SocketErrno sockerr = Socket::ERROR_NOTERROR;
+  return m_routing[0]->RouteOutput (packet, header, 0, sockerr);
+}
+
+void
+EpidemicRouteOutputTest::CheckRoutes ()
+{
+  Ptr<Ipv4Route> data = GetRoute (m_addresses[1], false);
+  NS_TEST_EXPECT_MSG_EQ (data->GetGateway (), m_addresses[1],
+                         "Checking the gateway of a data packet");
+  NS_TEST_EXPECT_MSG_EQ ((DynamicCast<LoopbackNetDevice> (
+                            data->GetOutputDevice ()) != 0), true,
+                         "Checking that a data packet is looped back");
+
+  Ptr<Ipv4Route> control = GetRoute (m_addresses[1], true);
+  NS_TEST_EXPECT_MSG_EQ (control->GetGateway (), m_addresses[1],
+                         "Checking the gateway of a control packet");
+  NS_TEST_EXPECT_MSG_EQ (control->GetOutputDevice (), m_devices[0],
+                         "Checking the device on the subnet of the peer");
+
+  Ptr<Ipv4Route> local = GetRoute (m_addresses[0], false);
+  NS_TEST_EXPECT_MSG_EQ (local->GetGateway (), Ipv4Address (),
+                         "Checking that a local address has no gateway");
+  NS_TEST_EXPECT_MSG_EQ ((local->GetOutputDevice () == 0), true,
+                         "Checking that a local address has no device");
+
+  // The address is no longer an epidemic address once its interface is down
+  Ptr<Ipv4> ipv4 = m_devices[0]->GetNode ()->GetObject<Ipv4> ();
+  ipv4->SetDown (ipv4->GetInterfaceForDevice (m_devices[0]));
+  Ptr<Ipv4Route> down = GetRoute (m_addresses[0], false);
+  NS_TEST_EXPECT_MSG_EQ (down->GetGateway (), m_addresses[0],
+                         "Checking the local addresses after an interface change");
+}
+
+void
+EpidemicRouteOutputTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  Setup (epidemic);
+  Simulator::Schedule (Seconds (0.5), &EpidemicRouteOutputTest::CheckRoutes,
+                       this);
+  Simulator::Stop (Seconds (0.6));
+  Simulator::Run ();
+  Release ();
+}
+
+/**
+ * Test of the PRoPHET encounters counted in a session.  The REPLY_BACK
+ * of node 1 is lost, so node 0 retransmits its REPLY.  The
+ * retransmission does not raise the predictability node 1 has for
+ * node 0, which both of its REPLY_BACKs carry.
+ */
+struct EpidemicProphetSessionTest : public EpidemicPairTest
+{
+  EpidemicProphetSessionTest ()
+    : EpidemicPairTest ("EpidemicProphetSession")
+  {
+  }
+  virtual void DoRun ();
+  void Started (Ipv4Address peer)
+  {
+    SetReceiving (0, false);
+    // Before the retransmission after SessionTimeout
+    Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::SetReceiving,
+                         this, 0, true);
+  }
+  /// Read the predictability of node 0 from the REPLY_BACKs of node 1
+  void Sent (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /// Predictabilities of node 0 sent by node 1
+  std::vector<double> m_predictabilities;
+};
+
+void
+EpidemicProphetSessionTest::Sent (Ptr<const Packet> packet, Ptr<Ipv4> ipv4,
+                                  uint32_t interface)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != 17)
+    {
+      return;
+    }
+  UdpHeader udpHeader;
+  copy->RemoveHeader (udpHeader);
+  TypeHeader tHeader;
+  copy->RemoveHeader (tHeader);
+  if (udpHeader.GetDestinationPort () != RoutingProtocol::EPIDEMIC_PORT
+      || !tHeader.IsMessageType (TypeHeader::REPLY_BACK))
+    {
+      return;
+    }
+  SummaryVectorHeader vector;
+  copy->RemoveHeader (vector);
+  OptionHeader option;
+  while (copy->GetSize () >= option.GetSerializedSize ())
+    {
+      copy->RemoveHeader (option);
+      if (option.GetOptionType () != OptionHeader::PREDICTABILITY)
+        {
+          copy->RemoveAtStart (option.GetLength ());
+          continue;
+        }
+      PredictabilityHeader predictability;
+      copy->RemoveHeader (predictability);
+      for (PredictabilityList::const_iterator i =
+             predictability.GetEntries ().begin ();
+           i != predictability.GetEntries ().end (); ++i)
+        {
+          if (i->first == m_addresses[0])
+            {
+              m_predictabilities.push_back (i->second);
+            }
+        }
+    }
+}
+
+void
+EpidemicProphetSessionTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("ForwardingMode", StringValue ("Prophet"));
+  Setup (epidemic);
+  m_predictabilities.clear ();
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionStart", MakeCallback (&EpidemicProphetSessionTest::Started, this));
+  Ptr<Ipv4L3Protocol> l3 =
+    m_devices[1]->GetNode ()->GetObject<Ipv4L3Protocol> ();
+  l3->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&EpidemicProphetSessionTest::Sent, this));
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_predictabilities.size (), 2,
+                         "Checking the REPLY_BACK of the retransmission");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_predictabilities[0], 0.75, 1 / 255.0,
+                             "Checking the first encounter");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_predictabilities[1], 0.75, 1 / 255.0,
+                             "Checking that a retransmission is no encounter");
+  Release ();
+}
+
+/**
+ * Test of the expiry of decoders.  A generation that does not reach
+ * full rank before its packets expire is dropped, a later packet of
+ * the generation starts a new decoder.
+ */
+struct EpidemicDecoderExpiryTest : public EpidemicPairTest
+{
+  EpidemicDecoderExpiryTest ()
+    : EpidemicPairTest ("EpidemicDecoderExpiry")
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Pass a coded packet of a generation of two source symbols from the
+   * first node to the second.
+   * \param packetID the ID of the coded packet
+   * \param generationID the ID of the generation
+   * \param index the index of the source symbol carried by the packet
+   */
+  void Inject (uint32_t packetID, uint32_t generationID, uint32_t index);
+  /**
+   * Check the number of packets delivered to the second node.
+   * \param delivered the expected number
+   */
+  void CheckDelivered (uint32_t delivered)
+  {
+    NS_TEST_EXPECT_MSG_EQ (m_delivered[1], delivered,
+                           "Checking decoded packets at "
+                           << Simulator::Now ().GetSeconds ());
+  }
+};
+
+void
+EpidemicDecoderExpiryTest::Inject (uint32_t packetID, uint32_t generationID,
+                                   uint32_t index)
+{
+  // Source symbols are the size of the packet and its payload
+  uint8_t symbol[] = { 0, 4, 1, 2, 3, 4 };
+  symbol[2] += index;
+  std::vector<uint8_t> coefficients (2, 0);
+  coefficients[index] = 1;
+  Ptr<Packet> packet = Create<Packet> (symbol, sizeof (symbol));
+  packet->AddHeader (CodingHeader (generationID, sizeof (symbol),
+                                   coefficients));
+  EpidemicHeader eHeader;
+  eHeader.SetPacketID (packetID);
+  eHeader.SetHopCount (64);
+  eHeader.SetTimeStamp (Simulator::Now ());
+  eHeader.SetCoded ();
+  packet->AddHeader (eHeader);
+  Ipv4Header header;
+  header.SetSource (m_addresses[0]);
+  header.SetDestination (m_addresses[1]);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  header.SetPayloadSize (packet->GetSize ());
+  Receive (1, packet, header);
+}
+
+void
+EpidemicDecoderExpiryTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("QueueEntryExpireTime", TimeValue (Seconds (5)));
+  Setup (epidemic);
+  // The first generation is completed before its packets expire
+  Simulator::Schedule (Seconds (1), &EpidemicDecoderExpiryTest::Inject, this,
+                       0x01010002, 0x01010001, 0);
+  Simulator::Schedule (Seconds (3), &EpidemicDecoderExpiryTest::Inject, this,
+                       0x01010003, 0x01010001, 1);
+  Simulator::Schedule (Seconds (4), &EpidemicDecoderExpiryTest::CheckDelivered,
+                       this, 2);
+  // The decoder of the second generation expires at 6 s with one symbol
+  Simulator::Schedule (Seconds (1), &EpidemicDecoderExpiryTest::Inject, this,
+                       0x01010011, 0x01010010, 0);
+  Simulator::Schedule (Seconds (7), &EpidemicDecoderExpiryTest::Inject, this,
+                       0x01010012, 0x01010010, 1);
+  Simulator::Schedule (Seconds (7.5),
+                       &EpidemicDecoderExpiryTest::CheckDelivered, this, 2);
+  // The new decoder holds the second symbol only
+  Simulator::Schedule (Seconds (8), &EpidemicDecoderExpiryTest::Inject, this,
+                       0x01010013, 0x01010010, 0);
+  Simulator::Schedule (Seconds (8.5),
+                       &EpidemicDecoderExpiryTest::CheckDelivered, this, 4);
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+  Release ();
+}
+
+/**
+ * Test of the session limit of a node that answers more REPLYs than
+ * its limit.  Nodes 0 and 1 start a session with node 2 at its first
+ * beacon, node 2 answers one and the other once the first session ends.
+ */
+struct EpidemicSessionAnswerTest : public TestCase
+{
+  EpidemicSessionAnswerTest () : TestCase ("EpidemicSessionAnswer"),
+                                 m_maxActive (0),
+                                 m_maxPending (0),
+                                 m_answered (0)
+  {
+  }
+  virtual void DoRun ();
+  /// Record the sessions of node 2
+  void Sample ();
+  void Ended (Ipv4Address peer, bool complete)
+  {
+    if (peer == m_addresses[2] && complete)
+      {
+        m_answered++;
+      }
+  }
+  /// Routing protocols of the nodes
+  Ptr<RoutingProtocol> m_routing[3];
+  /// Addresses of the nodes
+  Ipv4Address m_addresses[3];
+  /// Largest number of active sessions of node 2
+  uint32_t m_maxActive;
+  /// Largest number of sessions waiting at node 2
+  uint32_t m_maxPending;
+  /// Number of sessions with node 2 completed by the other nodes
+  uint32_t m_answered;
+};
+
+void
+EpidemicSessionAnswerTest::Sample ()
+{
+  m_maxActive = std::max (m_maxActive, m_routing[2]->GetActiveSessionCount ());
+  m_maxPending = std::max (m_maxPending,
+                           m_routing[2]->GetPendingSessionCount ());
+  Simulator::Schedule (MilliSeconds (10), &EpidemicSessionAnswerTest::Sample,
+                       this);
+}
+
+void
+EpidemicSessionAnswerTest::DoRun ()
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  EpidemicHelper epidemic;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (epidemic);
+  internet.Install (nodes);
+  Ipv4AddressGenerator::Reset ();
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_routing[i] = DynamicCast<RoutingProtocol> (
+          nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+      m_addresses[i] = interfaces.GetAddress (i);
+      m_routing[i]->TraceConnectWithoutContext (
+        "SessionEnd", MakeCallback (&EpidemicSessionAnswerTest::Ended, this));
+    }
+  m_routing[2]->SetAttribute ("MaxSessions", UintegerValue (1));
+  Simulator::Schedule (Seconds (0), &EpidemicSessionAnswerTest::Sample, this);
+  // Before the next sessions, after HostRecentPeriod
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_maxActive, 1,
+                         "Checking that answered sessions are limited");
+  NS_TEST_EXPECT_MSG_EQ (m_maxPending, 1,
+                         "Checking that the second REPLY waits");
+  NS_TEST_EXPECT_MSG_EQ (m_answered, 2, "Checking that both are answered");
+  NS_TEST_EXPECT_MSG_EQ ((m_routing[2]->GetMaxSessionWaitTime ()
+                          .IsStrictlyPositive ()), true,
+                         "Checking the wait of the second session");
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_routing[i] = 0;
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * Test of the DELIVERED option.  A packet delivered to a node with a
+ * DeliveredWindow is not queued there, and is not sent again in the
+ * next session with its source.
+ */
+struct EpidemicDeliveredSessionTest : public EpidemicPairTest
+{
+  EpidemicDeliveredSessionTest ()
+    : EpidemicPairTest ("EpidemicDeliveredSession")
+  {
+  }
+  virtual void DoRun ();
+};
+
+void
+EpidemicDeliveredSessionTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("DeliveredWindow", UintegerValue (64));
+  Setup (epidemic);
+  Simulator::Schedule (Seconds (0.5), &EpidemicPairTest::Originate, this, 0,
+                       m_addresses[1], 100);
+  // Sessions start at the first beacon and after HostRecentPeriod
+  Simulator::Stop (Seconds (15));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1, "Checking the delivery");
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[0].size (), 1,
+                         "Checking that a delivered packet is sent once");
+  Release ();
+}
+
+/**
+ * Test of early session resumption.  A node holds a packet delivered to
+ * it, which it lists in its summary vector but never sends.  Its peer
+ * does not take the missing packet as a cut contact and waits for
+ * HostRecentPeriod before the next session.
+ */
+struct EpidemicSessionCutTest : public EpidemicPairTest
+{
+  EpidemicSessionCutTest () : EpidemicPairTest ("EpidemicSessionCut"),
+                              m_started (0),
+                              m_completed (0)
+  {
+  }
+  virtual void DoRun ();
+  /// Deliver to node 1 a packet of 10.1.1.9
+  void Store ();
+  void Started (Ipv4Address peer)
+  {
+    m_started++;
+  }
+  void Ended (Ipv4Address peer, bool complete)
+  {
+    m_completed += complete;
+  }
+  /// Number of sessions started by node 0
+  uint32_t m_started;
+  /// Number of sessions of node 0 that completed
+  uint32_t m_completed;
+};
+
+void
+EpidemicSessionCutTest::Store ()
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  EpidemicHeader eHeader;
+  eHeader.SetPacketID (0x01090001);
+  eHeader.SetHopCount (10);
+  eHeader.SetTimeStamp (Simulator::Now ());
+  packet->AddHeader (eHeader);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.1.9"));
+  header.SetDestination (m_addresses[1]);
+  header.SetProtocol (17);
+  header.SetTtl (64);
+  Receive (1, packet, header);
+}
+
+void
+EpidemicSessionCutTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("ResumeSessions", BooleanValue (true));
+  Setup (epidemic);
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionStart", MakeCallback (&EpidemicSessionCutTest::Started, this));
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionEnd", MakeCallback (&EpidemicSessionCutTest::Ended, this));
+  Simulator::Schedule (Seconds (0.5), &EpidemicSessionCutTest::Store, this);
+  // Beacons every second, the next regular session is after 10 s
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[1], 1, "Checking the stored packet");
+  NS_TEST_EXPECT_MSG_EQ (m_completed, 1, "Checking the first session");
+  NS_TEST_EXPECT_MSG_EQ (m_started, 1,
+                         "Checking that a completed session is not resumed");
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[1].size (), 0,
+                         "Checking that the stored packet is not sent");
+  Release ();
+}
+
+/**
+ * Test of a session resumed after a timeout.  Node 0 hears nothing
+ * during its second session with node 1, so the packet node 1 sends and
+ * its REPLY_BACK are lost, and the retransmitted REPLYs only trigger
+ * packets not sent yet.  The resumed session at the next beacon sends
+ * the lost packet again.
+ */
+struct EpidemicSessionResendTest : public EpidemicPairTest
+{
+  EpidemicSessionResendTest () : EpidemicPairTest ("EpidemicSessionResend"),
+                                 m_started (0)
+  {
+  }
+  virtual void DoRun ();
+  void Started (Ipv4Address peer)
+  {
+    if (++m_started == 2)
+      {
+        SetReceiving (0, false);
+        // The session fails after SessionRetries retransmissions
+        Simulator::Schedule (Seconds (3.5), &EpidemicPairTest::SetReceiving,
+                             this, 0, true);
+      }
+  }
+  /// Number of sessions started by node 0
+  uint32_t m_started;
+};
+
+void
+EpidemicSessionResendTest::DoRun ()
+{
+  EpidemicHelper epidemic;
+  epidemic.Set ("ResumeSessions", BooleanValue (true));
+  Setup (epidemic);
+  m_routing[0]->TraceConnectWithoutContext (
+    "SessionStart", MakeCallback (&EpidemicSessionResendTest::Started, this));
+  // After the first session, sent in the second one after 10 s
+  Simulator::Schedule (Seconds (2), &EpidemicPairTest::Originate, this, 1,
+                       m_addresses[0], 100);
+  // Before the third regular session
+  Simulator::Stop (Seconds (18));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_started, 3, "Checking the resumed session");
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded[1].size (), 2,
+                         "Checking that the lost packet is sent again");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[0], 1,
+                         "Checking that the lost packet is delivered");
+  Release ();
+}
 
 class EpidemicTestSuite : public TestSuite
 {
@@ -190,7 +3266,38 @@ EpidemicTestSuite::EpidemicTestSuite ()
   : TestSuite ("epidemic", UNIT)
 {
   AddTestCase (new EpidemicHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new EpidemicCompactHeaderTest, TestCase::QUICK);
   AddTestCase (new EpidemicRqueueTest, TestCase::QUICK);
+  AddTestCase (new EpidemicBeaconSchedulerTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionManagerTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionResumeTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionRetryTest, TestCase::QUICK);
+  AddTestCase (new EpidemicContactTimeTest, TestCase::QUICK);
+  AddTestCase (new EpidemicNetworkCodingTest, TestCase::QUICK);
+  AddTestCase (new EpidemicProphetTest, TestCase::QUICK);
+  AddTestCase (new EpidemicMaxPropTest, TestCase::QUICK);
+  AddTestCase (new EpidemicMaxPropQueueTest, TestCase::QUICK);
+  AddTestCase (new EpidemicLinkStateTest, TestCase::QUICK);
+  AddTestCase (new EpidemicDeliveredWindowTest, TestCase::QUICK);
+  AddTestCase (new EpidemicFuzzTest, TestCase::QUICK);
+  AddTestCase (new EpidemicIdSetTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSummaryVectorViewTest, TestCase::QUICK);
+  AddTestCase (new EpidemicQueueTraceTest, TestCase::QUICK);
+  AddTestCase (new EpidemicRouteInputCopyTest, TestCase::QUICK);
+  AddTestCase (new EpidemicAggregateTest, TestCase::QUICK);
+  AddTestCase (new EpidemicChunkTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSprayTest, TestCase::QUICK);
+  AddTestCase (new EpidemicTraceTest, TestCase::QUICK);
+  AddTestCase (new EpidemicOverhearTest, TestCase::QUICK);
+  AddTestCase (new EpidemicLinkLayerBeaconTest, TestCase::QUICK);
+  AddTestCase (new EpidemicNeighborRouteTest, TestCase::QUICK);
+  AddTestCase (new EpidemicRouteOutputTest, TestCase::QUICK);
+  AddTestCase (new EpidemicProphetSessionTest, TestCase::QUICK);
+  AddTestCase (new EpidemicDecoderExpiryTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionAnswerTest, TestCase::QUICK);
+  AddTestCase (new EpidemicDeliveredSessionTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionCutTest, TestCase::QUICK);
+  AddTestCase (new EpidemicSessionResendTest, TestCase::QUICK);
 }
 
 